@@ -128,6 +128,8 @@ int post_compilling_a_class(void){
 	}
 	class_structure=(int*)object;
 	check_object(num*2);
+	// The record may have been moved by check_object()
+	data=cmpdata_findfirst_with_id(CMPDATA_CLASS,g_class_id);
 	for(i=j=1;i<num;i++) {
 		// Check if not static field
 		if (data[i]&CLASS_STATIC) continue;
@@ -173,8 +175,9 @@ int post_compilling_classes(void){
 	cmpdata_reset();
 	num=0;
 	for(num=0;data=cmpdata_find(CMPDATA_CLASSNAME);num++){
+		i=data[0]&0xffff;
 		check_object(1);
-		(object++)[0]=data[0]&0xffff;
+		(object++)[0]=i;
 	}
 	check_object(1);
 	(object++)[0]=0;
@@ -589,13 +592,14 @@ int update_cmpdata_class(int data){
 	if (!olddata) return ERROR_UNKNOWN;
 	// Number of data in new record
 	num=(olddata[0]>>16)&0xff;
+	// Delete old record first, as it may be moved by cmpdata_insert()
+	// The data remains until cmpdata_compact()
+	cmpdata_delete(olddata);
 	// Create new recrd
 	e=cmpdata_insert(CMPDATA_CLASS,g_class_id,&olddata[1],num);
 	if (e) return e;
 	// Update last data
 	cmpdata_current_record()[num]=data;
-	// Delete old record
-	cmpdata_delete(olddata);
 	return 0;
 }
 
@@ -41,23 +41,181 @@
 		...
 		record[n]: end string
 	
+	CMPDATA_DELETED is a record deleted by cmpdata_delete()
+		type:      CMPDATA_DELETED
+		len:       same as the original record
+		data16:    used as a link when compacting
+	
+	The records are not moved when deleted. Instead, the type is changed to
+	CMPDATA_DELETED, and the area is recovered later by cmpdata_compact().
+	Only the records newer than the deleted one are moved by cmpdata_compact(),
+	same as shifting the data when deleting.
+*/
+
+/*
+	Index of records
+	While compiling, an index (open addressing hash table) is placed at the end
+	of kmbasic_object, above the CMPDATA area. cmpdata_init() reserves it by
+	lowering g_objmax. Each slot contains the position of a record as the number
+	of words from g_cmpdata_end (0: empty, 0xffff: removed).
+	Each record is registered with its type and id (data16). The record of the
+	type with string (see cmpdata_insert_string()) is also registered with its
+	type and hash value of the string.
+	When the index becomes full, CMPDATA_LINENUM records (one for each line)
+	are removed from the index, and linear search is used for this type.
+	The index is released by cmpdata_release_index() after compiling.
+	When the object area becomes full while compiling, the index is dropped by
+	cmpdata_drop_index() to make room, and linear search is used afterwards.
 */
 
+#define CMPDATA_INDEX_BITS 12
+#define CMPDATA_INDEX_SIZE (1<<CMPDATA_INDEX_BITS)
+#define CMPDATA_INDEX_LIMIT (CMPDATA_INDEX_SIZE*3/4)
+#define CMPDATA_INDEX_EMPTY 0x0000
+#define CMPDATA_INDEX_REMOVED 0xffff
+
+// Compact when deleted records use more than this number of words
+#define CMPDATA_COMPACT_WORDS 1024
+
 static int* g_cmpdata;
 static int* g_cmpdata_end;
 static int* g_cmpdata_point;
 static unsigned short g_cmpdata_id;
 
+static unsigned short* g_cmpdata_index;
+static char g_cmpdata_index_valid;
+static char g_cmpdata_index_linenum;
+static int g_cmpdata_index_used;
+static unsigned short g_cmpdata_num[256];
+static int* g_cmpdata_deleted;
+static int g_cmpdata_deleted_words;
+
+static void cmpdata_index_rebuild(void);
+
 /*
 	Initialize routine must be called when starting compiler.
 */
 void cmpdata_init(void){
+	int i;
+	g_cmpdata_index=0;
+	g_cmpdata_index_valid=0;
+	if ((int*)g_objmax-(int*)&kmbasic_object[0]<CMPDATA_INDEX_REMOVED) {
+		// Reserve the index area
+		g_objmax-=CMPDATA_INDEX_SIZE;
+		g_cmpdata_index=g_objmax;
+		for(i=0;i<CMPDATA_INDEX_SIZE;i++) g_cmpdata_index[i]=CMPDATA_INDEX_EMPTY;
+		g_cmpdata_index_valid=1;
+	}
+	g_cmpdata_index_linenum=1;
+	g_cmpdata_index_used=0;
+	for(i=0;i<256;i++) g_cmpdata_num[i]=0;
+	g_cmpdata_deleted=0;
+	g_cmpdata_deleted_words=0;
 	g_cmpdata=(int*)g_objmax;
 	g_cmpdata_end=(int*)g_objmax;
 	g_cmpdata_point=(int*)g_objmax;
 	g_cmpdata_id=ALLOC_BLOCK_NUM; // Avoid collision between id and variable number
 }
 
+/*
+	Index handling
+*/
+
+static int cmpdata_is_string_type(unsigned char type){
+	switch(type){
+		case CMPDATA_VARNAME:
+		case CMPDATA_LABELNAME:
+		case CMPDATA_CLASSNAME:
+		case CMPDATA_FIELDNAME:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static int cmpdata_is_indexed(unsigned char type){
+	if (!g_cmpdata_index_valid) return 0;
+	if (CMPDATA_LINENUM==type) return g_cmpdata_index_linenum;
+	// CMPDATA_CLASSLINE records aren't searched with id
+	if (CMPDATA_CLASSLINE==type) return 0;
+	return 1;
+}
+
+static int cmpdata_index_slot(unsigned char type, int key){
+	return ((unsigned int)((type<<16)^key)*0x9e3779b1)>>(32-CMPDATA_INDEX_BITS);
+}
+
+static void cmpdata_index_add(int slot, int* record){
+	while(CMPDATA_INDEX_EMPTY!=g_cmpdata_index[slot] && CMPDATA_INDEX_REMOVED!=g_cmpdata_index[slot]){
+		slot=(slot+1)&(CMPDATA_INDEX_SIZE-1);
+	}
+	if (CMPDATA_INDEX_EMPTY==g_cmpdata_index[slot]) g_cmpdata_index_used++;
+	g_cmpdata_index[slot]=g_cmpdata_end-record;
+}
+
+static void cmpdata_index_remove(int slot, int* record){
+	unsigned short pos=g_cmpdata_end-record;
+	while(CMPDATA_INDEX_EMPTY!=g_cmpdata_index[slot]){
+		if (pos==g_cmpdata_index[slot]) g_cmpdata_index[slot]=CMPDATA_INDEX_REMOVED;
+		slot=(slot+1)&(CMPDATA_INDEX_SIZE-1);
+	}
+}
+
+static void cmpdata_index_record(int* record){
+	unsigned char type=((unsigned int)record[0])>>24;
+	if (!cmpdata_is_indexed(type)) return;
+	if (CMPDATA_INDEX_LIMIT<=g_cmpdata_index_used) {
+		// Removed slots may be recovered by rebuilding. This record will be registered as well.
+		cmpdata_index_rebuild();
+		return;
+	}
+	cmpdata_index_add(cmpdata_index_slot(type,record[0]&0xffff),record);
+	if (cmpdata_is_string_type(type) && 2<=((record[0]>>16)&0xff)) {
+		cmpdata_index_add(cmpdata_index_slot(type,record[1]),record);
+	}
+}
+
+static void cmpdata_index_unrecord(int* record){
+	unsigned char type=((unsigned int)record[0])>>24;
+	if (!cmpdata_is_indexed(type)) return;
+	cmpdata_index_remove(cmpdata_index_slot(type,record[0]&0xffff),record);
+	if (cmpdata_is_string_type(type) && 2<=((record[0]>>16)&0xff)) {
+		cmpdata_index_remove(cmpdata_index_slot(type,record[1]),record);
+	}
+}
+
+static int cmpdata_index_rebuild_main(void){
+	int i;
+	int* data;
+	unsigned char type;
+	for(i=0;i<CMPDATA_INDEX_SIZE;i++) g_cmpdata_index[i]=CMPDATA_INDEX_EMPTY;
+	g_cmpdata_index_used=0;
+	for(data=g_cmpdata;data<g_cmpdata_end;data+=(data[0]>>16)&0xff){
+		type=((unsigned int)data[0])>>24;
+		if (CMPDATA_DELETED==type) continue;
+		if (!cmpdata_is_indexed(type)) continue;
+		if (CMPDATA_INDEX_LIMIT<=g_cmpdata_index_used) return 0;
+		cmpdata_index_add(cmpdata_index_slot(type,data[0]&0xffff),data);
+		if (cmpdata_is_string_type(type) && 2<=((data[0]>>16)&0xff)) {
+			cmpdata_index_add(cmpdata_index_slot(type,data[1]),data);
+		}
+	}
+	return 1;
+}
+
+static void cmpdata_index_rebuild(void){
+	if (!g_cmpdata_index) return;
+	g_cmpdata_index_valid=1;
+	// Leave enough room for the other records
+	g_cmpdata_index_linenum=g_cmpdata_num[CMPDATA_LINENUM]<CMPDATA_INDEX_LIMIT/2;
+	if (cmpdata_index_rebuild_main()) return;
+	// Too many records. Try without CMPDATA_LINENUM records.
+	g_cmpdata_index_linenum=0;
+	if (cmpdata_index_rebuild_main()) return;
+	// Give up using the index.
+	g_cmpdata_index_valid=0;
+}
+
 /*
 	Returns current record (g_cmpdata_point)
 */
@@ -92,7 +250,15 @@ void cmpdata_reset(void){
 		unsigned char num:  Length of above data array. If not required, set 0.
 */
 int cmpdata_insert(unsigned char type, short data16, int* data, unsigned char num){
-	unsigned int i;
+	int i;
+	// Check the room
+	if ((unsigned short*)(g_cmpdata-num-1)<object) {
+		// The data may be in a record, which is moved by dropping the index
+		i=(g_cmpdata<=data && data<g_cmpdata_end) ? g_cmpdata_end-data:0;
+		if (cmpdata_drop_index()) return ERROR_OBJ_TOO_LARGE;
+		if (i) data=g_cmpdata_end-i;
+		if ((unsigned short*)(g_cmpdata-num-1)<object) return ERROR_OBJ_TOO_LARGE;
+	}
 	// Check the type
 	if (CMPDATA_STRSTACK==type) {
 		// Store the new record in the end as stack
@@ -102,6 +268,8 @@ int cmpdata_insert(unsigned char type, short data16, int* data, unsigned char nu
 		for(i=0;(&g_cmpdata[i])<g_cmpdata_point;i++){
 			g_cmpdata[i-num-1]=g_cmpdata[i];
 		}
+		// Deleted records are shifted as well
+		if (g_cmpdata_deleted && g_cmpdata_deleted<g_cmpdata_point) g_cmpdata_deleted-=num+1;
 		g_cmpdata_point-=num+1;
 	} else {
 		// Store the new record in the beginning
@@ -109,7 +277,6 @@ int cmpdata_insert(unsigned char type, short data16, int* data, unsigned char nu
 	}
 	g_cmpdata-=num+1;
 	g_objmax=(unsigned short*)&g_cmpdata[0];
-	if (g_objmax<object) return ERROR_OBJ_TOO_LARGE;
 	// Store the new record at the position
 	g_cmpdata_point[0]=(type<<24)|(num+1)<<16|data16;
 	if (data) {
@@ -117,6 +284,13 @@ int cmpdata_insert(unsigned char type, short data16, int* data, unsigned char nu
 			g_cmpdata_point[i+1]=data[i];
 		}
 	}
+	g_cmpdata_num[type]++;
+	if (CMPDATA_STRSTACK==type) {
+		// The records were shifted
+		cmpdata_index_rebuild();
+	} else {
+		cmpdata_index_record(g_cmpdata_point);
+	}
 	return 0;
 }
 
@@ -132,9 +306,12 @@ int cmpdata_insert_string(unsigned char type, short data16, unsigned char* str,
 	unsigned char datanum=(num+8)>>2; // If length of str is 4, 3 integer data area is required (1 for hash, 2 for string)
 	unsigned char* datastr;
 	int i;
+	if ((unsigned short*)(g_cmpdata-datanum-1)<object) {
+		if (cmpdata_drop_index()) return ERROR_OBJ_TOO_LARGE;
+		if ((unsigned short*)(g_cmpdata-datanum-1)<object) return ERROR_OBJ_TOO_LARGE;
+	}
 	g_cmpdata-=datanum+1;
 	g_objmax=(unsigned short*)&g_cmpdata[0];
-	if (g_objmax<object) return ERROR_OBJ_TOO_LARGE;
 	g_cmpdata[0]=(type<<24)|(datanum+1)<<16|data16;
 	g_cmpdata[1]=cmpdata_nhash(str,num);
 	datastr=(unsigned char*)&g_cmpdata[2];
@@ -142,6 +319,8 @@ int cmpdata_insert_string(unsigned char type, short data16, unsigned char* str,
 		datastr[i]=str[i];
 	}
 	datastr[i]=0x00;
+	g_cmpdata_num[type]++;
+	cmpdata_index_record(g_cmpdata);
 	return 0;
 }
 
@@ -151,15 +330,22 @@ int cmpdata_insert_string(unsigned char type, short data16, unsigned char* str,
 */
 int* cmpdata_find(unsigned char type){
 	int* ret;
+	unsigned char rtype;
+	if (CMPDATA_ALL!=type && 0==g_cmpdata_num[type]) {
+		// There isn't any record of this type
+		g_cmpdata_point=g_cmpdata_end;
+		return 0;
+	}
 	while(g_cmpdata_point<g_cmpdata_end){
 		// Remember return value
 		ret=g_cmpdata_point;
 		// Move the point to next
 		g_cmpdata_point+=(ret[0]&0x00ff0000)>>16;
 		// Check if type is the same. If the same, return.
-		if ((ret[0]>>24)==type) return ret;
+		rtype=((unsigned int)ret[0])>>24;
+		if (rtype==type) return ret;
 		// If type is CMPDATA_ALL return
-		if (CMPDATA_ALL==type) return ret;
+		if (CMPDATA_ALL==type && CMPDATA_DELETED!=rtype) return ret;
 	}
 	return 0;
 }
@@ -175,6 +361,22 @@ int* cmpdata_findfirst(unsigned char type){
 
 int* cmpdata_findfirst_with_id(unsigned char type, unsigned short id){
 	int* data;
+	int* ret;
+	int slot;
+	if (cmpdata_is_indexed(type)) {
+		// Use the index. The newest record (nearest to g_cmpdata) will be returned.
+		ret=0;
+		for(slot=cmpdata_index_slot(type,id);CMPDATA_INDEX_EMPTY!=g_cmpdata_index[slot];slot=(slot+1)&(CMPDATA_INDEX_SIZE-1)){
+			if (CMPDATA_INDEX_REMOVED==g_cmpdata_index[slot]) continue;
+			data=g_cmpdata_end-g_cmpdata_index[slot];
+			if ((((unsigned int)data[0])>>24)!=type || (data[0]&0xffff)!=id) continue;
+			if (!ret || data<ret) ret=data;
+		}
+		// Set the point as the linear search does
+		if (ret) g_cmpdata_point=ret+((ret[0]>>16)&0xff);
+		else g_cmpdata_point=g_cmpdata_end;
+		return ret;
+	}
 	cmpdata_reset();
 	while(data=cmpdata_find(type)){
 		if ((data[0]&0xffff)==id) break;
@@ -184,20 +386,22 @@ int* cmpdata_findfirst_with_id(unsigned char type, unsigned short id){
 
 /*
 	Delete a record.
+	The area of deleted record will be recovered by cmpdata_compact().
 */
+static void cmpdata_delete_main(int* record){
+	unsigned char type=((unsigned int)record[0])>>24;
+	if (CMPDATA_DELETED==type) return;
+	cmpdata_index_unrecord(record);
+	g_cmpdata_num[type]--;
+	record[0]=(((unsigned int)CMPDATA_DELETED)<<24)|(record[0]&0x00ff0000);
+	g_cmpdata_deleted_words+=(record[0]>>16)&0xff;
+	if (g_cmpdata_deleted<record) g_cmpdata_deleted=record;
+}
+
 void cmpdata_delete(int* record){
-	int delnum;
-	int* data;
 	// Ignore if invalid record.
-	if (record<g_cmpdata || g_cmpdata_end<record) return;
-	// Get number of word to delete.
-	delnum=(record[0]&0x00ff0000)>>16;
-	// Delete record by shifting data.
-	for(data=record-1;g_cmpdata<=data;data--){
-	     data[delnum]=data[0];
-	}
-	g_cmpdata+=delnum;
-	g_objmax=(unsigned short*)&g_cmpdata[0];
+	if (record<g_cmpdata || g_cmpdata_end<=record) return;
+	cmpdata_delete_main(record);
 	// Reset
 	cmpdata_reset();
 }
@@ -208,36 +412,146 @@ void cmpdata_delete(int* record){
 void cmpdata_delete_all(unsigned char type){
 	int* data;
 	cmpdata_reset();
-	while(data=cmpdata_find(type)) cmpdata_delete(data);
+	while(data=cmpdata_find(type)) cmpdata_delete_main(data);
+	cmpdata_reset();
+}
+
+/*
+	Change the type of all records of a type
+*/
+void cmpdata_change_type(unsigned char type, unsigned char newtype){
+	int* data;
+	cmpdata_reset();
+	while(data=cmpdata_find(type)){
+		cmpdata_index_unrecord(data);
+		data[0]=(newtype<<24)|(data[0]&0x00ffffff);
+		g_cmpdata_num[type]--;
+		g_cmpdata_num[newtype]++;
+		cmpdata_index_record(data);
+	}
+	cmpdata_reset();
 }
 
 /*
 	Delete all records with invalid object positions.
 */
 void cmpdata_delete_invalid(void){
-	const static int const types[7]={
-		CMPDATA_GOTO_NUM_BL,
-		CMPDATA_GOTO_LABEL_BL,
-		CMPDATA_DATA_LABEL_BL,
-		CMPDATA_BREAK_BL,
-		CMPDATA_IF_BL,
-		CMPDATA_ENDIF_BL,
-		CMPDATA_CONTINUE,
-	};
-	int typenum;
+	int num;
+	int* data;
+	// Count the records to check
+	num=g_cmpdata_num[CMPDATA_GOTO_NUM_BL]+
+		g_cmpdata_num[CMPDATA_GOTO_LABEL_BL]+
+		g_cmpdata_num[CMPDATA_DATA_LABEL_BL]+
+		g_cmpdata_num[CMPDATA_BREAK_BL]+
+		g_cmpdata_num[CMPDATA_IF_BL]+
+		g_cmpdata_num[CMPDATA_ENDIF_BL]+
+		g_cmpdata_num[CMPDATA_CONTINUE];
+	for(data=g_cmpdata;num && data<g_cmpdata_end;data+=(data[0]>>16)&0xff){
+		switch(((unsigned int)data[0])>>24){
+			case CMPDATA_GOTO_NUM_BL:
+			case CMPDATA_GOTO_LABEL_BL:
+			case CMPDATA_DATA_LABEL_BL:
+			case CMPDATA_BREAK_BL:
+			case CMPDATA_IF_BL:
+			case CMPDATA_ENDIF_BL:
+			case CMPDATA_CONTINUE:
+				num--;
+				// Delete if invalid
+				if ((int)object<data[1]) cmpdata_delete_main(data);
+				break;
+			default:
+				break;
+		}
+	}
+	cmpdata_reset();
+}
+
+/*
+	Recover the area of deleted records.
+	The records newer than the oldest deleted record are moved toward g_cmpdata_end.
+	Call this only when no pointer to CMPDATA record is kept (i.e. beginning of a line).
+*/
+static void cmpdata_compact_main(void){
+	int* data;
+	int* prev;
+	int* next;
+	int* from;
+	int i,shift;
+	if (!g_cmpdata_deleted) return;
+	// Link the deleted records using data16 field
+	// The link shows the distance to the newer deleted record (0 if the newest)
+	prev=0;
+	for(data=g_cmpdata;data<=g_cmpdata_deleted;data+=(data[0]>>16)&0xff){
+		if (CMPDATA_DELETED!=((unsigned int)data[0])>>24) continue;
+		data[0]=(data[0]&0xffff0000)|(prev ? data-prev:0);
+		prev=data;
+	}
+	// Move the records from the oldest deleted one
+	shift=0;
+	for(data=g_cmpdata_deleted;data;data=next){
+		next=(data[0]&0xffff) ? data-(data[0]&0xffff):0;
+		shift+=(data[0]>>16)&0xff;
+		from=next ? next+((next[0]>>16)&0xff):g_cmpdata;
+		for(i=data-from-1;0<=i;i--) from[i+shift]=from[i];
+	}
+	g_cmpdata+=shift;
+	g_objmax=(unsigned short*)&g_cmpdata[0];
+	g_cmpdata_deleted=0;
+	g_cmpdata_deleted_words=0;
+	// Positions of moved records are changed
+	cmpdata_index_rebuild();
+	cmpdata_reset();
+}
+
+void cmpdata_compact(void){
+	if (g_cmpdata_deleted_words<CMPDATA_COMPACT_WORDS) {
+		// Compact also when the free area becomes small
+		if (g_cmpdata_deleted_words*8<(((int)g_objmax)-((int)object))>>2) return;
+	}
+	cmpdata_compact_main();
+}
+
+/*
+	Delete a record and all the older records of the same type, and recover the area.
+	Call this only when no pointer to CMPDATA record is kept, as cmpdata_compact().
+*/
+void cmpdata_delete_older(int* record){
+	unsigned char type=((unsigned int)record[0])>>24;
 	int* data;
-	for(typenum=0;typenum<(sizeof types/sizeof types[0]);typenum++){
-		do {
-			cmpdata_reset();
-			while(data=cmpdata_find(types[typenum])){
-				if ((int)object<data[1]) {
-					// This is invalid
-					cmpdata_delete(data);
-					break;
-				}
-			}
-		} while (data);
+	for(data=record;data<g_cmpdata_end;data+=(data[0]>>16)&0xff){
+		if ((((unsigned int)data[0])>>24)==type) cmpdata_delete_main(data);
 	}
+	cmpdata_compact_main();
+}
+
+/*
+	Drop the index to make room in the object area (see check_object()).
+	The records are moved to the end of CMPDATA area, so the pointers to them
+	are changed. Returns non-zero if the index has been dropped already.
+*/
+int cmpdata_drop_index(void){
+	int i;
+	int shift;
+	if (!g_cmpdata_index) return 1;
+	shift=CMPDATA_INDEX_SIZE/2;
+	for(i=g_cmpdata_end-g_cmpdata-1;0<=i;i--) g_cmpdata[i+shift]=g_cmpdata[i];
+	g_cmpdata+=shift;
+	g_cmpdata_end+=shift;
+	g_cmpdata_point+=shift;
+	if (g_cmpdata_deleted) g_cmpdata_deleted+=shift;
+	g_objmax=(unsigned short*)&g_cmpdata[0];
+	g_cmpdata_index=0;
+	g_cmpdata_index_valid=0;
+	return 0;
+}
+
+/*
+	Release the index after compiling.
+*/
+void cmpdata_release_index(void){
+	cmpdata_compact_main();
+	cmpdata_drop_index();
+	cmpdata_reset();
 }
 
 /*
@@ -262,24 +576,25 @@ int cmpdata_hash(unsigned char* str){
 /*
 	String search
 */
-int* cmpdata_nsearch_string(unsigned int type,unsigned char* str,int num){
+static int cmpdata_string_is(int* data,unsigned char* str,int num){
 	int i;
-	int* data;
 	unsigned char* strdata;
+	strdata=(unsigned char*)(&data[2]);
+	for(i=0;i<num;i++){
+		if (str[i]!=strdata[i]) return 0;
+	}
+	// Must end with null
+	return 0x00==strdata[i];
+}
+
+int* cmpdata_nsearch_string(unsigned int type,unsigned char* str,int num){
+	int* data;
 	int hash=cmpdata_nhash(str,num);
 	while(data=cmpdata_find(type)){
 		// Check the hash, first
 		if (hash!=data[1]) continue;
 		// Check the string
-		strdata=(unsigned char*)(&data[2]);
-		for(i=0;i<num;i++){
-			if (str[i]!=strdata[i]) break;
-		}
-		if (i<num) continue;
-		// Must end with null
-		if (0x00!=strdata[i]) continue;
-		// String is the same
-		return data;
+		if (cmpdata_string_is(data,str,num)) return data;
 	}
 	// Not found
 	return 0;
@@ -292,13 +607,34 @@ int* cmpdata_search_string(unsigned int type,unsigned char* str){
 }
 
 int* cmpdata_nsearch_string_first(unsigned int type,unsigned char* str,int num){
+	int* data;
+	int* ret;
+	int slot,hash;
+	if (cmpdata_is_string_type(type) && cmpdata_is_indexed(type)) {
+		// Use the index. The newest record (nearest to g_cmpdata) will be returned.
+		hash=cmpdata_nhash(str,num);
+		ret=0;
+		for(slot=cmpdata_index_slot(type,hash);CMPDATA_INDEX_EMPTY!=g_cmpdata_index[slot];slot=(slot+1)&(CMPDATA_INDEX_SIZE-1)){
+			if (CMPDATA_INDEX_REMOVED==g_cmpdata_index[slot]) continue;
+			data=g_cmpdata_end-g_cmpdata_index[slot];
+			if ((((unsigned int)data[0])>>24)!=type) continue;
+			if (((data[0]>>16)&0xff)<2 || hash!=data[1]) continue;
+			if (!cmpdata_string_is(data,str,num)) continue;
+			if (!ret || data<ret) ret=data;
+		}
+		// Set the point as the linear search does
+		if (ret) g_cmpdata_point=ret+((ret[0]>>16)&0xff);
+		else g_cmpdata_point=g_cmpdata_end;
+		return ret;
+	}
 	cmpdata_reset();
 	return cmpdata_nsearch_string(type,str,num);
 }
 
 int* cmpdata_search_string_first(unsigned int type,unsigned char* str){
-	cmpdata_reset();
-	return cmpdata_search_string(type,str);
+	int num;
+	for(num=0;str[num];num++);
+	return cmpdata_nsearch_string_first(type,str,num);
 }
 
 /*
@@ -14,7 +14,7 @@
 		R2: argument for function call
 		R3: argument for function call (library number)
 	R4-R7
-		R4: Not used yet
+		R4: counter of the innermost FOR loop (see for_r4_record() in statements.c)
 		R5: &kmbasic_variables[0], pointer to array containing variables values
 		R6: Pointer to array containing arguments etc ()
 			R6[0]: pointer to class object
@@ -41,23 +41,31 @@ void init_compiler(void){
 	g_objmax=&kmbasic_object[(sizeof kmbasic_object)/2];
 	// Initialize CMPDATA
 	cmpdata_init();
+	// Initialize peephole optimizer
+	peephole_reset();
 	// Initialize variable
 	variable_init();
 	// Start compiling non-class file
 	g_class_id=0;
+	// Line number table will be created after compiling
+	g_line_table_num=0;
 }
 
 int post_compile(void){
 	int e;
 	e=post_compilling_classes();
 	if (e) return e;
-	return 0;
+	// CMPDATA index isn't needed any more
+	cmpdata_release_index();
+	return create_line_table();
 }
 
 void begin_file_compiler(void){
 	// Initialize followings every file
 	g_ifdepth=0;
 	g_fordepth=0;
+	g_r4_varnum=-1;
+	g_r4_reload=0;
 	g_linenum=0;
 	g_error_linenum=0;
 	g_multiple_statement=0;
@@ -117,6 +125,7 @@ int end_file_compiler(void){
 void rewind_object(unsigned short* objpos){
 	object=objpos;
 	cmpdata_delete_invalid();
+	peephole_reset();
 }
 
 int check_if_reserved(char* str, int num){
@@ -227,11 +236,97 @@ int register_line_number(int id){
 	return cmpdata_insert(CMPDATA_LINENUM,id,(int*)g_scratch_int,1);
 }
 
+int* find_line_number(int id){
+	// CMPDATA_LINENUM records are of current file (see close_line_numbers())
+	return cmpdata_findfirst_with_id(CMPDATA_LINENUM,id);
+}
+
+int close_line_numbers(unsigned short class_id){
+	// A file has been compiled. Its CMPDATA_LINENUM records become CMPDATA_CLASSLINE records,
+	// followed by a CMPDATA_CLASSLINE record with the class id (see statements.c).
+	cmpdata_change_type(CMPDATA_LINENUM,CMPDATA_CLASSLINE);
+	return cmpdata_insert(CMPDATA_CLASSLINE,class_id,0,0);
+}
+
+/*
+	Line number table
+	All CMPDATA_CLASSLINE records are converted to a table placed in the object area
+	after compiling. The table is sorted by address, and used to find line number
+	from address when running.
+		g_line_table[n*2]:   address
+		g_line_table[n*2+1]: class id (upper 16 bits) and line number (lower 16 bits)
+	The class id is 0 for the main file.
+	The records are moved to the table from the oldest one, and the area of moved
+	records is recovered for the next ones. So, the table doesn't need more room than
+	the records.
+*/
+
+int create_line_table(void){
+	int* data;
+	int* last;
+	int i,j,k,num,addr,info,class_id;
+	// The lines of the main file as well as the class files
+	i=close_line_numbers(0);
+	if (i) return i;
+	// Count the lines
+	cmpdata_reset();
+	for(num=0;data=cmpdata_find(CMPDATA_CLASSLINE);){
+		if (2==((data[0]>>16)&0xff)) num++;
+	}
+	// Align object
+	if (((int)object)&0x02) {
+		check_object(1);
+		object++;
+	}
+	g_line_table=(int*)object;
+	for(i=0;i<num;i+=k){
+		// Number of entries to move this time
+		k=((int*)g_objmax-&g_line_table[i*2])/2;
+		if (k<=0) return ERROR_OBJ_TOO_LARGE;
+		if (num-i<k) k=num-i;
+		// Fill the table from the oldest record. Note that newer record comes first.
+		// j is the position of record in table, and the records after i+k are skipped.
+		j=num;
+		class_id=0;
+		cmpdata_reset();
+		while(data=cmpdata_find(CMPDATA_CLASSLINE)){
+			if (1==((data[0]>>16)&0xff)) {
+				// Class id of the following records
+				class_id=data[0]&0xffff;
+				continue;
+			}
+			j--;
+			if (i+k<=j) continue;
+			if (i+k-1==j) last=data;
+			g_line_table[j*2]=data[1];
+			g_line_table[j*2+1]=(class_id<<16)|(data[0]&0xffff);
+			if (i==j) break;
+		}
+		// The records moved to the table won't be needed any more
+		cmpdata_delete_older(last);
+	}
+	object+=num*4;
+	// The records are usually in order of address. Sort just in case.
+	for(i=1;i<num;i++){
+		addr=g_line_table[i*2];
+		if (g_line_table[i*2-2]<=addr) continue;
+		info=g_line_table[i*2+1];
+		for(j=i;0<j && addr<g_line_table[j*2-2];j--){
+			g_line_table[j*2]=g_line_table[j*2-2];
+			g_line_table[j*2+1]=g_line_table[j*2-1];
+		}
+		g_line_table[j*2]=addr;
+		g_line_table[j*2+1]=info;
+	}
+	g_line_table_num=num;
+	// The other CMPDATA_CLASSLINE records won't be needed any more
+	cmpdata_delete_all(CMPDATA_CLASSLINE);
+	return 0;
+}
+
 int handle_line_number(int id){
-	int e;
 	int* data;
 	short* bl;
-	if (e) return e;
 	// Resolve all CMPDATA_GOTO_NUM_BL(s)
 	while(data=cmpdata_findfirst_with_id(CMPDATA_GOTO_NUM_BL,id)){
 		// Found a CMPDATA_GOTO_NUM_BL
@@ -241,8 +336,9 @@ int handle_line_number(int id){
 		// Delete the cmpdata record
 		cmpdata_delete(data);
 	}
-	// All done
-	return 0;
+	// R4 may not be the counter of FOR loop when jumped here from other loop.
+	// This line may also be the destination of GOTO/GOSUB by a value (see lib_line_num()).
+	return reload_r4();
 }
 
 /* 
@@ -254,6 +350,7 @@ int compile_line(unsigned char* code){
 	unsigned char* before;
 	// Initialize
 	g_linenum++;
+	cmpdata_compact();
 	before=source=code2upper(code);
 	// Get line number if exists
 	if (g_multiple_statement) e=ERROR_OTHERS;
@@ -285,6 +382,11 @@ int compile_line(unsigned char* code){
 	if (0x00!=source[0]) while(1){
 		e=compile_statement();
 		if (e) break; // An error occured
+		// R4 must be reloaded if the address of FOR loop counter was taken (see for_r4_address())
+		if (g_r4_reload && !g_multiple_statement) {
+			e=reload_r4();
+			if (e) break;
+		}
 		// Skip blank
 		skip_blank();
 		// Check null as the end of line
@@ -301,6 +301,8 @@
 #define CMPDATA_CLASS_ADDRESS 0x10
 #define CMPDATA_STATIC        0x11
 #define CMPDATA_DATA_LABEL_BL 0x12
+#define CMPDATA_CLASSLINE     0x13
+#define CMPDATA_DELETED       0xFE
 #define CMPDATA_ALL           0xFF
 
 /*
@@ -318,6 +320,12 @@
 #define VAR_MODE_STRING  1
 #define VAR_MODE_FLOAT   2
 
+#define PEEPHOLE_CONSTANT 1
+#define PEEPHOLE_VARIABLE 2
+
+#define FOR_R4_CLEAR_SIZE 0x00010000
+#define FOR_R4_ADDRESS    0x00020000
+
 #define ARG_NONE    0
 #define ARG_INTEGER 1
 #define ARG_FLOAT   2
@@ -371,6 +379,8 @@ extern int g_sdepth;
 extern int g_maxsdepth;
 extern short g_ifdepth;
 extern short g_fordepth;
+extern short g_r4_varnum;
+extern char g_r4_reload;
 
 extern volatile char g_scratch[32];
 extern volatile int* g_scratch_int;
@@ -378,8 +388,8 @@ extern volatile short* g_scratch_short;
 extern volatile float* g_scratch_float;
 extern volatile char* g_scratch_char;
 
-extern const char* const g_reserved_words[189];
-extern const int const g_hash_resereved_words[189];
+extern const char* const g_reserved_words[199];
+extern const int const g_hash_resereved_words[199];
 
 extern char g_constant_value_flag;
 extern int g_constant_int;
@@ -404,6 +414,9 @@ extern int* g_empty_object_list;
 extern char g_before_classcode;
 extern char g_after_classcode;
 
+extern int* g_line_table;
+extern int g_line_table_num;
+
 extern char g_disable_printf;
 extern char g_disable_lcd_out;
 extern char g_disable_debugwait2500;
@@ -431,12 +444,16 @@ short get_new_varnum(void);
 int get_var_number(void);
 int r0_to_variable(int vn);
 int variable_to_r0(int vn);
+int reload_r4(void);
 
 // compiler.c
 void init_compiler(void);
 int post_compile(void);
 void begin_file_compiler(void);
 int end_file_compiler(void);
+int* find_line_number(int id);
+int close_line_numbers(unsigned short class_id);
+int create_line_table(void);
 void rewind_object(unsigned short* objpos);
 int check_if_reserved(char* str, int num);
 void update_bl(short* bl,short* destination);
@@ -468,6 +485,11 @@ int post_gosub_statement(int i);
 int compile_statement(void);
 int end_of_statement(void);
 int restore_statement(void);
+int* for_r4_record(int depth);
+void for_r4_update(void);
+int for_r4_assigned(int vn);
+void for_r4_address(int vn);
+int for_r4_goto(void);
 
 // withoutkeyboard.c
 // withkeyboard.c
@@ -511,6 +533,17 @@ int end_of_value(void);
 int get_operator(int vmode);
 int calculation(int op,int vmode);
 
+// peephole.c
+extern char g_disable_peephole;
+void peephole_reset(void);
+void peephole_simple_value(unsigned short* begin, char type, int value);
+int peephole_constant_to_r0(int value);
+int peephole_is_simple_value(unsigned short* begin);
+int peephole_r0_to_r1(unsigned short* pos);
+int peephole_constant_operand(int min, int max);
+void peephole_compare(unsigned short* begin, int op, unsigned short code);
+int peephole_branch(unsigned short branch);
+
 // function.c
 int argn_function(int lib,int mode);
 int args_function(void);
@@ -529,7 +562,12 @@ int* cmpdata_findfirst(unsigned char type);
 int* cmpdata_findfirst_with_id(unsigned char type, unsigned short id);
 void cmpdata_delete(int* record);
 void cmpdata_delete_all(unsigned char type);
+void cmpdata_delete_older(int* record);
+void cmpdata_change_type(unsigned char type, unsigned char newtype);
 void cmpdata_delete_invalid(void);
+void cmpdata_compact(void);
+void cmpdata_release_index(void);
+int cmpdata_drop_index(void);
 int* cmpdata_nsearch_string(unsigned int type,unsigned char* str,int num);
 int* cmpdata_search_string(unsigned int type,unsigned char* str);
 int* cmpdata_nsearch_string_first(unsigned int type,unsigned char* str,int num);
@@ -541,6 +579,7 @@ void cmpdata_delete_string_stack(unsigned char* str);
 
 // error.c
 int show_error(int e, int pos);
+int* line_info_from_address(int addr);
 int line_number_from_address(int addr);
 void stop_with_error(int e);
 
@@ -705,9 +744,12 @@ void blink_led(int num);
 	} while(0)
 
 // Check object area remaining
+// The CMPDATA index is dropped when needed, and the CMPDATA records are moved (see cmpdata.c)
 #define check_object(size) \
 	do {\
-		if (g_objmax<=&object[size]) return ERROR_OBJ_TOO_LARGE;\
+		if (g_objmax<=&object[size]) {\
+			if (cmpdata_drop_index() || g_objmax<=&object[size]) return ERROR_OBJ_TOO_LARGE;\
+		}\
 	} while(0)
 
 // Operator priority
@@ -58,6 +58,13 @@ int lib_display(int r0, int r1, int r2){
 		ppcg=0;
 		prevx1=0;
 		prevy1=0;
+		// Draw on and display the first graphic page
+		g_drawpage(0);
+		g_displaypage(0);
+		// Hide all sprites
+		g_spritereset();
+		// Show graphic instead of tile map
+		g_tilemode(0);
 		return r0;
 	} else if (0==r2) {
 		// Return the static data
@@ -77,7 +84,7 @@ int lib_display(int r0, int r1, int r2){
 		}
 	}
 	// Set x1,y1,x2,y2 for graphic
-	if (DISPLAY_USE_STACK & (1<<r2)) {
+	if (r2<64 && (DISPLAY_USE_STACK & (1ull<<r2))) {
 		// r1 is a pointer to stack
 		x1=sp[0];
 		y1=sp[1];
@@ -129,6 +136,7 @@ int lib_display(int r0, int r1, int r2){
 			ppcg[sp[0]*8+5]=r0>>16;
 			ppcg[sp[0]*8+6]=r0>>8;
 			ppcg[sp[0]*8+7]=r0;
+			pcg_sync();
 			break;
 		case DISPLAY_USEPCG:
 			// void startPCG(unsigned char *p,int a);
@@ -289,15 +297,7 @@ int lib_display(int r0, int r1, int r2){
 					break;
 				case 2:
 					// clear palette
-					for(i=0;i<8;i++){
-						set_palette(i,255*(i&1),255*((i>>1)&1),255*(i>>2));
-					}
-					for(i=0;i<8;i++){
-						set_palette(i+8,128*(i&1),128*((i>>1)&1),128*(i>>2));
-					}
-					for(i=16;i<256;i++){
-						set_palette(i,255,255,255);
-					}
+					init_palette();
 					// clear graphic display
 					cls();
 					g_clearscreen();
@@ -316,6 +316,73 @@ int lib_display(int r0, int r1, int r2){
 				if (j==palette[i]) return i;
 			}
 			return 0-j;
+		case DISPLAY_GPAGE:
+			//GPAGE d,s
+			g_drawpage(r1);
+			g_displaypage(r0);
+			break;
+		case DISPLAY_GFLIP:
+			//GFLIP
+			g_flip();
+			break;
+		case DISPLAY_GCOPY:
+			//void g_copy(int x1,int y1,int w,int h,int x2,int y2);
+			//GCOPY x1,y1,x2,y2,x3,y3
+			// Coordinates may be negative (x1,y1,x2,y2 are unsigned)
+			if ((int)x2<(int)x1) { i=x1; x1=x2; x2=i; }
+			if ((int)y2<(int)y1) { i=y1; y1=y2; y2=i; }
+			g_copy(x1,y1,x2-x1+1,y2-y1+1,sp[4],r0);
+			break;
+		case DISPLAY_SPRITE:
+			//void g_spritemove(unsigned char n,int x,int y);
+			//SPRITE n,x,y
+			if (sp[0]<0 || SPRITE_NUM<=sp[0]) break;
+			g_spritemove(sp[0],sp[1],r0);
+			break;
+		case DISPLAY_SPRITEDEF2:
+			// Label is used. Get CREAD() point
+			r0=(int)seek_data(0x4636);
+			// Now, r0 is the address of bmp data
+			// Continue to following main code
+		case DISPLAY_SPRITEDEF:
+			//SPRITEDEF n,w,h,bbb
+			// Pattern of sprite n is placed at n*SPRITE_MAX_SIZE*SPRITE_MAX_SIZE in pattern RAM
+			if (sp[0]<0 || SPRITE_NUM<=sp[0]) break;
+			i=sp[0]*SPRITE_MAX_SIZE*SPRITE_MAX_SIZE;
+			if (sp[1]<=0 || SPRITE_MAX_SIZE<sp[1] || sp[2]<=0 || SPRITE_MAX_SIZE<sp[2]) {
+				// Hide the sprite
+				g_spritedefine(sp[0],0,0,0,i);
+				break;
+			}
+			g_spritepattern(i,sp[1]*sp[2],(unsigned char*)r0);
+			g_spritedefine(sp[0],sp[1],sp[2],0,i);
+			break;
+		case DISPLAY_TILEMODE:
+			//TILEMODE m
+			g_tilemode(r0);
+			break;
+		case DISPLAY_TILEDEF2:
+			// Label is used. Get CREAD() point
+			r0=(int)seek_data(0x4636);
+			// Now, r0 is the address of bmp data
+			// Continue to following main code
+		case DISPLAY_TILEDEF:
+			//TILEDEF n,bbb
+			if (r1<0 || TILE_NUM<=r1) break;
+			g_tiledefine(r1,(unsigned char*)r0);
+			break;
+		case DISPLAY_TILE:
+			//TILE x,y,n
+			g_tileput(sp[0],sp[1],r0);
+			break;
+		case DISPLAY_TILESCROLL:
+			//TILESCROLL x,y
+			g_tilescroll(r1,r0);
+			break;
+		case DISPLAY_LINESCROLL:
+			//LINESCROLL y1,y2,x
+			g_linescroll(sp[0],sp[1],r0);
+			break;
 		default:
 			break;
 	}
@@ -561,6 +628,123 @@ int usegraphic_statement(void){
 		DISPLAY_USEGRAPHIC<<LIBOPTION);
 }
 
+int gpage_statement(void){
+	// GPAGE d,s
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		DISPLAY_GPAGE<<LIBOPTION);
+}
+
+int gflip_statement(void){
+	// GFLIP
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_NONE | 
+		DISPLAY_GFLIP<<LIBOPTION);
+}
+
+int gcopy_statement(void){
+	// GCOPY x1,y1,x2,y2,x3,y3
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		ARG_INTEGER<<ARG3 | 
+		ARG_INTEGER<<ARG4 | 
+		ARG_INTEGER<<ARG5 | 
+		ARG_INTEGER<<ARG6 | 
+		DISPLAY_GCOPY<<LIBOPTION);
+}
+
+int sprite_statement(void){
+	// SPRITE n,x,y
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		ARG_INTEGER<<ARG3 | 
+		DISPLAY_SPRITE<<LIBOPTION);
+}
+
+int spritedef_statement(void){
+	// SPRITEDEF n,w,h,bbb
+	int e;
+	unsigned char* sbefore=source;
+	unsigned short* obefore=object;
+	// bbb may be label
+	g_callback_args[4]=putbmp_callback;
+	e=argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		ARG_INTEGER<<ARG3 | 
+		ARG_CALLBACK<<ARG4 | 
+		DISPLAY_SPRITEDEF2<<LIBOPTION);
+	if (0==e) return 0;
+	// Rewind source and object
+	source=sbefore;
+	rewind_object(obefore);
+	// bbb must be pointer
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		ARG_INTEGER<<ARG3 | 
+		ARG_INTEGER<<ARG4 | 
+		DISPLAY_SPRITEDEF<<LIBOPTION);
+}
+
+int tilemode_statement(void){
+	// TILEMODE m
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		DISPLAY_TILEMODE<<LIBOPTION);
+}
+
+int tiledef_statement(void){
+	// TILEDEF n,bbb
+	int e;
+	unsigned char* sbefore=source;
+	unsigned short* obefore=object;
+	// bbb may be label
+	g_callback_args[2]=putbmp_callback;
+	e=argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_CALLBACK<<ARG2 | 
+		DISPLAY_TILEDEF2<<LIBOPTION);
+	if (0==e) return 0;
+	// Rewind source and object
+	source=sbefore;
+	rewind_object(obefore);
+	// bbb must be pointer
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		DISPLAY_TILEDEF<<LIBOPTION);
+}
+
+int tile_statement(void){
+	// TILE x,y,n
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		ARG_INTEGER<<ARG3 | 
+		DISPLAY_TILE<<LIBOPTION);
+}
+
+int tilescroll_statement(void){
+	// TILESCROLL x,y
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		DISPLAY_TILESCROLL<<LIBOPTION);
+}
+
+int linescroll_statement(void){
+	// LINESCROLL y1,y2,x
+	return argn_function(LIB_DISPLAY_FUNCTION,
+		ARG_INTEGER<<ARG1 | 
+		ARG_INTEGER<<ARG2 | 
+		ARG_INTEGER<<ARG3 | 
+		DISPLAY_LINESCROLL<<LIBOPTION);
+}
+
 int tvram_function(void){
 	// TVRAM([x])
 	g_default_args[1]=-1;
@@ -587,15 +771,25 @@ int display_statements(void){
 	if (instruction_is("CURSOR")) return cursor_statement();
 	if (instruction_is("GCLS")) return gcls_statement();
 	if (instruction_is("GCOLOR")) return gcolor_statement();
+	if (instruction_is("GCOPY")) return gcopy_statement();
+	if (instruction_is("GFLIP")) return gflip_statement();
+	if (instruction_is("GPAGE")) return gpage_statement();
 	if (instruction_is("GPALETTE")) return gpalette_statement();
 	if (instruction_is("GPRINT")) return gprint_statement();
 	if (instruction_is("LINE")) return line_statement();
+	if (instruction_is("LINESCROLL")) return linescroll_statement();
 	if (instruction_is("PALETTE")) return palette_statement();
 	if (instruction_is("PCG")) return pcg_statement();
 	if (instruction_is("POINT")) return point_statement();
 	if (instruction_is("PSET")) return pset_statement();
 	if (instruction_is("PUTBMP")) return putbmp_statement();
 	if (instruction_is("SCROLL")) return scroll_statement();
+	if (instruction_is("SPRITE")) return sprite_statement();
+	if (instruction_is("SPRITEDEF")) return spritedef_statement();
+	if (instruction_is("TILE")) return tile_statement();
+	if (instruction_is("TILEDEF")) return tiledef_statement();
+	if (instruction_is("TILEMODE")) return tilemode_statement();
+	if (instruction_is("TILESCROLL")) return tilescroll_statement();
 	if (instruction_is("USEGRAPHIC")) return usegraphic_statement();
 	if (instruction_is("USEPCG")) return usepcg_statement();
 	if (instruction_is("WIDTH")) return width_statement();
@@ -29,19 +29,37 @@
 #define DISPLAY_PUTBMP2 22
 #define DISPLAY_USEGRAPHIC 23
 #define DISPLAY_GCOLOR_FUNC 24
+#define DISPLAY_GPAGE 25
+#define DISPLAY_GFLIP 26
+#define DISPLAY_SPRITE 27
+#define DISPLAY_SPRITEDEF 28
+#define DISPLAY_SPRITEDEF2 29
+#define DISPLAY_TILE 30
+#define DISPLAY_LINESCROLL 31
+#define DISPLAY_TILEMODE 32
+#define DISPLAY_TILESCROLL 33
+#define DISPLAY_TILEDEF 34
+#define DISPLAY_TILEDEF2 35
+#define DISPLAY_GCOPY 36
 #define DISPLAY_USE_STACK (\
-	(1<<DISPLAY_BGCOLOR) |\
-	(1<<DISPLAY_PALETTE) |\
-	(1<<DISPLAY_PCG) |\
-	(1<<DISPLAY_BOXFILL) |\
-	(1<<DISPLAY_CIRCLE) |\
-	(1<<DISPLAY_CIRCLEFILL) |\
-	(1<<DISPLAY_GPALETTE) |\
-	(1<<DISPLAY_GPRINT) |\
-	(1<<DISPLAY_LINE) |\
-	(1<<DISPLAY_PUTBMP) |\
-	(1<<DISPLAY_PUTBMP2) |\
-	(1<<DISPLAY_PSET) )
+	(1ull<<DISPLAY_BGCOLOR) |\
+	(1ull<<DISPLAY_PALETTE) |\
+	(1ull<<DISPLAY_PCG) |\
+	(1ull<<DISPLAY_BOXFILL) |\
+	(1ull<<DISPLAY_CIRCLE) |\
+	(1ull<<DISPLAY_CIRCLEFILL) |\
+	(1ull<<DISPLAY_GPALETTE) |\
+	(1ull<<DISPLAY_GPRINT) |\
+	(1ull<<DISPLAY_LINE) |\
+	(1ull<<DISPLAY_PUTBMP) |\
+	(1ull<<DISPLAY_PUTBMP2) |\
+	(1ull<<DISPLAY_SPRITE) |\
+	(1ull<<DISPLAY_SPRITEDEF) |\
+	(1ull<<DISPLAY_SPRITEDEF2) |\
+	(1ull<<DISPLAY_TILE) |\
+	(1ull<<DISPLAY_LINESCROLL) |\
+	(1ull<<DISPLAY_GCOPY) |\
+	(1ull<<DISPLAY_PSET) )
 
 void display_init(void);
 int display_statements(void);
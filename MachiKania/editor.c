@@ -519,10 +519,11 @@ void redraw(){
 	int ix,ix1,ix2;
 	int x,y;
 	unsigned char ch,cl;
-	unsigned char written;
+	int y1,y2; //書き換えた最初と最後の行
 
 	vp=TVRAM;
-	written=0;
+	y1=-1;
+	y2=-1;
 	bp=disptopbp;
 	ix=disptopix;
 	cl=COLOR_NORMALTEXT;
@@ -570,7 +571,8 @@ void redraw(){
 			if(*vp!=ch || *(vp+ATTROFFSET)!=cl){
 				*vp=ch;
 				*(vp+ATTROFFSET)=cl;
-				written=1;
+				if(y1<0) y1=y;
+				y2=y;
 			}
 			vp++;
 		}
@@ -579,7 +581,8 @@ void redraw(){
 			if(*vp!=0 || *(vp+ATTROFFSET)!=0){
 				*vp=0;
 				*(vp+ATTROFFSET)=0;
-				written=1;
+				if(y1<0) y1=y;
+				y2=y;
 			}
 			vp++;
 		}
@@ -590,12 +593,13 @@ void redraw(){
 			if(*vp!=0 || *(vp+ATTROFFSET)!=0){
 				*vp=0;
 				*(vp+ATTROFFSET)=0;
-				written=1;
+				if(y1<0) y1=y;
+				y2=y;
 			}
 			vp++;
 		}
 	}
-	if(written) textredraw(); //液晶に出力
+	if(y1>=0) textredraw_rect(0,y1,WIDTH_X,y2-y1+1); //書き換えた行のみ液晶に出力
 }
 
 //カーソルを1つ前に移動
@@ -1630,7 +1634,7 @@ int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 							cursor--;
 						}
 						while(cursor>=TVRAM+WIDTH_X) *cursor--=' ';
-						textredraw();
+						textredraw_rect(0,1,WIDTH_X,WIDTH_Y-2);
 						top-=mx;
 						for(int i=0;i<mx;i++){
 							printfilename(i*13+1,1,top+i,num_dir);
@@ -1654,7 +1658,7 @@ int select_dir_file(int filenum,int num_dir, unsigned char* msg){
 							cursor++;
 						}
 						while(cursor<TVRAM+ATTROFFSET-WIDTH_X) *cursor++=' ';
-						textredraw();
+						textredraw_rect(0,1,WIDTH_X,WIDTH_Y-2);
 						top+=mx;
 						f2=f-(f+2)%mx;
 						for(int i=0;i<mx;i++){
@@ -76,8 +76,33 @@ int throw_error(int e,int line, char* file){
 	return e;
 }
 
+/*
+	Find the entry of line number table (see create_line_table())
+	Returns the pointer to entry, or 0 if not found.
+*/
+int* line_info_from_address(int addr){
+	int left,right,mid;
+	// Find the last entry with address <= addr
+	left=0;
+	right=g_line_table_num;
+	while(left<right){
+		mid=(left+right)>>1;
+		if (addr<g_line_table[mid*2]) right=mid;
+		else left=mid+1;
+	}
+	if (!left) return 0;
+	return &g_line_table[left*2-2];
+}
+
 int line_number_from_address(int addr){
 	int* data;
+	if (g_line_table_num) {
+		// Use line number table after compiling
+		data=line_info_from_address(addr);
+		if (!data) return -1;
+		return data[1]&0xffff;
+	}
+	// Compiling. Use CMPDATA_LINENUM records.
 	cmpdata_reset();
 	while(data=cmpdata_find(CMPDATA_LINENUM)){
 		if (addr<data[1]) continue;
@@ -99,15 +124,22 @@ void stop_with_error(int e){
 		printint(e);
 	}
 	// Show line number
-	e=line_number_from_address(kmbasic_data[3]);
-	if (e<0) {
+	data=line_info_from_address(kmbasic_data[3]);
+	if (!data) {
 		// Line number not found
 		printstr(" at ");
 		printhex32(kmbasic_data[3]);
 		printstr("\n");
 	} else {
 		printstr(" in line ");
-		printint(e);
+		printint(data[1]&0xffff);
+		// Show class name if not in main file
+		if (data[1]>>16) data=cmpdata_findfirst_with_id(CMPDATA_CLASSNAME,data[1]>>16);
+		else data=0;
+		if (data) {
+			printstr(" of ");
+			printstr((char*)&data[2]);
+		}
 		printstr("\n");
 	}
 	// End BASIC program
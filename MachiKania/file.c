@@ -117,7 +117,7 @@ int compile_file(unsigned char* fname, char isclass){
 			// Compiling a class is needed.
 			// Close current file, first
 			f_close(fp);
-			// Delete all CMPDATA_LINENUM as these will be registered later
+			// Delete all CMPDATA_LINENUM (of this file) as these will be registered later
 			cmpdata_delete_all(CMPDATA_LINENUM);
 			// Insert a BL instruction to skip class code
 			bl=object;
@@ -127,6 +127,8 @@ int compile_file(unsigned char* fname, char isclass){
 			classfile=g_class_file;
 			e=compile_file(classfile,1);
 			if (e) return e;
+			e=close_line_numbers(g_class_id);
+			if (e) return e;
 			e=post_compilling_a_class();
 			if (e) return e;
 			// BL jump destination is here
@@ -77,6 +77,7 @@ int float_functions(void){
 
 int get_simple_float(void){
 	int i,vn;
+	unsigned short* obefore;
 	unsigned char* err;
 	float f;
 	skip_blank();
@@ -100,7 +101,7 @@ int get_simple_float(void){
 		source+=i;
 		g_scratch_float[0]=f;
 		g_constant_float=f;
-		return set_value_in_register(0,g_scratch_int[0]);
+		return peephole_constant_to_r0(g_scratch_int[0]);
 	} else if ('A'<=source[0] && source[0]<='Z' || '_'==source[0]) {
 		// Lower constant flag
 		g_constant_value_flag=0;
@@ -115,8 +116,11 @@ int get_simple_float(void){
 		}
 		if (0<=vn) {
 			// Get variable value
+			obefore=object;
 			i=variable_to_r0(vn);
 			if (i) return i;
+			// This code will be invalid if an array or an object follows (see peephole.c)
+			peephole_simple_value(obefore,PEEPHOLE_VARIABLE,vn);
 			// Check if an object
 			if ('.'==source[0]) {
 				source++;
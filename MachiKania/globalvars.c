@@ -52,6 +52,11 @@ int g_maxsdepth;
 short g_ifdepth;
 short g_fordepth;
 
+// Variable number of FOR loop counter kept in R4 (-1 if none)
+// and the flag to reload R4 after every statement
+short g_r4_varnum;
+char g_r4_reload;
+
 // Scratch variable
 volatile char g_scratch[32];
 volatile int* g_scratch_int=(volatile int*)&g_scratch[0];
@@ -89,6 +94,11 @@ int* g_empty_object_list;
 char g_before_classcode;
 char g_after_classcode;
 
+// Line number table (see create_line_table())
+
+int* g_line_table;
+int g_line_table_num;
+
 // printf() ON/OFF, LCD out ON/OFF
 
 char g_disable_printf=0;
@@ -120,7 +130,7 @@ unsigned int g_wait_for_keyboard=2000;
 
 // Reserved words
 
-const char* const g_reserved_words[189]={
+const char* const g_reserved_words[199]={
 	"ABS",
 	"ACOS",
 	"ALIGN4",
@@ -190,10 +200,13 @@ const char* const g_reserved_words[189]={
 	"FUNCADDRESS",
 	"GCLS",
 	"GCOLOR",
+	"GCOPY",
 	"GETDIR",
 	"GETTIME",
+	"GFLIP",
 	"GOSUB",
 	"GOTO",
+	"GPAGE",
 	"GPALETTE",
 	"GPRINT",
 	"HEX",
@@ -219,6 +232,7 @@ const char* const g_reserved_words[189]={
 	"LEN",
 	"LET",
 	"LINE",
+	"LINESCROLL",
 	"LOG",
 	"LOG10",
 	"LOOP",
@@ -275,6 +289,8 @@ const char* const g_reserved_words[189]={
 	"SPIWRITE",
 	"SPIWRITEDATA",
 	"SPRINTF",
+	"SPRITE",
+	"SPRITEDEF",
 	"SQRT",
 	"STATIC",
 	"STEP",
@@ -292,6 +308,10 @@ const char* const g_reserved_words[189]={
 	"TCPSERVER",
 	"TCPSTATUS",
 	"THEN",
+	"TILE",
+	"TILEDEF",
+	"TILEMODE",
+	"TILESCROLL",
 	"TIMER",
 	"TLSCLIENT",
 	"TO",
@@ -311,7 +331,7 @@ const char* const g_reserved_words[189]={
 	"WIDTH",
 	"WIFIERR",
 };
-const int const g_hash_resereved_words[189]={
+const int const g_hash_resereved_words[199]={
 	0x000400d3, //ABS
 	0x01002393, //ACOS
 	0x0d2063a4, //ALIGN4
@@ -381,10 +401,13 @@ const int const g_hash_resereved_words[189]={
 	0x0fbcbca9, //FUNCADDRESS
 	0x01182353, //GCLS
 	0x8238d383, //GCOLOR
+	0x4608e459, //GCOPY
 	0x84545203, //GETDIR
 	0xeaab78a4, //GETTIME
+	0x461cd210, //GFLIP
 	0x46392502, //GOSUB
 	0x0118e54f, //GOTO
+	0x46440185, //GPAGE
 	0x0d1043aa, //GPALETTE
 	0x914c83c5, //GPRINT
 	0x00049118, //HEX
@@ -410,6 +433,7 @@ const int const g_hash_resereved_words[189]={
 	0x0004d10e, //LEN
 	0x0004d114, //LET
 	0x013483c5, //LINE
+	0x9104d0f7, //LINESCROLL
 	0x0004d387, //LOG
 	0x4d387c70, //LOG10
 	0x0134e390, //LOOP
@@ -466,6 +490,8 @@ const int const g_hash_resereved_words[189]={
 	0x164dc3a8, //SPIWRITE
 	0xa901b8bd, //SPIWRITEDATA
 	0xacdf0fa2, //SPRINTF
+	0x914c8551, //SPRITE
+	0xeabe1434, //SPRITEDEF
 	0x014904d4, //SQRT
 	0x95015217, //STATIC
 	0x01495110, //STEP
@@ -483,6 +509,10 @@ const int const g_hash_resereved_words[189]={
 	0x841877f9, //TCPSERVER
 	0x955453f8, //TCPSTATUS
 	0x0154910e, //THEN
+	0x01548345, //TILE
+	0x0d105454, //TILEDEF
+	0x4431b5c6, //TILEMODE
+	0x9704d708, //TILESCROLL
 	0x5520c112, //TIMER
 	0x728a8934, //TLSCLIENT
 	0x0000154f, //TO
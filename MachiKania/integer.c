@@ -243,6 +243,7 @@ int get_positive_decimal_value(void){
 
 int get_simple_integer(void){
 	int i,vn;
+	unsigned short* obefore;
 	skip_blank();
 	if ('+'==source[0]) {
 		source++;
@@ -271,13 +272,13 @@ int get_simple_integer(void){
 			}
 		}
 		g_constant_int=i;
-		return set_value_in_register(0,i);
+		return peephole_constant_to_r0(i);
 	} else if ('0'<=source[0] && source[0]<='9') {
 		// Decimal value
 		i=get_positive_decimal_value();
 		if (i<0) return i;
 		g_constant_int=i;
-		return set_value_in_register(0,i);
+		return peephole_constant_to_r0(i);
 	} else if ('A'<=source[0] && source[0]<='Z' || '_'==source[0]) {
 		// Lower constant flag
 		g_constant_value_flag=0;
@@ -292,8 +293,11 @@ int get_simple_integer(void){
 		}
 		if (0<=vn) {
 			// Get variable value
+			obefore=object;
 			i=variable_to_r0(vn);
 			if (i) return i;
+			// This code will be invalid if an array or an object follows (see peephole.c)
+			peephole_simple_value(obefore,PEEPHOLE_VARIABLE,vn);
 			// Check if an array
 			if ('('==source[0]) {
 				source++;
@@ -330,6 +334,8 @@ int get_simple_integer(void){
 		(object++)[0]=0x0080;      // lsls	r0, r0, #2
 		(object++)[0]=0x1940;      // adds	r0, r0, r5
 		g_constant_value_flag=0;
+		// The variable may be FOR loop counter kept in R4
+		for_r4_address(vn);
 		return 0;
 	}
 	return ERROR_SYNTAX;
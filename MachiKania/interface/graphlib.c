@@ -21,12 +21,18 @@ caused by using this program.
 //LCDテキスト・グラフィックライブラリ
 
 #include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "parallel.pio.h"
 #include "graphlib.h"
 #include "LCDdriver.h"
 #include "../config.h"
 
 unsigned char TVRAM[ATTROFFSET*2+1] __attribute__ ((aligned (4)));
 unsigned char *fontp; //フォント格納アドレス、初期化時はFontData、RAM指定することでPCGを実現
+static unsigned char g_ntsc_pcg[8*256]; //スレーブ側PCGの内容の写し（差分のみ送信するため）
 unsigned int bgcolor; // バックグランドカラー
 //unsigned char twidth; //テキスト1行文字数
 unsigned char *cursor;
@@ -42,6 +48,7 @@ int WIDTH_Y; // 縦方向文字数
 	GP11: MOSI, /WR
 	GP13: MOSI, /RD
 	GP12: MISO, /BUSY (GP27 for test by MachiKania)
+	GP15: MISO, /VSYNC (L for a line at the beginning of vertical blanking)
 	
 	Communication sequence (write to slave)
 	
@@ -53,7 +60,7 @@ int WIDTH_Y; // 縦方向文字数
 		Master waits until /BUSY to L, then set /WR to H
 		Master set data lines to input mode and restart interruption
 		Slave waits until /WR to H, then start the job
-		Slave set /BUSY to L after finishing the job
+		Slave set /BUSY to H after finishing the job
 	
 	Communication sequence (read from slave)
 	
@@ -72,6 +79,7 @@ int WIDTH_Y; // 縦方向文字数
 #define PARALLEL_RD_PIN   13
 #define PARALLEL_BUSY_PIN 12
 #define PARALLEL_RESET_PIN 14
+#define PARALLEL_VSYNC_PIN 15
 #define PARALLEL_DATA_MASK 0xff
 
 #define COMMAND_NOP			   0x80
@@ -84,6 +92,131 @@ int WIDTH_Y; // 縦方向文字数
 #define COMMAND_CLS			   0x96
 #define COMMAND_SET_PALETTE    0x97
 #define COMMAND_TEXTREDRAW     0x98
+#define COMMAND_SCROLL_UP      0x99
+#define COMMAND_SCROLL_DOWN    0x9A
+#define COMMAND_WINDOW_SCROLL  0x9B
+#define COMMAND_SET_PALETTE_RANGE 0x9C
+#define COMMAND_WRITE_TVRAM_RECT  0x9D
+#define COMMAND_TEXTREDRAW_RLE 0x9E
+#define COMMAND_G_PSET         0xA0
+#define COMMAND_G_GLINE        0xA1
+#define COMMAND_G_HLINE        0xA2
+#define COMMAND_G_BOXFILL      0xA3
+#define COMMAND_G_CIRCLE       0xA4
+#define COMMAND_G_CIRCLEFILL   0xA5
+#define COMMAND_G_PUTBMPMN     0xA6
+#define COMMAND_G_CLRBMPMN     0xA7
+#define COMMAND_G_PUTFONT      0xA8
+#define COMMAND_G_PRINTSTR     0xA9
+#define COMMAND_G_CLEARSCREEN  0xAA
+#define COMMAND_G_DRAWPAGE     0xAB
+#define COMMAND_G_DISPLAYPAGE  0xAC
+#define COMMAND_G_FLIP         0xAD
+#define COMMAND_SPRITE_PATTERN 0xAE
+#define COMMAND_SPRITE_DEFINE  0xAF
+#define COMMAND_SPRITE_MOVE    0xB0
+#define COMMAND_SPRITE_RESET   0xB1
+#define COMMAND_TILE_MODE      0xB2
+#define COMMAND_TILE_PATTERN   0xB3
+#define COMMAND_TILE_MAP       0xB4
+#define COMMAND_TILE_SCROLL    0xB5
+#define COMMAND_LINE_SCROLL    0xB6
+#define COMMAND_READ_PIXEL     0xB7
+#define COMMAND_READ_TVRAM     0xB8
+#define COMMAND_READ_STATUS    0xB9
+#define COMMAND_RESET_STATUS   0xBA
+#define COMMAND_USE_PCG        0xBB
+#define COMMAND_PCG_DEFINE     0xBC
+#define COMMAND_PCG_RESET      0xBD
+#define COMMAND_BLIT_PATTERN   0xBE
+#define COMMAND_G_COPY         0xBF
+#define COMMAND_G_FILL         0xC0
+#define COMMAND_G_BLIT         0xC1
+#define COMMAND_G_GET          0xC2
+#define COMMAND_G_PALETTE_BANK 0xC3
+
+/*
+	Data are sent by PIO state machine (see parallel.pio).
+	parallel_send_command() and parallel_send_data() put the data in the ring
+	buffer and return immediately. DMA transfers the ring buffer to TX FIFO
+	of the state machine. Use parallel_flush() when the data must reach the
+	slave before the next job (e.g. reading data from the slave).
+*/
+
+#define PARALLEL_PIO pio0
+#define PARALLEL_RING_BITS 8
+#define PARALLEL_RING_SIZE (1<<PARALLEL_RING_BITS)
+#define PARALLEL_RING_MASK (PARALLEL_RING_SIZE-1)
+
+static unsigned int g_parallel_ring[PARALLEL_RING_SIZE] __attribute__ ((aligned (PARALLEL_RING_SIZE*4)));
+static volatile unsigned short g_parallel_ring_head; // Next position to write
+static volatile unsigned short g_parallel_ring_tail; // Next position to start DMA
+static unsigned int g_parallel_sm;
+static unsigned int g_parallel_offset;
+static unsigned int g_parallel_dma;
+
+static void parallel_kick(void){
+	// Start DMA for the data written after the previous DMA
+	// Call this when interruption is disabled
+	int n;
+	if (dma_channel_is_busy(g_parallel_dma)) return;
+	n=(g_parallel_ring_head-g_parallel_ring_tail)&PARALLEL_RING_MASK;
+	if (0==n) return;
+	dma_channel_set_read_addr(g_parallel_dma,&g_parallel_ring[g_parallel_ring_tail],false);
+	dma_channel_set_trans_count(g_parallel_dma,n,true);
+	g_parallel_ring_tail=(g_parallel_ring_tail+n)&PARALLEL_RING_MASK;
+}
+
+static void parallel_dma_irq_handler(void){
+	// DMA finished. Start the next one if available
+	dma_hw->ints1=1u<<g_parallel_dma;
+	parallel_kick();
+}
+
+static void parallel_pio_init(void){
+	int i;
+	pio_sm_config c;
+	// PIO state machine
+	g_parallel_offset=pio_add_program(PARALLEL_PIO,&parallel_master_program);
+	g_parallel_sm=pio_claim_unused_sm(PARALLEL_PIO,true);
+	for(i=0;i<8;i++) pio_gpio_init(PARALLEL_PIO,i);
+	pio_gpio_init(PARALLEL_PIO,PARALLEL_DC_PIN);
+	pio_gpio_init(PARALLEL_PIO,PARALLEL_WR_PIN);
+	pio_sm_set_pins_with_mask(PARALLEL_PIO,g_parallel_sm,
+		(1<<PARALLEL_DC_PIN)|(1<<PARALLEL_WR_PIN),
+		(1<<PARALLEL_DC_PIN)|(1<<PARALLEL_WR_PIN));
+	pio_sm_set_pindirs_with_mask(PARALLEL_PIO,g_parallel_sm,
+		PARALLEL_DATA_MASK|(1<<PARALLEL_DC_PIN)|(1<<PARALLEL_WR_PIN),
+		PARALLEL_DATA_MASK|(1<<PARALLEL_DC_PIN)|(1<<PARALLEL_WR_PIN));
+	c=parallel_master_program_get_default_config(g_parallel_offset);
+	sm_config_set_out_pins(&c,0,PARALLEL_DC_PIN+1);
+	sm_config_set_sideset_pins(&c,PARALLEL_WR_PIN);
+	sm_config_set_in_pins(&c,PARALLEL_BUSY_PIN);
+	sm_config_set_out_shift(&c,true,false,32);
+	sm_config_set_fifo_join(&c,PIO_FIFO_JOIN_TX);
+	pio_sm_init(PARALLEL_PIO,g_parallel_sm,g_parallel_offset,&c);
+	pio_sm_set_enabled(PARALLEL_PIO,g_parallel_sm,true);
+	// DMA from ring buffer to TX FIFO
+	g_parallel_ring_head=g_parallel_ring_tail=0;
+	g_parallel_dma=dma_claim_unused_channel(true);
+	dma_channel_config dc=dma_channel_get_default_config(g_parallel_dma);
+	channel_config_set_transfer_data_size(&dc,DMA_SIZE_32);
+	channel_config_set_read_increment(&dc,true);
+	channel_config_set_write_increment(&dc,false);
+	channel_config_set_ring(&dc,false,PARALLEL_RING_BITS+2);
+	channel_config_set_dreq(&dc,pio_get_dreq(PARALLEL_PIO,g_parallel_sm,true));
+	dma_channel_configure(
+		g_parallel_dma,
+		&dc,
+		&PARALLEL_PIO->txf[g_parallel_sm],
+		g_parallel_ring,
+		0,
+		false
+	);
+	dma_channel_set_irq1_enabled(g_parallel_dma,true);
+	irq_set_exclusive_handler(DMA_IRQ_1,parallel_dma_irq_handler);
+	irq_set_enabled(DMA_IRQ_1,true);
+}
 
 void parallel_init(void){
 	int i;
@@ -117,40 +250,146 @@ void parallel_init(void){
 	gpio_init(PARALLEL_RESET_PIN);
 	gpio_set_dir(PARALLEL_RESET_PIN, GPIO_IN);
 	gpio_pull_up(PARALLEL_RESET_PIN);
+	// Init /VSYNC pin
+	// This pin is SPI TX of LCD, which display_init() connects after timer_init()
+	// calls parallel_vsync_init(). The edge IRQ set by parallel_vsync_init() remains.
+	gpio_init(PARALLEL_VSYNC_PIN);
+	gpio_set_dir(PARALLEL_VSYNC_PIN, GPIO_IN);
+	gpio_pull_up(PARALLEL_VSYNC_PIN);
+	// Data, DC, and /WR pins will be controlled by PIO
+	parallel_pio_init();
 }
 
-void parallel_send_main(unsigned char dat){
-	// Wait until /BUSY will be H
-	while(!gpio_get(PARALLEL_BUSY_PIN));
-	// Show the data to data line
-	gpio_set_dir_out_masked(PARALLEL_DATA_MASK);
-	gpio_put_masked(PARALLEL_DATA_MASK,dat);
-	// Set /WR to L
-	gpio_put(PARALLEL_WR_PIN,0);
-	// Wait until /BUSY will be L
-	while(gpio_get(PARALLEL_BUSY_PIN));
-	// Set /WR to H
-	gpio_put(PARALLEL_WR_PIN,1);
-	// Set data line to input mode
-	gpio_set_dir_in_masked(PARALLEL_DATA_MASK);
+void parallel_send_main(unsigned int dat){
+	// This may be called by interruption (e.g. INTERRUPT statement of BASIC),
+	// so the ring buffer is updated while interruption is disabled
+	unsigned int rd,s;
+	while(true){
+		s=save_and_disable_interrupts();
+		if (dma_channel_is_busy(g_parallel_dma)) {
+			rd=((dma_channel_hw_addr(g_parallel_dma)->read_addr-(unsigned int)g_parallel_ring)>>2)&PARALLEL_RING_MASK;
+		} else {
+			rd=g_parallel_ring_tail;
+		}
+		if ((rd-g_parallel_ring_head-1)&PARALLEL_RING_MASK) break;
+		// The ring buffer is full. Start DMA here, as the IRQ handler
+		// may not be called while this runs in an interruption
+		parallel_kick();
+		restore_interrupts(s);
+	}
+	// Write to the ring buffer
+	g_parallel_ring[g_parallel_ring_head]=dat;
+	g_parallel_ring_head=(g_parallel_ring_head+1)&PARALLEL_RING_MASK;
+	// Start DMA if not running
+	parallel_kick();
+	restore_interrupts(s);
+}
+
+/*
+	Text queue
+	Characters sent by printchar() are queued here, and sent as one
+	COMMAND_PRINTSTR (or as single characters when it is shorter).
+	CURSOR and COLOR are not sent until a character is printed; only
+	the difference from the state of the slave is sent at that time.
+	The queue is sent when it is full, before any other command, by
+	parallel_flush(), and by textqueue_flush() (input wait, drawcount).
+	printchar() may also be called by interruption (PRINT in INTERRUPT of
+	BASIC), so the queue is only used while interruption is disabled.
+	Otherwise, a command could be sent in the middle of COMMAND_PRINTSTR.
+*/
+
+#define TEXTQUEUE_SIZE 64
+
+static unsigned char g_textqueue[TEXTQUEUE_SIZE];
+static volatile int g_textqueue_num;
+static unsigned char* g_ntsc_cursor; // Cursor position of slave
+static unsigned char g_ntsc_cursorcolor=7; // Cursor color of slave
+
+void parallel_send_command(unsigned char com);
+void parallel_send_data(unsigned char dat);
+void parallel_send_short(int dat);
+
+static void textqueue_send(void){
+	// Send all characters in the queue
+	// Call this when interruption is disabled
+	int i,n,single;
+	n=g_textqueue_num;
+	if (0==n) return;
+	g_textqueue_num=0;
+	// Determine which way is shorter
+	single=0;
+	for(i=0;i<n;i++) single+=g_textqueue[i]<0x80 ? 1:2;
+	if (n+2<single) {
+		parallel_send_command(COMMAND_PRINTSTR);
+		for(i=0;i<n;i++) parallel_send_data(g_textqueue[i]);
+		parallel_send_data(0);
+	} else {
+		for(i=0;i<n;i++){
+			if (g_textqueue[i]<0x80) {
+				parallel_send_command(g_textqueue[i]);
+			} else {
+				parallel_send_command(COMMAND_PRINTCHAR);
+				parallel_send_data(g_textqueue[i]);
+			}
+		}
+	}
+}
+
+void textqueue_flush(void){
+	// Send all characters in the queue
+	unsigned int s=save_and_disable_interrupts();
+	textqueue_send();
+	restore_interrupts(s);
 }
 
 void parallel_send_command(unsigned char com){
-	// Command mode
-	gpio_put(PARALLEL_DC_PIN,1);
-	// Send command
-	parallel_send_main(com);
+	unsigned int s=save_and_disable_interrupts();
+	// Queued characters must be sent before the command
+	if (g_textqueue_num) textqueue_send();
+	// Command mode (DC=H)
+	parallel_send_main(com|(1<<PARALLEL_DC_PIN));
+	restore_interrupts(s);
 }
 
 void parallel_send_data(unsigned char dat){
-	// Data mode
-	gpio_put(PARALLEL_DC_PIN,0);
-	// Send data
+	// Data mode (DC=L)
 	parallel_send_main(dat);
 }
 
+static void parallel_wait_sent(void){
+	// Wait until all data in the ring buffer are received by the slave
+	// This also works when interruption is disabled
+	while(g_parallel_ring_head!=g_parallel_ring_tail || dma_channel_is_busy(g_parallel_dma)) {
+		if (!dma_channel_is_busy(g_parallel_dma)) {
+			unsigned int s=save_and_disable_interrupts();
+			parallel_kick();
+			restore_interrupts(s);
+		}
+	}
+	while(!pio_sm_is_tx_fifo_empty(PARALLEL_PIO,g_parallel_sm));
+	// The state machine stalls at "pull" after /BUSY becomes L
+	while(pio_sm_get_pc(PARALLEL_PIO,g_parallel_sm)!=g_parallel_offset);
+}
+
+void parallel_flush(void){
+	// Send the queued characters first
+	textqueue_flush();
+	parallel_wait_sent();
+}
+
 unsigned char parallel_receive_data(void){
+	int i;
+	unsigned int s;
 	unsigned char dat;
+	// Send the queued characters first
+	textqueue_flush();
+	// Interruption (that may send data) is disabled while data lines are input mode
+	s=save_and_disable_interrupts();
+	// All data must be sent before reading
+	parallel_wait_sent();
+	// Data lines are input mode by SIO while reading
+	for(i=0;i<8;i++) gpio_set_function(i,GPIO_FUNC_SIO);
+	gpio_set_dir_in_masked(PARALLEL_DATA_MASK);
 	// Wait until /BUSY will be H
 	while(!gpio_get(PARALLEL_BUSY_PIN));
 	// Set /RD to L
@@ -161,9 +400,71 @@ unsigned char parallel_receive_data(void){
 	dat=gpio_get_all() & PARALLEL_DATA_MASK;
 	// Set /RD to H
 	gpio_put(PARALLEL_RD_PIN,1);
+	// Wait until /BUSY will be H (the slave stops driving data lines)
+	while(!gpio_get(PARALLEL_BUSY_PIN));
+	// Return data lines to PIO
+	for(i=0;i<8;i++) pio_gpio_init(PARALLEL_PIO,i);
+	restore_interrupts(s);
+	return dat;
+}
+
+static void (*g_vsync_callback)(void);
+
+static void parallel_vsync_irq(uint gpio, uint32_t events){
+	if (PARALLEL_VSYNC_PIN==gpio && g_vsync_callback) g_vsync_callback();
+}
+
+void parallel_vsync_init(void (*callback)(void)){
+	// callback() will be called at the falling edge of /VSYNC (59.94 Hz)
+	g_vsync_callback=callback;
+	gpio_init(PARALLEL_VSYNC_PIN);
+	gpio_set_dir(PARALLEL_VSYNC_PIN, GPIO_IN);
+	gpio_pull_up(PARALLEL_VSYNC_PIN);
+	gpio_set_irq_enabled_with_callback(PARALLEL_VSYNC_PIN,GPIO_IRQ_EDGE_FALL,true,parallel_vsync_irq);
+}
+
+unsigned char parallel_read_tvram(int pos){
+	// Read TVRAM[pos] of the slave
+	// The whole transaction is done while interruption is disabled, as a
+	// read by interruption between the command and /RD makes the slave
+	// discard the data of this read
+	unsigned int s;
+	unsigned char dat;
+	s=save_and_disable_interrupts();
+	parallel_send_command(COMMAND_READ_TVRAM);
+	parallel_send_short(pos);
+	dat=parallel_receive_data();
+	restore_interrupts(s);
 	return dat;
 }
 
+unsigned int parallel_read_status(unsigned char n){
+	// Read status of the slave (see NTSC_STATUS_xxx)
+	// See parallel_read_tvram() for disabling interruption
+	int i;
+	unsigned int v,s;
+	s=save_and_disable_interrupts();
+	parallel_send_command(COMMAND_READ_STATUS);
+	parallel_send_data(n);
+	v=0;
+	for(i=0;i<4;i++) v|=parallel_receive_data()<<(i*8);
+	restore_interrupts(s);
+	return v;
+}
+
+void parallel_reset_status(void){
+	// Reset the maximum values and counters of the status of the slave
+	parallel_send_command(COMMAND_RESET_STATUS);
+}
+
+void parallel_send_short(int dat){
+	// Send 16 bit signed integer (little endian)
+	if (dat<-32768) dat=-32768;
+	if (32767<dat) dat=32767;
+	parallel_send_data(dat);
+	parallel_send_data(dat>>8);
+}
+
 /*
 	Main graphlib routines follow
 */
@@ -171,6 +472,8 @@ unsigned char parallel_receive_data(void){
 void set_palette(unsigned char n,unsigned char b,unsigned char r,unsigned char g){
 //テキスト／グラフィック共用カラーパレット設定
 	//palette[n]=((r>>3)<<11)+((g>>2)<<5)+(b>>3);
+	// NTSC版ではグラフィックはパレット番号で管理する
+	palette[n]=n;
 	parallel_send_command(COMMAND_SET_PALETTE);
 	parallel_send_data(n);
 	parallel_send_data(b);
@@ -178,10 +481,34 @@ void set_palette(unsigned char n,unsigned char b,unsigned char r,unsigned char g
 	parallel_send_data(g);
 }
 
+static void set_palette_range_header(unsigned char n,int num){
+// パレットn～n+num-1の一括設定開始、続けてb,r,gをnum組送信する
+	int i;
+	for(i=0;i<num;i++) palette[(n+i)&255]=(n+i)&255;
+	parallel_send_command(COMMAND_SET_PALETTE_RANGE);
+	parallel_send_short(num);
+	parallel_send_data(n);
+}
+
+void set_palette_range(unsigned char n,int num,const unsigned char *bgr){
+//カラーパレットn～n+num-1を一括設定
+//bgr：b,r,gの順にnum組（set_palette()と同じ順）
+	int i;
+	if(num<=0) return;
+	if(256-n<num) num=256-n;
+	set_palette_range_header(n,num);
+	for(i=0;i<num*3;i++) parallel_send_data(bgr[i]);
+}
+
 void g_pset(int x,int y,unsigned char c)
 // (x,y)の位置にカラーパレット番号cで点を描画
 {
-
+	if((unsigned int)x>=X_RES) return;
+	if((unsigned int)y>=Y_RES) return;
+	parallel_send_command(COMMAND_G_PSET);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_data(c);
 }
 
 void g_putbmpmn(int x,int y,unsigned short m,unsigned short n,const unsigned char bmp[])
@@ -189,42 +516,77 @@ void g_putbmpmn(int x,int y,unsigned short m,unsigned short n,const unsigned cha
 // unsigned char bmp[m*n]配列に、単純にカラー番号を並べる
 // カラー番号が0の部分は透明色として扱う
 {
-
+	int i;
+	if(x<=-m || x>=X_RES || y<=-n || y>=Y_RES) return; //画面外
+	parallel_send_command(COMMAND_G_PUTBMPMN);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_short(m);
+	parallel_send_short(n);
+	for(i=0;i<m*n;i++) parallel_send_data(bmp[i]);
 }
 
 // 縦m*横nドットのキャラクター消去
 // カラー0で塗りつぶし
 void g_clrbmpmn(int x,int y,unsigned short m,unsigned short n)
 {
-
+	if(x<=-m || x>=X_RES || y<=-n || y>=Y_RES) return; //画面外
+	parallel_send_command(COMMAND_G_CLRBMPMN);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_short(m);
+	parallel_send_short(n);
 }
 
 void g_gline(int x1,int y1,int x2,int y2,unsigned char c)
 // (x1,y1)-(x2,y2)にカラーパレット番号cで線分を描画
 {
-
+	parallel_send_command(COMMAND_G_GLINE);
+	parallel_send_short(x1);
+	parallel_send_short(y1);
+	parallel_send_short(x2);
+	parallel_send_short(y2);
+	parallel_send_data(c);
 }
 
 void g_hline(int x1,int x2,int y,unsigned char c)
 // (x1,y)-(x2,y)への水平ラインを高速描画
 {
-
+	if((unsigned int)y>=Y_RES) return;
+	parallel_send_command(COMMAND_G_HLINE);
+	parallel_send_short(x1);
+	parallel_send_short(x2);
+	parallel_send_short(y);
+	parallel_send_data(c);
 }
 
 void g_circle(int x0,int y0,unsigned int r,unsigned char c)
 // (x0,y0)を中心に、半径r、カラーパレット番号cの円を描画
 {
-
+	parallel_send_command(COMMAND_G_CIRCLE);
+	parallel_send_short(x0);
+	parallel_send_short(y0);
+	parallel_send_short(r<32767 ? r:32767);
+	parallel_send_data(c);
 }
 void g_boxfill(int x1,int y1,int x2,int y2,unsigned char c)
 // (x1,y1),(x2,y2)を対角線とするカラーパレット番号cで塗られた長方形を描画
 {
-
+	parallel_send_command(COMMAND_G_BOXFILL);
+	parallel_send_short(x1);
+	parallel_send_short(y1);
+	parallel_send_short(x2);
+	parallel_send_short(y2);
+	parallel_send_data(c);
 }
 void g_circlefill(int x0,int y0,unsigned int r,unsigned char c)
 // (x0,y0)を中心に、半径r、カラーパレット番号cで塗られた円を描画
 {
-
+	parallel_send_command(COMMAND_G_CIRCLEFILL);
+	parallel_send_short(x0);
+	parallel_send_short(y0);
+	parallel_send_short(r<32767 ? r:32767);
+	parallel_send_data(c);
 }
 void g_putfont(int x,int y,unsigned char c,int bc,unsigned char n)
 //8*8ドットのアルファベットフォント表示
@@ -232,26 +594,66 @@ void g_putfont(int x,int y,unsigned char c,int bc,unsigned char n)
 //bc:バックグランドカラー、負数の場合無視
 //n:文字番号
 {
-
+	if(x<=-8 || x>=X_RES || y<=-8 || y>=Y_RES) return; //画面外
+	parallel_send_command(COMMAND_G_PUTFONT);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_short(bc<0 ? -1:bc);
+	parallel_send_data(c);
+	parallel_send_data(n);
 }
 
 void g_printstr(int x,int y,unsigned char c,int bc,unsigned char *s){
 	//座標(x,y)からカラーパレット番号cで文字列sを表示、bc:バックグランドカラー
 	//bcが負の場合は無視
-
+	if(0==*s) return;
+	parallel_send_command(COMMAND_G_PRINTSTR);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_short(bc<0 ? -1:bc);
+	parallel_send_data(c);
+	while(*s) parallel_send_data(*s++);
+	parallel_send_data(0);
 }
 void g_printnum(int x,int y,unsigned char c,int bc,unsigned int n){
 	//座標(x,y)にカラー番号cで数値nを表示、bc:バックグランドカラー
-
+	unsigned char str[11];
+	unsigned char *p;
+	p=str+10;
+	*p=0;
+	do{
+		*(--p)='0'+n%10;
+		n/=10;
+	}while(n!=0);
+	g_printstr(x,y,c,bc,p);
 }
 void g_printnum2(int x,int y,unsigned char c,int bc,unsigned int n,unsigned char e){
 	//座標(x,y)にカラー番号cで数値nを表示、bc:バックグランドカラー、e桁で表示
-
+	unsigned char str[256];
+	unsigned char *p;
+	if(e==0) return;
+	p=str+e;
+	*p=0;
+	do{
+		*(--p)='0'+n%10;
+		n/=10;
+	}while(p!=str && n!=0);
+	while(p!=str) *(--p)=' ';
+	g_printstr(x,y,c,bc,str);
 }
 unsigned int g_color(int x,int y){
 //座標(x,y)の色情報を返す、画面外は0を返す
-//パレット番号ではないことに注意
-
+//NTSC版ではパレット番号を返す（palette[n]=nとしている）
+	//コマンド送信から読み出しまで割込み禁止（parallel_read_tvram()参照）
+	unsigned int s,c;
+	if(x<0 || x>=X_RES || y<0 || y>=Y_RES) return 0; //画面外
+	s=save_and_disable_interrupts();
+	parallel_send_command(COMMAND_READ_PIXEL);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	c=parallel_receive_data();
+	restore_interrupts(s);
+	return c;
 }
 
 // テキスト画面クリア
@@ -263,12 +665,179 @@ void clearscreen(void)
 	for(i=0;i<ATTROFFSET*2/4;i++) *vp++=0;
 	cursor=TVRAM;
 	parallel_send_command(COMMAND_CLS);
+	g_ntsc_cursor=TVRAM;
 }
 
 // グラフィック画面クリア
 void g_clearscreen(void)
 {
+	parallel_send_command(COMMAND_G_CLEARSCREEN);
+}
 
+// グラフィック描画ページ設定（0 or 1）
+void g_drawpage(unsigned char p)
+{
+	parallel_send_command(COMMAND_G_DRAWPAGE);
+	parallel_send_data(p);
+}
+
+// グラフィック表示ページ設定（0 or 1）、次の垂直ブランキングで切り替わる
+void g_displaypage(unsigned char p)
+{
+	parallel_send_command(COMMAND_G_DISPLAYPAGE);
+	parallel_send_data(p);
+}
+
+// グラフィックのパレットバンク設定（0-15、表示側が4ビット/ドットの場合のみ有効）
+// ドットの値nはパレット番号b*16+nで表示される
+void g_palettebank(unsigned char b)
+{
+	parallel_send_command(COMMAND_G_PALETTE_BANK);
+	parallel_send_data(b);
+}
+
+// 描画ページを表示し、もう一方のページを描画ページにする
+// 表示側は切り替え完了（次の垂直ブランキング）まで以降のコマンドを実行しない
+void g_flip(void)
+{
+	parallel_send_command(COMMAND_G_FLIP);
+}
+
+// スプライトパターンRAMのアドレスaからnバイトのパターンpを書き込む
+void g_spritepattern(unsigned short a,unsigned short n,const unsigned char p[])
+{
+	int i;
+	parallel_send_command(COMMAND_SPRITE_PATTERN);
+	parallel_send_short(a);
+	for(i=0;i<n;i++) parallel_send_data(p[i]);
+}
+
+// スプライトnを横w*縦hドット、透明色key、パターンRAMのアドレスaのパターンに設定
+// w、hが0の場合は非表示
+void g_spritedefine(unsigned char n,unsigned char w,unsigned char h,unsigned char key,unsigned short a)
+{
+	parallel_send_command(COMMAND_SPRITE_DEFINE);
+	parallel_send_short(a);
+	parallel_send_data(n);
+	parallel_send_data(w);
+	parallel_send_data(h);
+	parallel_send_data(key);
+}
+
+// スプライトnを座標(x,y)に移動
+void g_spritemove(unsigned char n,int x,int y)
+{
+	parallel_send_command(COMMAND_SPRITE_MOVE);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_data(n);
+}
+
+// 全スプライトを非表示にする
+void g_spritereset(void)
+{
+	parallel_send_command(COMMAND_SPRITE_RESET);
+}
+
+// タイルモード設定
+// m=0:グラフィック面を表示（スクロール位置もクリア）、m=1:タイルマップを表示
+void g_tilemode(unsigned char m)
+{
+	parallel_send_command(COMMAND_TILE_MODE);
+	parallel_send_data(m);
+}
+
+// タイルnのパターン（8x8ドット、64バイト）を設定
+void g_tiledefine(unsigned char n,const unsigned char p[])
+{
+	int i;
+	parallel_send_command(COMMAND_TILE_PATTERN);
+	parallel_send_short(n*64);
+	for(i=0;i<64;i++) parallel_send_data(p[i]);
+}
+
+// タイルマップの座標(x,y)にタイルnを置く
+void g_tileput(int x,int y,unsigned char n)
+{
+	parallel_send_command(COMMAND_TILE_MAP);
+	parallel_send_short((y&(TILEMAP_HEIGHT-1))*TILEMAP_WIDTH+(x&(TILEMAP_WIDTH-1)));
+	parallel_send_data(n);
+}
+
+// タイルマップのスクロール位置設定
+void g_tilescroll(int x,int y)
+{
+	parallel_send_command(COMMAND_TILE_SCROLL);
+	parallel_send_short(x);
+	parallel_send_short(y);
+}
+
+// y1ラインからy2ラインまでの横スクロール位置に加える値をxに設定
+void g_linescroll(int y1,int y2,int x)
+{
+	int i;
+	if (y1<0) y1=0;
+	if (Y_RES<=y2) y2=Y_RES-1;
+	if (y2<y1) return;
+	parallel_send_command(COMMAND_LINE_SCROLL);
+	parallel_send_short(y1);
+	for(i=y1;i<=y2;i++) parallel_send_short(x);
+}
+
+// 座標(x1,y1)から横w*縦hドットの範囲を座標(x2,y2)にコピー
+void g_copy(int x1,int y1,int w,int h,int x2,int y2)
+{
+	parallel_send_command(COMMAND_G_COPY);
+	parallel_send_short(x1);
+	parallel_send_short(y1);
+	parallel_send_short(w);
+	parallel_send_short(h);
+	parallel_send_short(x2);
+	parallel_send_short(y2);
+}
+
+// (x1,y1),(x2,y2)を対角線とする長方形をカラーパレット番号cでDMAにより塗りつぶす
+void g_fill(int x1,int y1,int x2,int y2,unsigned char c)
+{
+	parallel_send_command(COMMAND_G_FILL);
+	parallel_send_short(x1);
+	parallel_send_short(y1);
+	parallel_send_short(x2);
+	parallel_send_short(y2);
+	parallel_send_data(c);
+}
+
+// ブリッタ用パターンRAMのアドレスaからnバイトのパターンpを書き込む
+void g_blitpattern(unsigned short a,unsigned short n,const unsigned char p[])
+{
+	int i;
+	parallel_send_command(COMMAND_BLIT_PATTERN);
+	parallel_send_short(a);
+	for(i=0;i<n;i++) parallel_send_data(p[i]);
+}
+
+// ブリッタ用パターンRAMのアドレスaからの横w*縦hドットを座標(x,y)に描画
+// key：透明色（負数の場合は透明色なし）
+void g_blit(int x,int y,int w,int h,unsigned short a,int key)
+{
+	parallel_send_command(COMMAND_G_BLIT);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_short(w);
+	parallel_send_short(h);
+	parallel_send_short(a);
+	parallel_send_short(key);
+}
+
+// 座標(x,y)から横w*縦hドットをブリッタ用パターンRAMのアドレスaに取り込む
+void g_get(int x,int y,int w,int h,unsigned short a)
+{
+	parallel_send_command(COMMAND_G_GET);
+	parallel_send_short(x);
+	parallel_send_short(y);
+	parallel_send_short(w);
+	parallel_send_short(h);
+	parallel_send_short(a);
 }
 
 // カーソル位置の文字をテキストVRAMにしたがって液晶に出力
@@ -278,12 +847,73 @@ void putcursorchar(void){
 	printchar(0x08);
 }
 
+static unsigned char textredraw_data(int i){
+// 再描画で送信するi番目のバイト（WIDTH_X*WIDTH_Y個の文字の後にカラー）
+// TVRAM上のカラーはATTROFFSETから格納されている
+	if(i<WIDTH_X*WIDTH_Y) return TVRAM[i];
+	return TVRAM[i-WIDTH_X*WIDTH_Y+ATTROFFSET];
+}
+
+static int textredraw_rle(int send){
+// テキストVRAMをランレングス圧縮して送信（sendが0の場合はサイズ計算のみ）
+// 制御バイト0x00-0x7F：続くc+1バイトをそのまま、0x80-0xFF：続く1バイトを(c-0x80)+2回繰り返し
+// 戻り値は圧縮後のバイト数
+	int i,j,k,n,size;
+	n=WIDTH_X*WIDTH_Y*2;
+	size=0;
+	if(send) parallel_send_command(COMMAND_TEXTREDRAW_RLE);
+	for(i=0;i<n;i=j){
+		// 同じ値の連続
+		for(j=i+1;j<n && j-i<129 && textredraw_data(j)==textredraw_data(i);j++);
+		if(2<=j-i){
+			if(send){
+				parallel_send_data(0x80+(j-i-2));
+				parallel_send_data(textredraw_data(i));
+			}
+			size+=2;
+			continue;
+		}
+		// 3バイト以上の連続が始まるまでをそのまま送信
+		for(j=i+1;j<n && j-i<128;j++){
+			if(j+2<n && textredraw_data(j)==textredraw_data(j+1) && textredraw_data(j)==textredraw_data(j+2)) break;
+		}
+		if(send){
+			parallel_send_data(j-i-1);
+			for(k=i;k<j;k++) parallel_send_data(textredraw_data(k));
+		}
+		size+=1+j-i;
+	}
+	return size;
+}
+
 void textredraw(void){
 // テキスト画面再描画
 // テキストVRAMの内容にしたがって液晶に出力
+// 圧縮した方が小さい場合は圧縮して送信
 	int i;
+	if(textredraw_rle(0)<WIDTH_X*WIDTH_Y*2){
+		textredraw_rle(1);
+		return;
+	}
 	parallel_send_command(COMMAND_TEXTREDRAW);
-	for(i=0;i<WIDTH_X*WIDTH_Y*2;i++) parallel_send_data(TVRAM[i]);
+	for(i=0;i<WIDTH_X*WIDTH_Y*2;i++) parallel_send_data(textredraw_data(i));
+}
+
+void textredraw_rect(int x,int y,int w,int h){
+// テキスト画面の一部再描画
+// 座標(x,y)から横w文字、縦h行の範囲をテキストVRAMの内容にしたがって液晶に出力
+	int i,j;
+	if(x<0 || y<0 || w<=0 || h<=0) return;
+	if(WIDTH_X<x+w) w=WIDTH_X-x;
+	if(WIDTH_Y<y+h) h=WIDTH_Y-y;
+	if(w<=0 || h<=0) return;
+	parallel_send_command(COMMAND_WRITE_TVRAM_RECT);
+	parallel_send_data(x);
+	parallel_send_data(y);
+	parallel_send_data(w);
+	parallel_send_data(h);
+	for(j=y;j<y+h;j++) for(i=x;i<x+w;i++) parallel_send_data(TVRAM[j*WIDTH_X+i]);
+	for(j=y;j<y+h;j++) for(i=x;i<x+w;i++) parallel_send_data(TVRAM[j*WIDTH_X+i+ATTROFFSET]);
 }
 
 void windowscroll(int y1,int y2){
@@ -301,9 +931,13 @@ void windowscroll(int y1,int y2){
 		*(p1+ATTROFFSET)=0;
 		*p1++=0;
 	}
-	textredraw();
+	// NTSC側でも同じスクロールを行う
+	parallel_send_command(COMMAND_WINDOW_SCROLL);
+	parallel_send_data(y1);
+	parallel_send_data(y2);
 }
-void vramscroll(void){
+void vramscroll_main(void){
+	// テキストVRAMのみスクロール
 	unsigned char *p1,*p2,*vramend;
 
 	vramend=TVRAM+WIDTH_X*WIDTH_Y;
@@ -317,7 +951,11 @@ void vramscroll(void){
 		*(p1+ATTROFFSET)=0;
 		*p1++=0;
 	}
-	textredraw();
+}
+void vramscroll(void){
+	vramscroll_main();
+	// NTSC側でも同じスクロールを行う
+	parallel_send_command(COMMAND_SCROLL_UP);
 }
 void vramscrolldown(void){
 	unsigned char *p1,*p2,*vramend;
@@ -333,30 +971,59 @@ void vramscrolldown(void){
 		*(p1+ATTROFFSET)=0;
 		*p1--=0;
 	}
-	textredraw();
+	// NTSC側でも同じスクロールを行う
+	parallel_send_command(COMMAND_SCROLL_DOWN);
 }
 void setcursor(unsigned char x,unsigned char y,unsigned char c){
 	//カーソルを座標(x,y)にカラー番号cに設定
+	//NTSC側へは次の文字表示の際に送信する
 	if(x>=WIDTH_X || y>=WIDTH_Y) return;
 	cursor=TVRAM+y*WIDTH_X+x;
 	cursorcolor=c;
-	parallel_send_command(COMMAND_SETCURSOR);
-	parallel_send_data(x);
-	parallel_send_data(y);
-	parallel_send_data(c);	
 }
 void setcursorcolor(unsigned char c){
 	//カーソル位置そのままでカラー番号をcに設定
+	//NTSC側へは次の文字表示の際に送信する
 	cursorcolor=c;
-	parallel_send_command(COMMAND_SETCURSOR);
-	parallel_send_data(c);	
+}
+static void sync_cursor(void){
+	//NTSC側のカーソル位置とカラー番号を合わせる
+	int i,j;
+	i=cursor-g_ntsc_cursor;
+	if(0<i && i<=3 && TVRAM<=g_ntsc_cursor && cursor<TVRAM+WIDTH_X*WIDTH_Y){
+		//数文字先への移動は、間の文字を同じカラーで書き直す方が短い
+		for(j=0;j<i;j++){
+			if(g_ntsc_cursor[j]==0 || g_ntsc_cursor[j]=='\n' || g_ntsc_cursor[j]==0x08) break;
+			if(g_ntsc_cursor[j+ATTROFFSET]!=g_ntsc_cursorcolor) break;
+		}
+		if(j==i){
+			if(TEXTQUEUE_SIZE<g_textqueue_num+i+1) textqueue_send();
+			for(j=0;j<i;j++) g_textqueue[g_textqueue_num++]=g_ntsc_cursor[j];
+			g_ntsc_cursor=cursor;
+		}
+	}
+	if(g_ntsc_cursor!=cursor){
+		i=cursor-TVRAM;
+		if(i<0 || i>=WIDTH_X*WIDTH_Y) return;
+		parallel_send_command(COMMAND_SETCURSOR);
+		parallel_send_data(i%WIDTH_X);
+		parallel_send_data(i/WIDTH_X);
+		parallel_send_data(cursorcolor);
+		g_ntsc_cursor=cursor;
+		g_ntsc_cursorcolor=cursorcolor;
+	} else if(g_ntsc_cursorcolor!=cursorcolor){
+		parallel_send_command(COMMAND_SETCURSORCOLOR);
+		parallel_send_data(cursorcolor);
+		g_ntsc_cursorcolor=cursorcolor;
+	}
 }
 void printchar_main(unsigned char n){
 	//カーソル位置にテキストコードnを1文字表示し、カーソルを1文字進める
 	//画面最終文字表示してもスクロールせず、次の文字表示時にスクロールする
 	if(cursor<TVRAM || cursor>TVRAM+WIDTH_X*WIDTH_Y) return;
 	if(cursor==TVRAM+WIDTH_X*WIDTH_Y){
-		vramscroll();
+		// NTSC側はprintchar()で自らスクロールする
+		vramscroll_main();
 		cursor-=WIDTH_X;
 	}
 	if(n=='\n'){
@@ -372,13 +1039,19 @@ void printchar_main(unsigned char n){
 	}
 }
 void printchar(unsigned char n){
-	if (n<0x80) {
-		parallel_send_command(n);
+	// 割込み内のPRINTと混ざらないよう、割込み禁止で行う
+	unsigned int s=save_and_disable_interrupts();
+	sync_cursor();
+	if (n) {
+		g_textqueue[g_textqueue_num++]=n;
+		if (TEXTQUEUE_SIZE<=g_textqueue_num) textqueue_send();
 	} else {
-		parallel_send_command(COMMAND_PRINTCHAR);
-		parallel_send_data(n);
+		// 0x00 cannot be included in COMMAND_PRINTSTR
+		parallel_send_command(0);
 	}
 	printchar_main(n);
+	g_ntsc_cursor=cursor;
+	restore_interrupts(s);
 }
 void printstr(unsigned char *s){
 	//カーソル位置に文字列sを表示
@@ -423,6 +1096,21 @@ void cls(void){
 	//画面消去しカーソルを先頭に移動
 	clearscreen();
 }
+void pcg_sync(void){
+// RAMフォント（PCG）の変更された文字のみをスレーブに送信
+	int i,j;
+	if(fontp==FontData) return;
+	for(i=0;i<8*256;i+=8){
+		for(j=0;j<8;j++) if(fontp[i+j]!=g_ntsc_pcg[i+j]) break;
+		if(8<=j) continue;
+		parallel_send_command(COMMAND_PCG_DEFINE);
+		parallel_send_data(i>>3);
+		for(j=0;j<8;j++){
+			g_ntsc_pcg[i+j]=fontp[i+j];
+			parallel_send_data(fontp[i+j]);
+		}
+	}
+}
 void startPCG(unsigned char *p,int a){
 // RAMフォント（PCG）の利用開始
 // p：RAMフォントの格納アドレス（8*256＝2048バイト）
@@ -431,12 +1119,20 @@ void startPCG(unsigned char *p,int a){
 	if(a){
 		for(i=0;i<8*256;i++) *p++=FontData[i];
 		fontp=p-8*256;
+		// スレーブ側もシステムフォントで初期化
+		for(i=0;i<8*256;i++) g_ntsc_pcg[i]=FontData[i];
+		parallel_send_command(COMMAND_PCG_RESET);
 	}
 	else fontp=p;
+	pcg_sync();
+	parallel_send_command(COMMAND_USE_PCG);
+	parallel_send_data(1);
 }
 void stopPCG(void){
 // RAMフォント（PCG）の利用停止
 	fontp=(unsigned char *)FontData;
+	parallel_send_command(COMMAND_USE_PCG);
+	parallel_send_data(0);
 }
 void set_bgcolor(unsigned char b,unsigned char r,unsigned char g)
 {
@@ -445,23 +1141,34 @@ void set_bgcolor(unsigned char b,unsigned char r,unsigned char g)
 }
 void init_palette(void){
 	//カラーパレット初期化
+	//256色分を1コマンドでNTSC側へ送信する
 	int i;
+	set_palette_range_header(0,256);
 	for(i=0;i<8;i++){
-		set_palette(i,255*(i&1),255*((i>>1)&1),255*(i>>2));
+		parallel_send_data(255*(i&1));
+		parallel_send_data(255*((i>>1)&1));
+		parallel_send_data(255*(i>>2));
 	}
 	for(i=0;i<8;i++){
-		set_palette(i+8,128*(i&1),128*((i>>1)&1),128*(i>>2));
+		parallel_send_data(128*(i&1));
+		parallel_send_data(128*((i>>1)&1));
+		parallel_send_data(128*(i>>2));
 	}
-	for(i=16;i<256;i++){
-		set_palette(i,255,255,255);
+	for(i=16*3;i<256*3;i++){
+		parallel_send_data(255);
 	}
 }
 void init_textgraph(unsigned char align){
 	//テキスト・グラフィックNTSCライブラリの使用開始
+	int i;
 	parallel_init();
 	//パレット設定
 	//LCD縦横設定
 	fontp=(unsigned char *)FontData;
+	for(i=0;i<8*256;i++) g_ntsc_pcg[i]=FontData[i];
+	parallel_send_command(COMMAND_PCG_RESET);
+	parallel_send_command(COMMAND_USE_PCG);
+	parallel_send_data(0);
 	bgcolor=0; //バックグランドカラーは黒
 	init_palette(); //カラーパレット初期化
 	setcursorcolor(7);
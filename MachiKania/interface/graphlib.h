@@ -17,14 +17,33 @@ caused by using this program.
 ----------------------------------------------------------------------------*/
 void clearscreen(void); //テキスト画面クリア
 void set_palette(unsigned char n,unsigned char b,unsigned char r,unsigned char g); //テキストパレット設定
+void set_palette_range(unsigned char n,int num,const unsigned char *bgr); //パレットn～n+num-1の一括設定（b,r,gの順にnum組）
 void set_bgcolor(unsigned char b,unsigned char r,unsigned char g); //バックグランドカラー設定
 void init_textgraph(unsigned char align); //LCDテキスト・グラフィック機能利用準備
 void init_palette(void); //カラーパレット初期化
+void parallel_flush(void); //NTSC側への送信完了を待つ
+void textqueue_flush(void); //キューにある文字をNTSC側へ送信
+unsigned char parallel_receive_data(void); //NTSC側から1バイト読み出す
+unsigned char parallel_read_tvram(int pos); //NTSC側のTVRAM[pos]を読み出す
+unsigned int parallel_read_status(unsigned char n); //NTSC側の状態を読み出す（NTSC_STATUS_xxx）
+void parallel_reset_status(void); //NTSC側の状態の最大値とカウンターをリセット
+void parallel_vsync_init(void (*callback)(void)); //NTSC側の垂直ブランキング開始ごとにcallback()を呼ぶ
+
+// parallel_read_status()で読み出す状態の番号
+#define NTSC_STATUS_DRAWCOUNT    0 // 表示したフレーム数
+#define NTSC_STATUS_QUEUE        1 // 受信バッファ内の未処理データ数
+#define NTSC_STATUS_QUEUE_MAX    2 // 受信バッファ内の未処理データ数の最大値
+#define NTSC_STATUS_QUEUE_FULL   3 // 受信バッファが一杯になった回数
+#define NTSC_STATUS_LINE_MAX     4 // 1ラインの映像生成にかかったCPUサイクル数の最大値
+#define NTSC_STATUS_LINE_AVG     5 // 同、直前のフレームの平均値
+#define NTSC_STATUS_LINE_OVERRUN 6 // 映像生成が1ライン時間を超えた回数
 
 void putcursorchar(void);
 	// カーソル位置の文字をテキストVRAMにしたがって液晶に出力
 void textredraw(void);
 	// テキスト画面再描画、テキストVRAMの内容にしたがって液晶に出力
+void textredraw_rect(int x,int y,int w,int h);
+	// テキスト画面の(x,y)から横w文字、縦h行の範囲のみ再描画
 void vramscroll(void);
 	//1行スクロール
 void vramscrolldown(void);
@@ -49,6 +68,8 @@ void startPCG(unsigned char *p,int a);
 	// RAMフォント（PCG）の利用開始、pがフォント格納場所、aが0以外でシステムフォントをコピー
 void stopPCG(void);
 	// RAMフォント（PCG）の利用停止
+void pcg_sync(void);
+	// RAMフォント（PCG）の変更された文字をディスプレイに送信
 
 
 void g_pset(int x,int y,unsigned char c);
@@ -94,11 +115,74 @@ void g_printnum2(int x,int y,unsigned char c,int bc,unsigned int n,unsigned char
 //座標(x,y)にカラー番号cで数値nを表示、bc:バックグランドカラー、e桁で表示
 
 unsigned int g_color(int x,int y);
-//座標(x,y)の色を返す（RGB565形式）
+//座標(x,y)の色を返す（NTSC版ではパレット番号）
 
 void g_clearscreen(void);
 // グラフィック画面クリア
 
+void g_drawpage(unsigned char p);
+// グラフィック描画ページ設定（0 or 1）
+
+void g_displaypage(unsigned char p);
+// グラフィック表示ページ設定（0 or 1）、次の垂直ブランキングで切り替わる
+
+void g_palettebank(unsigned char b);
+// グラフィックのパレットバンク設定（表示側が4ビット/ドットの場合のみ有効、次の垂直ブランキングで切り替わる）
+
+void g_flip(void);
+// 描画ページを表示し、もう一方のページを描画ページにする
+
+#define SPRITE_NUM 32 // スプライト数
+#define SPRITE_MAX_SIZE 16 // スプライトの最大サイズ（縦横ドット数）
+
+void g_spritepattern(unsigned short a,unsigned short n,const unsigned char p[]);
+// スプライトパターンRAMのアドレスaからnバイトのパターンpを書き込む
+
+void g_spritedefine(unsigned char n,unsigned char w,unsigned char h,unsigned char key,unsigned short a);
+// スプライトnを横w*縦hドット、透明色key、パターンRAMのアドレスaのパターンに設定（w、hが0の場合は非表示）
+
+void g_spritemove(unsigned char n,int x,int y);
+// スプライトnを座標(x,y)に移動
+
+void g_spritereset(void);
+// 全スプライトを非表示にする
+
+#define TILE_NUM 256 // タイル数（8x8ドット）
+#define TILEMAP_WIDTH 64 // タイルマップの横タイル数
+#define TILEMAP_HEIGHT 32 // タイルマップの縦タイル数
+
+void g_tilemode(unsigned char m);
+// タイルモード設定、m=0:グラフィック面を表示（スクロール位置もクリア）、m=1:タイルマップを表示
+
+void g_tiledefine(unsigned char n,const unsigned char p[]);
+// タイルnのパターン（8x8ドット、64バイト）を設定
+
+void g_tileput(int x,int y,unsigned char n);
+// タイルマップの座標(x,y)にタイルnを置く
+
+void g_tilescroll(int x,int y);
+// タイルマップのスクロール位置設定
+
+void g_linescroll(int y1,int y2,int x);
+// y1ラインからy2ラインまでの横スクロール位置に加える値をxに設定
+
+#define BLIT_PATTERN_SIZE 16384 // ブリッタ用パターンRAMのサイズ
+
+void g_copy(int x1,int y1,int w,int h,int x2,int y2);
+// 座標(x1,y1)から横w*縦hドットの範囲を座標(x2,y2)にコピー（範囲は重なってもよい）
+
+void g_fill(int x1,int y1,int x2,int y2,unsigned char c);
+// (x1,y1),(x2,y2)を対角線とする長方形をカラーパレット番号cでDMAにより塗りつぶす
+
+void g_blitpattern(unsigned short a,unsigned short n,const unsigned char p[]);
+// ブリッタ用パターンRAMのアドレスaからnバイトのパターンpを書き込む
+
+void g_blit(int x,int y,int w,int h,unsigned short a,int key);
+// ブリッタ用パターンRAMのアドレスaからの横w*縦hドットを座標(x,y)に描画（keyは透明色、負数で透明色なし）
+
+void g_get(int x,int y,int w,int h,unsigned short a);
+// 座標(x,y)から横w*縦hドットをブリッタ用パターンRAMのアドレスaに取り込む
+
 void set_lcdalign(unsigned char align);
 // 液晶の縦横設定
 
@@ -32,6 +32,7 @@ int insertmode; //挿入モード：1、上書きモード：0
 
 // 60分のn秒ウェイト
 void wait60thsec(unsigned short n){
+	textqueue_flush(); //表示待ちの文字を送信
 	uint64_t t=to_us_since_boot(get_absolute_time())%16667;
 	sleep_us(16667*n-t);
 }
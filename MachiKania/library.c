@@ -178,8 +178,15 @@ int lib_calc_float(int r0, int r1, int r2){
 }
 
 int lib_line_num(int r0, int r1, int r2){
-	int* data=cmpdata_findfirst_with_id(CMPDATA_LINENUM,r0);
-	if (data) return data[1];// Found
+	int i;
+	// Find the line in main file, first (the newest one if duplicated)
+	for(i=g_line_table_num-1;0<=i;i--){
+		if (g_line_table[i*2+1]==r0) return g_line_table[i*2];// Found
+	}
+	// Find the line in class files
+	for(i=g_line_table_num-1;0<=i;i--){
+		if ((g_line_table[i*2+1]&0xffff)==r0) return g_line_table[i*2];// Found
+	}
 	// Not found
 	printstr("\nLine ");
 	printint(r0);
@@ -663,6 +670,19 @@ int lib_system(int r0, int r1, int r2){
 		case 29:
 		//	グラフィックディスプレイの、現在のY位置を返す。
 			return lib_display(4,0,0);
+		case 30:
+		case 31:
+		case 32:
+		case 33:
+		case 34:
+		case 35:
+		case 36:
+		//	NTSC側の状態を返す（NTSC_STATUS_xxx）。
+			return parallel_read_status(r0-30);
+		case 37:
+		//	NTSC側の状態の最大値とカウンターをリセットする。
+			parallel_reset_status();
+			break;
 		case 40:
 		//	PS/2キーボードを使用中かどうかを返す。
 			return 0;
@@ -110,32 +110,28 @@ int get_float_operator(void){
 	}
 }
 
-int integer_calculation(int op){
+int integer_comparison(int op){
+	int i;
+	unsigned short* begin;
+	// Compare with a constant if possible (see peephole.c)
+	if (OP_EQ==op || OP_NEQ==op) i=peephole_constant_operand(0,255);
+	else i=-1;
+	begin=object;
 	switch(op){
-		case OP_OR:
-			check_object(1);
-			(object++)[0]=0x4308; // orrs	r0, r1
-			return 0;
-		case OP_AND:
-			check_object(1);
-			(object++)[0]=0x4008; // ands	r0, r1
-			return 0;
-		case OP_XOR:
-			check_object(1);
-			(object++)[0]=0x4048; // eors	r0, r1
-			return 0;
 		case OP_EQ:
 			check_object(3);
-			(object++)[0]=0x1a08; // subs	r0, r1, r0
+			if (0<=i) (object++)[0]=0x3800 | i; // subs	r0, #xx
+			else      (object++)[0]=0x1a08;     // subs	r0, r1, r0
 			(object++)[0]=0x4243; // negs	r3, r0
 			(object++)[0]=0x4158; // adcs	r0, r3
-			return 0;
+			break;
 		case OP_NEQ:
 			check_object(3);
-			(object++)[0]=0x1a08; // subs	r0, r1, r0
+			if (0<=i) (object++)[0]=0x3800 | i; // subs	r0, #xx
+			else      (object++)[0]=0x1a08;     // subs	r0, r1, r0
 			(object++)[0]=0x1e43; // subs	r3, r0, #1
 			(object++)[0]=0x4198; // sbcs	r0, r3
-			return 0;
+			break;
 		case OP_LT:
 			check_object(7);
 			(object++)[0]=0x0003; // movs	r3, r0
@@ -145,7 +141,7 @@ int integer_calculation(int op){
 			(object++)[0]=0x4150; // adcs	r0, r2
 			(object++)[0]=0x2301; // movs	r3, #1
 			(object++)[0]=0x1a18; // subs	r0, r3, r0
-			return 0;
+			break;
 		case OP_LTE:
 			check_object(5);
 			(object++)[0]=0x0003; // movs	r3, r0
@@ -153,7 +149,7 @@ int integer_calculation(int op){
 			(object++)[0]=0x17da; // asrs	r2, r3, #31
 			(object++)[0]=0x428b; // cmp	r3, r1
 			(object++)[0]=0x4150; // adcs	r0, r2
-			return 0;
+			break;
 		case OP_MT:
 			check_object(7);
 			(object++)[0]=0x0003; // movs	r3, r0
@@ -163,7 +159,7 @@ int integer_calculation(int op){
 			(object++)[0]=0x4150; // adcs	r0, r2
 			(object++)[0]=0x2301; // movs	r3, #1
 			(object++)[0]=0x1a18; // subs	r0, r3, r0
-			return 0;
+			break;
 		case OP_MTE:
 			check_object(5);
 			(object++)[0]=0x0003; // movs	r3, r0
@@ -171,22 +167,72 @@ int integer_calculation(int op){
 			(object++)[0]=0x0fda; // lsrs	r2, r3, #31
 			(object++)[0]=0x4299; // cmp	r1, r3
 			(object++)[0]=0x4150; // adcs	r0, r2
+			break;
+		default:
+			return ERROR_UNKNOWN;
+	}
+	// Register the comparison code to use a conditional branch instead (see peephole.c)
+	peephole_compare(begin,op,0<=i ? (0x2800 | i):0x4281); // cmp	r0, #xx or cmp	r1, r0
+	return 0;
+}
+
+int integer_calculation(int op){
+	int i;
+	switch(op){
+		case OP_OR:
+			check_object(1);
+			(object++)[0]=0x4308; // orrs	r0, r1
 			return 0;
+		case OP_AND:
+			check_object(1);
+			(object++)[0]=0x4008; // ands	r0, r1
+			return 0;
+		case OP_XOR:
+			check_object(1);
+			(object++)[0]=0x4048; // eors	r0, r1
+			return 0;
+		case OP_EQ:
+		case OP_NEQ:
+		case OP_LT:
+		case OP_LTE:
+		case OP_MT:
+		case OP_MTE:
+			return integer_comparison(op);
 		case OP_SHL:
+			i=peephole_constant_operand(0,31);
+			if (0<=i) {
+				(object++)[0]=0x0000 | (i<<6); // lsls	r0, r0, #xx
+				return 0;
+			}
 			check_object(2);
 			(object++)[0]=0x4081; // lsls	r1, r0
 			(object++)[0]=0x0008; // movs	r0, r1
 			return 0;
 		case OP_SHR:
+			i=peephole_constant_operand(1,31);
+			if (0<=i) {
+				(object++)[0]=0x0800 | (i<<6); // lsrs	r0, r0, #xx
+				return 0;
+			}
 			check_object(2);
 			(object++)[0]=0x40c1; // lsrs	r1, r0
 			(object++)[0]=0x0008; // movs	r0, r1
 			return 0;
 		case OP_ADD:
+			i=peephole_constant_operand(0,255);
+			if (0<=i) {
+				(object++)[0]=0x3000 | i; // adds	r0, #xx
+				return 0;
+			}
 			check_object(1);
 			(object++)[0]=0x1808; // adds	r0, r1, r0
 			return 0;
 		case OP_SUB:
+			i=peephole_constant_operand(0,255);
+			if (0<=i) {
+				(object++)[0]=0x3800 | i; // subs	r0, #xx
+				return 0;
+			}
 			check_object(1);
 			(object++)[0]=0x1a08; // subs	r0, r1, r0
 			return 0;
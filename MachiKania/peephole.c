@@ -0,0 +1,187 @@
+/*
+   This program is provided under the LGPL license ver 2.1
+   KM-BASIC for ARM, written by Katsumi.
+   http://hp.vector.co.jp/authors/VA016157/
+   https://github.com/kmorimatsu
+*/
+
+#include "./compiler.h"
+
+/*
+	Peephole optimization
+
+	Following codes are replaced just after they are compiled:
+
+	1. A binary operator of which right value is a constant or a variable
+		str	r0, [sp, #xx]    ->  movs	r1, r0
+		(constant/variable)      (constant/variable)
+		ldr	r1, [sp, #xx]
+	   See value_pop_r1().
+
+	2. A constant right value of +, -, <<, >>, = and !=
+		movs	r1, r0       ->  adds	r0, #xx
+		movs	r0, #xx
+		adds	r0, r1, r0
+	   See integer_calculation().
+
+	3. A comparison followed by a conditional branch (IF, WHILE, DO, LOOP)
+		(comparison)         ->  cmp	r1, r0 (or cmp	r0, #xx)
+		cmp	r0, #0               bxx.n	skip
+		bne.n	skip
+	   See peephole_branch().
+
+	Codes are replaced only when the whole codes to replace are at the end of object
+	and their positions are exactly known. Therefore, BL instructions and the CMPDATA
+	records pointing the object area aren't affected.
+*/
+
+// The last code setting a constant or a variable value to r0
+static unsigned short* g_simple_begin;
+static unsigned short* g_simple_end;
+static char g_simple_type;
+static int g_simple_value;
+
+// The last "movs r1, r0" code followed by a constant or a variable value
+static unsigned short* g_operand_begin;
+static unsigned short* g_operand_end;
+static char g_operand_type;
+static int g_operand_value;
+
+// The last comparison code
+static unsigned short* g_compare_begin;
+static unsigned short* g_compare_end;
+static unsigned short g_compare_code;
+static unsigned char g_compare_cond;
+
+// All optimizations are off if 1 (for comparing the codes with and without them)
+char g_disable_peephole=0;
+
+void peephole_reset(void){
+	g_simple_end=0;
+	g_operand_end=0;
+	g_compare_end=0;
+}
+
+/*
+	Register the code to set a constant (PEEPHOLE_CONSTANT) or a variable value
+	(PEEPHOLE_VARIABLE) to r0, between begin and current object.
+	The code must not be referred by any BL instruction or CMPDATA record.
+*/
+void peephole_simple_value(unsigned short* begin, char type, int value){
+	if (g_disable_peephole) return;
+	g_simple_begin=begin;
+	g_simple_end=object;
+	g_simple_type=type;
+	g_simple_value=value;
+}
+
+/*
+	Set a constant value to r0, and register the code.
+*/
+int peephole_constant_to_r0(int value){
+	unsigned short* obefore=object;
+	int e;
+	e=set_value_in_register(0,value);
+	if (e) return e;
+	peephole_simple_value(obefore,PEEPHOLE_CONSTANT,value);
+	return 0;
+}
+
+/*
+	Returns 1 if only a constant or a variable value is set to r0 after begin.
+*/
+int peephole_is_simple_value(unsigned short* begin){
+	return g_simple_end==object && g_simple_begin==begin;
+}
+
+/*
+	Rewind object to pos and compile "movs r1, r0" followed by the constant or
+	the variable value registered by peephole_simple_value().
+*/
+int peephole_r0_to_r1(unsigned short* pos){
+	int e;
+	if (!peephole_is_simple_value(g_simple_begin)) return ERROR_UNKNOWN;
+	g_simple_end=0;
+	object=pos;
+	check_object(1);
+	(object++)[0]=0x0001; // movs	r1, r0
+	if (PEEPHOLE_CONSTANT==g_simple_type) e=set_value_in_register(0,g_simple_value);
+	else e=variable_to_r0(g_simple_value);
+	if (e) return e;
+	g_operand_begin=pos;
+	g_operand_end=object;
+	g_operand_type=g_simple_type;
+	g_operand_value=g_simple_value;
+	return 0;
+}
+
+/*
+	If the right value of binary operator is a constant between min and max (0 or more)
+	(see peephole_r0_to_r1()), remove the code of right value and return the constant.
+	The left value is in r0 after this.
+	Returns -1 if not.
+*/
+int peephole_constant_operand(int min, int max){
+	if (g_operand_end!=object) return -1;
+	if (PEEPHOLE_CONSTANT!=g_operand_type) return -1;
+	if (g_operand_value<min || max<g_operand_value) return -1;
+	g_operand_end=0;
+	object=g_operand_begin;
+	return g_operand_value;
+}
+
+/*
+	Register the comparison code between begin and current object.
+	r0 will be 1 if true or 0 if false after the code.
+	code is "cmp r1, r0" or "cmp r0, #xx" for the comparison when the code is removed.
+*/
+void peephole_compare(unsigned short* begin, int op, unsigned short code){
+	if (g_disable_peephole) return;
+	g_compare_begin=begin;
+	g_compare_end=object;
+	g_compare_code=code;
+	switch(op){
+		case OP_EQ:  g_compare_cond=0x0; break; // eq
+		case OP_NEQ: g_compare_cond=0x1; break; // ne
+		case OP_LT:  g_compare_cond=0xb; break; // lt
+		case OP_LTE: g_compare_cond=0xd; break; // le
+		case OP_MT:  g_compare_cond=0xc; break; // gt
+		case OP_MTE: g_compare_cond=0xa; break; // ge
+		default:     g_compare_end=0;    break;
+	}
+}
+
+/*
+	Compile a conditional branch by r0 value.
+	branch is either 0xd1xx (bne.n; branch if true) or 0xd0xx (beq.n; branch if false).
+	If the comparison code is just before, it will be replaced.
+*/
+int peephole_branch(unsigned short branch){
+	unsigned short addsp=0;
+	unsigned char cond;
+	int i;
+	// "add sp, #xx" (see value_end_stack()) may follow the comparison code
+	if (g_compare_end && g_compare_end+1==object && 0xb000==(object[-1]&0xff80)) addsp=object[-1];
+	if (g_compare_end!=(addsp ? object-1:object)) {
+		// Comparison code isn't found. Use r0 value.
+		check_object(2);
+		(object++)[0]=0x2800;   // cmp	r0, #0
+		(object++)[0]=branch;   // bne.n	skip (or beq.n	skip)
+		return 0;
+	}
+	g_compare_end=0;
+	cond=g_compare_cond;
+	if (0xd000==(branch&0xff00)) cond^=1; // Branch if false
+	// Remove the comparison code
+	object=g_compare_begin;
+	if (0x4281==g_compare_code) {
+		// Compare with a constant if possible
+		i=peephole_constant_operand(0,255);
+		if (0<=i) g_compare_code=0x2800|i; // cmp	r0, #xx
+	}
+	check_object(3);
+	if (addsp) (object++)[0]=addsp;               // add	sp, #xx
+	(object++)[0]=g_compare_code;                  // cmp	r1, r0 (or cmp	r0, #xx)
+	(object++)[0]=0xd000|(cond<<8)|(branch&0xff); // bxx.n	skip
+	return 0;
+}
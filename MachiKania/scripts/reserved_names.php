@@ -26,8 +26,11 @@ function checkFile($fname){
 	echo $fname,"\n";
 	$t=file_get_contents($fname);
 	if (substr($fname,-2)=='.c') {
-		if (preg_match_all('/instruction_is\("([A-Z0-9]+)/',$t,$m)) return $m[1];
-		else return array();
+		$words=array();
+		if (preg_match_all('/instruction_is\("([A-Z0-9]+)/',$t,$m)) $words=$m[1];
+		// Keyword table in statements.c
+		if (preg_match_all('/\t\{"([A-Z0-9]+)",/',$t,$m)) $words=array_merge($words,$m[1]);
+		return $words;
 	} else if (substr($fname,-5)=='.html') {
 		if (preg_match_all("/\t'([A-Z0-9]+)',/",$t,$m)) return $m[1];
 		else return array();
@@ -88,7 +88,7 @@ int poke32_statement(void){
 */
 
 int var_statement(void){
-	int i,e,vn;
+	int i,e,vn,r4;
 	unsigned short* subsp;
 	unsigned short* bl;
 	// Push routine follows
@@ -96,9 +96,11 @@ int var_statement(void){
 	subsp=object;
 	object++; // sub	sp, #xx
 	i=0;
+	r4=0;
 	do {
 		vn=get_var_number();
 		if (vn<0) return vn;
+		if (vn==g_r4_varnum) r4=1;
 		if ('#'==source[0] || '$'==source[0]) source++;
 		e=set_value_in_register(0,vn);
 		if (e<0) return e;
@@ -135,6 +137,8 @@ int var_statement(void){
 	update_bl(bl,object);
 	check_object(1);
 	(object++)[0]=0xb500; //   push	{lr}
+	// The variable kept in R4 has been cleared (see for_r4_record())
+	if (r4) return reload_r4();
 	// All done
 	return 0;
 }
@@ -368,6 +372,13 @@ int exec_statement(void){
 		data16:    line number
 		record[1]: destinaion address
 	
+	CMPDATA_CLASSLINE
+		CMPDATA_LINENUM of a file that has been compiled (see close_line_numbers())
+		The records of a file are followed by the one with len 1 and class id:
+		type:      CMPDATA_CLASSLINE
+		len:       1
+		data16:    class id (0 for main file)
+	
 	CMPDATA_LABEL
 		type:      CMPDATA_LABEL
 		len:       2
@@ -443,6 +454,7 @@ int label_statement(void){
 	e=cmpdata_insert(CMPDATA_LABEL,id,(int*)g_scratch_int,1);
 	if (e) return e;
 	// Resolve all CMPDATA_GOTO_LABEL_BL(s)
+	e=0;
 	while(data=cmpdata_findfirst_with_id(CMPDATA_GOTO_LABEL_BL,id)){
 		// Found a CMPDATA_GOTO_LABEL_BL
 		bl=(short*)data[1];
@@ -450,6 +462,7 @@ int label_statement(void){
 		update_bl(bl,object);
 		// Delete the cmpdata record
 		cmpdata_delete(data);
+		e=1;
 	}
 	// Resolve all CMPDATA_DATA_LABEL_BL(s)
 	while(data=cmpdata_findfirst_with_id(CMPDATA_DATA_LABEL_BL,id)){
@@ -461,6 +474,8 @@ int label_statement(void){
 		// Delete the cmpdata record
 		cmpdata_delete(data);
 	}
+	// R4 may not be the counter of FOR loop when jumped here from other loop
+	if (e) return reload_r4();
 	// All done
 	return 0;
 }
@@ -471,9 +486,9 @@ int goto_label(void){
 	// Get label id
 	id=get_label_id();
 	if (id<0) return id;
-	// Check if LABEL already set
-	data=cmpdata_findfirst_with_id(CMPDATA_LABEL,id);
+	// Check if LABEL already set (after check_object(), which may move the records)
 	check_object(2);
+	data=cmpdata_findfirst_with_id(CMPDATA_LABEL,id);
 	if (data) {
 		// BL destination is known
 		update_bl(object,(short*)data[1]);
@@ -493,9 +508,9 @@ int goto_label(void){
 int goto_line(int id){
 	int e;
 	int* data;
-	// Check if line is already set
-	data=cmpdata_findfirst_with_id(CMPDATA_LINENUM,id);
+	// Check if line is already set (after check_object(), which may move the records)
 	check_object(2);
+	data=find_line_number(id);
 	if (data) {
 		// BL destination is known
 		update_bl(object,(short*)data[1]);
@@ -523,11 +538,15 @@ int goto_statement(void){
 		rewind_object(obefore);
 		source=sbefore;
 		g_constant_value_flag=1;
-		return goto_label();
+		e=goto_label();
+		if (e) return e;
+		return for_r4_goto();
 	} else if (g_constant_value_flag) {
 		// Label number is used
 		rewind_object(obefore);
-		return goto_line(g_constant_int);
+		e=goto_line(g_constant_int);
+		if (e) return e;
+		return for_r4_goto();
 	} else {
 		// Label number is flexible
 		e=call_lib_code(LIB_LINE_NUM);
@@ -625,7 +644,8 @@ int post_gosub_statement(int i){
 	check_object(2);
 	(object++)[0]=0x6876;   // ldr	r6, [r6, #4]
 	(object++)[0]=0xb000|i; // add	sp, #xx
-	return 0;
+	// R4 may be used in the subroutine
+	return reload_r4();
 }
 
 int return_statement(void){
@@ -640,6 +660,112 @@ int return_statement(void){
 	return 0;
 }
 
+/*
+	R4 register for FOR loop counter
+
+	The counter of the innermost FOR loop is kept in R4 register when its var number is
+	less than 32 (see for_statement()). Reading the counter is "movs r0, r4" instead of
+	accessing memory. Writing to it updates both the memory and R4, so the memory always
+	contains the current value and R4 can be reloaded anywhere by reload_r4().
+	R4 is reloaded after:
+		1. Exiting the inner FOR loop (see contine_end_loop())
+		2. GOSUB and calling method (see post_gosub_statement())
+		3. LABEL that is the destination of forward GOTO, and every line number (GOTO and
+		   GOSUB to a line number given by a value may jump there from anywhere)
+		4. Backward GOTO to the outer FOR loop (see for_r4_goto())
+		5. Library assigning the counter (see for_r4_assigned())
+		6. Every statement, when the address of counter has been taken (see for_r4_address())
+		7. NEXT statement, before increasing the counter
+	Interrupt routines preserve R4 (see call_interrupt_function()). The counter changed by
+	an interrupt routine stays in memory, and NEXT statement continues the loop from it.
+	Until then, the statements in the loop may still read the old value from R4.
+
+	The FOR loop using R4 has CMPDATA_CONTINUE record with following structure:
+		type:      CMPDATA_CONTINUE
+		len:       4
+		data16:    depth
+		record[1]: destination address
+		record[2]: address from where R4 is the counter
+		record[3]: var number of the counter | FOR_R4_CLEAR_SIZE | FOR_R4_ADDRESS
+*/
+
+int* for_r4_record(int depth){
+	int* data=cmpdata_findfirst_with_id(CMPDATA_CONTINUE,depth);
+	if (data && 4==((data[0]>>16)&0xff)) return data;
+	return 0;
+}
+
+void for_r4_update(void){
+	int* data;
+	int i;
+	// Find the innermost FOR loop using R4
+	g_r4_varnum=-1;
+	g_r4_reload=0;
+	for(i=g_fordepth;0<i;i--){
+		data=for_r4_record(i);
+		if (!data) continue;
+		g_r4_varnum=data[3]&0xff;
+		if (data[3]&FOR_R4_ADDRESS) g_r4_reload=1;
+		break;
+	}
+}
+
+int for_r4_assigned(int vn){
+	// A string or an array has been assigned to the variable by library.
+	// The size of counter will be cleared when continuing the loop, as r0_to_variable() does.
+	int* data;
+	int i;
+	for(i=g_fordepth;0<i;i--){
+		data=for_r4_record(i);
+		if (data && vn==(data[3]&0xff)) data[3]|=FOR_R4_CLEAR_SIZE;
+	}
+	if (vn==g_r4_varnum) return reload_r4();
+	return 0;
+}
+
+void for_r4_address(int vn){
+	// The counter may be changed by the pointer to it
+	int* data;
+	int i;
+	for(i=g_fordepth;0<i;i--){
+		data=for_r4_record(i);
+		if (data && vn==(data[3]&0xff)) data[3]|=FOR_R4_ADDRESS;
+	}
+	for_r4_update();
+}
+
+int for_r4_goto(void){
+	// GOTO statement has just been compiled
+	unsigned short* bl=object-2;
+	unsigned short* destination;
+	int* data;
+	int i;
+	if (g_r4_varnum<0) return 0;
+	// Get the destination of BL instruction
+	i=((bl[0]&0x7ff)<<11) | (bl[1]&0x7ff);
+	if (i&0x200000) i|=0xffc00000;
+	destination=bl+2+i;
+	// R4 will be reloaded at the destination of forward GOTO
+	if (object<=destination) return 0;
+	// Find the innermost FOR loop containing the destination
+	for(i=g_fordepth;0<i;i--){
+		data=for_r4_record(i);
+		if (!data) continue;
+		if ((int)destination<data[2]) continue;
+		if ((data[3]&0xff)==g_r4_varnum) return 0;
+		// Insert the code to reload R4 before BL instruction
+		i=data[3]&0xff;
+		check_object(1);
+		object=bl;
+		(object++)[0]=0x682c | (i<<6); // ldr	r4, [r5, #xx]
+		update_bl(object,destination);
+		object+=2;
+		return 0;
+	}
+	// The destination is out of FOR loops
+	return 0;
+}
+
 /*
 	BREAK/CONTINUE statements
 
@@ -669,16 +795,20 @@ int break_statement(void){
 
 int continue_statement(void){
 	int* data;
+	// Room for the codes below. Check it first, as check_object() may move the records.
+	check_object(5);
 	// Find the CMPDATA_CONTINUE
-	cmpdata_reset();
-	while(data=cmpdata_find(CMPDATA_CONTINUE)){
-		if ((data[0]&0xffff)==g_fordepth) break;
-	}
+	data=cmpdata_findfirst_with_id(CMPDATA_CONTINUE,g_fordepth);
 	if (!data) return ERROR_SYNTAX;
 	// Temporarily store "data" for deleting (see contine_end_loop())
 	g_scratch_int[0]=(int)data;
+	// Clear the size of FOR loop counter if needed (see for_r4_assigned())
+	if (4==((data[0]>>16)&0xff) && (data[3]&FOR_R4_CLEAR_SIZE)) {
+		(object++)[0]=0x2300;                       // movs	r3, #0
+		(object++)[0]=0x68ba;                       // ldr	r2, [r7, #8]
+		(object++)[0]=0x8013 | ((data[3]&0xff)<<6); // strh	r3, [r2, #xx]
+	}
 	// Jump to the found address
-	check_object(2);
 	update_bl(object,(short*)data[1]);
 	object+=2;
 	return 0;
@@ -695,18 +825,18 @@ int do_statement(void){
 	if (instruction_is("WHILE")) {
 		e=get_int_or_float();
 		if (e) return e;
-		check_object(2);
-		(object++)[0]=0x2800;// cmp	r0, #0
-		(object++)[0]=0xd101;// bne.n	skip
+		// cmp	r0, #0 and bne.n	skip, or faster codes (see peephole.c)
+		e=peephole_branch(0xd101);
+		if (e) return e;
 		e=break_statement();
 		                     // skip:
 		if (e) return e;
 	} else if (instruction_is("UNTIL")) {
 		e=get_int_or_float();
 		if (e) return e;
-		check_object(2);
-		(object++)[0]=0x2800;// cmp	r0, #0
-		(object++)[0]=0xd001;// beq.n	skip
+		// cmp	r0, #0 and beq.n	skip, or faster codes (see peephole.c)
+		e=peephole_branch(0xd001);
+		if (e) return e;
 		e=break_statement();
 		                     // skip:
 		if (e) return e;
@@ -717,21 +847,18 @@ int do_statement(void){
 }
 
 int contine_end_loop(void){
-	int e;
+	int e,r4;
 	int* data;
 	unsigned short* bl;
 	// Continue
 	e=continue_statement();
 	if (e) return e;
 	// Delete the CMPDATA_CONTINUE (see continue_statement())
-	cmpdata_delete((int*)g_scratch_int[0]);
+	data=(int*)g_scratch_int[0];
+	r4=(4==((data[0]>>16)&0xff));
+	cmpdata_delete(data);
 	// Resolve all CMPDATA_BREAK_BL(s)
-	while(1){
-		cmpdata_reset();
-		while(data=cmpdata_find(CMPDATA_BREAK_BL)){
-			if ((data[0]&0xffff)==g_fordepth) break;
-		}
-		if (!data) break;
+	while(data=cmpdata_findfirst_with_id(CMPDATA_BREAK_BL,g_fordepth)){
 		// Found a CMPDATA_BREAK_BL
 		bl=(short*)data[1];
 		// Update it
@@ -741,6 +868,11 @@ int contine_end_loop(void){
 	}
 	// All done
 	g_fordepth--;
+	if (r4) {
+		// R4 will be the counter of outer FOR loop
+		for_r4_update();
+		return reload_r4();
+	}
 	return 0;
 }
 
@@ -749,15 +881,15 @@ int loop_statement(void){
 	if (instruction_is("WHILE")) {
 		e=get_int_or_float();
 		if (e) return e;
-		check_object(2);
-		(object++)[0]=0x2800;// cmp	r0, #0
-		(object++)[0]=0xd001;// beq.n	skip
+		// cmp	r0, #0 and beq.n	skip, or faster codes (see peephole.c)
+		e=peephole_branch(0xd001);
+		if (e) return e;
 	} else if (instruction_is("UNTIL")) {
 		e=get_int_or_float();
 		if (e) return e;
-		check_object(2);
-		(object++)[0]=0x2800;// cmp	r0, #0
-		(object++)[0]=0xd101;// bne.n	skip
+		// cmp	r0, #0 and bne.n	skip, or faster codes (see peephole.c)
+		e=peephole_branch(0xd101);
+		if (e) return e;
 	}
 	// Continue and end the loop
 	return contine_end_loop();
@@ -770,9 +902,9 @@ int while_statement(void){
 	unsigned short* obefore=object;
 	e=get_int_or_float();
 	if (e) return e;
-	check_object(2);
-	(object++)[0]=0x2800;// cmp	r0, #0
-	(object++)[0]=0xd101;// bne.n	skip
+	// cmp	r0, #0 and bne.n	skip, or faster codes (see peephole.c)
+	e=peephole_branch(0xd101);
+	if (e) return e;
 	e=break_statement();
 	                     // skip:
 	if (e) return e;
@@ -791,7 +923,8 @@ int wend_statement(void){
 */
 
 int for_statement(void){
-	int e,vn;
+	int e,vn,step;
+	int* data;
 	unsigned short* bl;
 	char* sbefore;
 	g_fordepth++;
@@ -808,6 +941,17 @@ int for_statement(void){
 	// Store value to variable
 	e=r0_to_variable(vn);
 	if (e) return e;
+	if (vn<32) {
+		// Keep the counter in R4 (see for_r4_record())
+		check_object(1);
+		(object++)[0]=0x0004;// movs	r4, r0
+		g_scratch_int[0]=(int)&object[0]; // This will be updated (see below)
+		g_scratch_int[1]=(int)&object[0];
+		g_scratch_int[2]=vn;
+		e=cmpdata_insert(CMPDATA_CONTINUE,g_fordepth,(int*)&g_scratch_int[0],3);
+		if (e) return e;
+		for_r4_update();
+	}
 	// Check "TO"
 	if (!instruction_is("TO")) return ERROR_SYNTAX;
 	// Get integer
@@ -817,6 +961,7 @@ int for_statement(void){
 	check_object(1);
 	(object++)[0]=0xb401;// push	{r0}
 	// Check STEP
+	step=0;
 	if (instruction_is("STEP")) {
 		// This is required for the first time checking using r2 register (see below)
 		// Get integer
@@ -825,17 +970,25 @@ int for_statement(void){
 		// Move r0 to r2
 		check_object(1);
 		(object++)[0]=0x0002;// movs	r2, r0
+		step=1;
+	}
+	// Ger r0 from var (R4 is used instead for STEP 1)
+	if (step || vn!=g_r4_varnum) {
+		e=variable_to_r0(vn);
+		if (e) return e;
 	}
-	// Ger r0 from var
-	e=variable_to_r0(vn);
-	if (e) return e;
 	// Insert a BL instruction here to skip codes
 	bl=object;
 	object+=2;
-	// Insert a CMPDATA_CONTINUE
-	g_scratch_int[0]=(int)&object[0];
-	e=cmpdata_insert(CMPDATA_CONTINUE,g_fordepth,(int*)&g_scratch_int[0],1);
-	if (e) return e;
+	// Insert a CMPDATA_CONTINUE, or update the one using R4
+	data=for_r4_record(g_fordepth);
+	if (data) {
+		data[1]=(int)&object[0];
+	} else {
+		g_scratch_int[0]=(int)&object[0];
+		e=cmpdata_insert(CMPDATA_CONTINUE,g_fordepth,(int*)&g_scratch_int[0],1);
+		if (e) return e;
+	}
 	// Get "TO" value again
 	source=sbefore;
 	e=get_integer();
@@ -849,20 +1002,30 @@ int for_statement(void){
 		e=get_integer();
 		if (e) return e;
 		// Move r0 to r2
-		check_object(2);
-		(object++)[0]=0x0002;// movs	r2, r0
-		(object++)[0]=0xb404;// push	{r2}
-		// Get r0 from variable
-		e=variable_to_r0(vn);
-		if (e) return e;
-		// Add r2 to r0
 		check_object(1);
-		(object++)[0]=0x1880;// adds	r0, r0, r2
-		// Store r0 to variable
-		e=r0_to_variable(vn);
-		if (e) return e;
-		check_object(1);
-		(object++)[0]=0xbc04;// pop	{r2}
+		(object++)[0]=0x0002;// movs	r2, r0
+		if (vn==g_r4_varnum) {
+			// Add r2 to the counter in memory (see for_r4_record()), and store it to R4 and variable
+			check_object(4);
+			(object++)[0]=0x682c|(vn<<6);  // ldr	r4, [r5, #xx]
+			(object++)[0]=0x18a4;          // adds	r4, r4, r2
+			(object++)[0]=0x602c|(vn<<6);  // str	r4, [r5, #xx]
+			(object++)[0]=0x0020;          // movs	r0, r4
+		} else {
+			check_object(1);
+			(object++)[0]=0xb404;// push	{r2}
+			// Get r0 from variable
+			e=variable_to_r0(vn);
+			if (e) return e;
+			// Add r2 to r0
+			check_object(1);
+			(object++)[0]=0x1880;// adds	r0, r0, r2
+			// Store r0 to variable
+			e=r0_to_variable(vn);
+			if (e) return e;
+			check_object(1);
+			(object++)[0]=0xbc04;// pop	{r2}
+		}
 		// BL jump here
 		update_bl(bl,object);
 		// Pop r1 as "TO" value
@@ -882,6 +1045,24 @@ int for_statement(void){
 		return break_statement();
 		                     // skip2:
 		return 0;
+	} else if (vn==g_r4_varnum) {
+		// STEP 1 using R4
+		// Inc the counter in memory (see for_r4_record()), and store it to R4 and variable
+		check_object(3);
+		(object++)[0]=0x682c|(vn<<6);  // ldr	r4, [r5, #xx]
+		(object++)[0]=0x3401;          // adds	r4, #1
+		(object++)[0]=0x602c|(vn<<6);  // str	r4, [r5, #xx]
+		// BL jump to here
+		update_bl(bl,object);
+		// Pop r1 as "TO" value
+		check_object(1);
+		(object++)[0]=0xbc02;// pop	{r1}
+		// Compare R4 and r1, and break if needed
+		check_object(2);
+		(object++)[0]=0x42a1;// cmp	r1, r4
+		(object++)[0]=0xda01;// bge.n	skip
+		return break_statement();
+		                     // skip:
 	} else {
 		// STEP 1
 		// Get r0 from variable
@@ -953,10 +1134,7 @@ int resolve_if_bl(void){
 	int* data;
 	short* bl;
 	// Find a CMPDATA_IF_BL
-	cmpdata_reset();
-	while(data=cmpdata_find(CMPDATA_IF_BL)){
-		if ((data[0]&0xffff)==g_ifdepth) break;
-	}
+	data=cmpdata_findfirst_with_id(CMPDATA_IF_BL,g_ifdepth);
 	if (!data) return ERROR_SYNTAX;
 	// Found a CMPDATA_IF_BL
 	bl=(short*)data[1];
@@ -987,12 +1165,7 @@ int endif_statement(void){;
 	// It may not exist as ELSE might take it
 	resolve_if_bl();
 	// Resolve all CMPDATA_ENDIF_BL(s)
-	while(1){
-		cmpdata_reset();
-		while(data=cmpdata_find(CMPDATA_ENDIF_BL)){
-			if ((data[0]&0xffff)==g_ifdepth) break;
-		}
-		if (!data) break;
+	while(data=cmpdata_findfirst_with_id(CMPDATA_ENDIF_BL,g_ifdepth)){
 		// Found a CMPDATA_ENDIF_BL
 		bl=(short*)data[1];
 		// Update it
@@ -1001,10 +1174,7 @@ int endif_statement(void){;
 		cmpdata_delete(data);
 	}
 	// Confirm not remaining
-	cmpdata_reset();
-	while(data=cmpdata_find(CMPDATA_IF_BL)){
-		if ((data[0]&0xffff)==g_ifdepth) return ERROR_UNKNOWN;
-	}
+	if (cmpdata_findfirst_with_id(CMPDATA_IF_BL,g_ifdepth)) return ERROR_UNKNOWN;
 	// All done. Lower the depth
 	g_ifdepth--;
 	return 0;
@@ -1027,9 +1197,9 @@ int if_statement(void){
 		if (!instruction_is("THEN")) return ERROR_SYNTAX;
 	}
 	// r0 is set. Let's branch here
-	check_object(2);
-	(object++)[0]=0x2800;// cmp	r0, #0
-	(object++)[0]=0xd101;// bne.n	skip
+	// cmp	r0, #0 and bne.n	skip, or faster codes (see peephole.c)
+	e=peephole_branch(0xd101);
+	if (e) return e;
 	// Inseret BL instruction and CMPDATA_IF_BL
 	e=insert_if_bl();
 	                     // skip:
@@ -1183,7 +1353,9 @@ int let_string(int vn){
 			if (e) return e;
 			e=set_value_in_register(1,vn);
 			if (e) return e;
-			return call_lib_code(LIB_LET_STR);
+			e=call_lib_code(LIB_LET_STR);
+			if (e) return e;
+			return for_r4_assigned(vn);
 		case '(': // string array (not supported)
 		default:
 			source--;
@@ -1451,6 +1623,8 @@ int dim_statement(void){
 		e=call_lib_code(LIB_DIM);
 		obefore[0]=0xb080 | i; // sub	sp, #xx
 		(object++)[0] =0xb000 | i; // add	sp, #xx
+		e=for_r4_assigned(vn);
+		if (e) return e;
 	} while (','==(source++)[0]);
 	source--;
 	return 0;
@@ -1481,6 +1655,132 @@ int end_of_statement(void){
 	return 0;
 }
 
+/*
+	Statement keywords
+	The keyword at the beginning of a statement is picked up once, and the
+	compiling function is found by binary search in the table below.
+	Keep the table in ASCII order (same as g_reserved_words).
+*/
+
+int print_lib_statement(void){
+	return print_statement(LIB_PRINT);
+}
+
+int fprint_statement(void){
+	return print_statement(LIB_FPRINT);
+}
+
+const struct {
+	const char* keyword;
+	int (*function)(void);
+} g_statement_keywords[]={
+	{"ALIGN4",align4_statement},
+	{"BREAK",break_statement},
+	{"CALL",call_statement},
+	{"CDATA",cdata_statement},
+	{"CONTINUE",continue_statement},
+	{"CORETIMER",coretimer_statement},
+	{"DATA",data_statement},
+	{"DEBUG",debug_statement},
+	{"DELAYMS",delayms_statement},
+	{"DELAYUS",delayus_statement},
+	{"DELETE",delete_statement},
+	{"DIM",dim_statement},
+	{"DO",do_statement},
+	{"DRAWCOUNT",drawcount_statement},
+	{"ELSE",else_statement},
+	{"ELSEIF",elseif_statement},
+	{"END",end_statement},
+	{"ENDIF",endif_statement},
+	{"EXEC",exec_statement},
+	{"FCLOSE",fclose_statement},
+	{"FGET",fget_function},
+	{"FIELD",field_statement},
+	{"FILE",file_statement},
+	{"FOPEN",fopen_function},
+	{"FOR",for_statement},
+	{"FPRINT",fprint_statement},
+	{"FPUT",fput_function},
+	{"FPUTC",fputc_function},
+	{"FREMOVE",fremove_function},
+	{"FRENAME",frename_function},
+	{"FSEEK",fseek_statement},
+	{"GOSUB",gosub_statement},
+	{"GOTO",goto_statement},
+	{"IDLE",idle_statement},
+	{"IF",if_statement},
+	{"INTERRUPT",interrupt_statement},
+	{"LABEL",label_statement},
+	{"LET",let_statement},
+	{"LOOP",loop_statement},
+	{"METHOD",method_statement},
+	{"MKDIR",mkdir_function},
+	{"MUSIC",music_statement},
+	{"NEXT",next_statement},
+	{"OPTION",option_statement},
+	{"PLAYWAVE",playwave_statement},
+	{"POKE",poke_statement},
+	{"POKE16",poke16_statement},
+	{"POKE32",poke32_statement},
+	{"PRINT",print_lib_statement},
+	{"REM",rem_statement},
+	{"RESTORE",restore_statement},
+	{"RETURN",return_statement},
+	{"SETDIR",setdir_function},
+	{"SETTIME",settime_statement},
+	{"SOUND",sound_statement},
+	{"STATIC",static_statement},
+	{"SYSTEM",system_statement},
+	{"TIMER",timer_statement},
+	{"USECLASS",useclass_statement},
+	{"USETIMER",usetimer_statement},
+	{"USEVAR",usevar_statement},
+	{"VAR",var_statement},
+	{"WAIT",wait_statement},
+	{"WEND",wend_statement},
+	{"WHILE",while_statement},
+};
+
+int (*statement_keyword(void))(void){
+	int n,i,c,left,right,mid;
+	const char* keyword;
+	skip_blank();
+	// Pick up a word
+	for(n=0;'A'<=source[n] && source[n]<='Z' || '0'<=source[n] && source[n]<='9' || '_'==source[n];n++);
+	if (!n) return 0;
+	// Next code must not be character for statement (see instruction_is())
+	switch(source[n]){
+		case 0x20:
+		case 0x00:
+		case ':':
+		case ',':
+			break;
+		default:
+			return 0;
+	}
+	// Binary search
+	left=0;
+	right=sizeof g_statement_keywords/sizeof g_statement_keywords[0];
+	while(left<right){
+		mid=(left+right)>>1;
+		keyword=g_statement_keywords[mid].keyword;
+		for(i=0;i<n;i++){
+			c=keyword[i]-source[i];
+			if (c) break;
+		}
+		if (i==n) c=keyword[n];
+		if (0==c) {
+			// Found. Skip the keyword
+			source+=n;
+			skip_blank();
+			return g_statement_keywords[mid].function;
+		}
+		if (0<c) right=mid;
+		else left=mid+1;
+	}
+	return 0;
+}
+
 int compile_statement(void){
 	int (*f)(void) = g_multiple_statement;
 	int e;
@@ -1489,82 +1789,14 @@ int compile_statement(void){
 	unsigned char* bsrc=source;
 	// Check if multiple statement, first
 	if (g_multiple_statement) return f();
-	// Check LET statement, first
-	if (instruction_is("LET")) return let_statement();
+	// Check the statement keyword. Note that a variable name cannot be a reserved word.
+	f=statement_keyword();
+	if (f) return f();
 	// "LET" may be omitted.
 	e=let_statement();
 	if (!e) return 0;
 	rewind_object(bobj);
 	source=bsrc;
-	// It's not LET statement. Let's continue for possibilities of the other statements.
-	if (instruction_is("ALIGN4")) return align4_statement();
-	if (instruction_is("BREAK")) return break_statement();
-	if (instruction_is("CALL")) return call_statement();
-	if (instruction_is("CDATA")) return cdata_statement();
-	if (instruction_is("CONTINUE")) return continue_statement();
-	if (instruction_is("DATA")) return data_statement();
-	if (instruction_is("DEBUG")) return debug_statement();
-	if (instruction_is("DELETE")) return delete_statement();
-	if (instruction_is("DIM")) return dim_statement();
-	if (instruction_is("DO")) return do_statement();
-	if (instruction_is("DRAWCOUNT")) return drawcount_statement();
-	if (instruction_is("ELSE")) return else_statement();
-	if (instruction_is("ELSEIF")) return elseif_statement();
-	if (instruction_is("END")) return end_statement();
-	if (instruction_is("ENDIF")) return endif_statement();
-	if (instruction_is("EXEC")) return exec_statement();
-	if (instruction_is("FIELD")) return field_statement();
-	if (instruction_is("FOR")) return for_statement();
-	if (instruction_is("GOSUB")) return gosub_statement();
-	if (instruction_is("GOTO")) return goto_statement();
-	if (instruction_is("IDLE")) return idle_statement();
-	if (instruction_is("IF")) return if_statement();
-	if (instruction_is("LABEL")) return label_statement();
-	if (instruction_is("LOOP")) return loop_statement();
-	if (instruction_is("METHOD")) return method_statement();
-	if (instruction_is("NEXT")) return next_statement();
-	if (instruction_is("OPTION")) return option_statement();
-	if (instruction_is("POKE")) return poke_statement();
-	if (instruction_is("POKE16")) return poke16_statement();
-	if (instruction_is("POKE32")) return poke32_statement();
-	if (instruction_is("PRINT")) return print_statement(LIB_PRINT);
-	if (instruction_is("REM")) return rem_statement();
-	if (instruction_is("RESTORE")) return restore_statement();
-	if (instruction_is("RETURN")) return return_statement();
-	if (instruction_is("STATIC")) return static_statement();
-	if (instruction_is("SYSTEM")) return system_statement();
-	if (instruction_is("USECLASS")) return useclass_statement();
-	if (instruction_is("USEVAR")) return usevar_statement();
-	if (instruction_is("VAR")) return var_statement();
-	if (instruction_is("WAIT")) return wait_statement();
-	if (instruction_is("DELAYUS")) return delayus_statement();
-	if (instruction_is("DELAYMS")) return delayms_statement();
-	if (instruction_is("WEND")) return wend_statement();
-	if (instruction_is("WHILE")) return while_statement();
-	// File statements
-	if (instruction_is("FCLOSE")) return fclose_statement();
-	if (instruction_is("FGET")) return fget_function();
-	if (instruction_is("FILE")) return file_statement();
-	if (instruction_is("FOPEN")) return fopen_function();
-	if (instruction_is("FPRINT")) return print_statement(LIB_FPRINT);
-	if (instruction_is("FPUT")) return fput_function();
-	if (instruction_is("FPUTC")) return fputc_function();
-	if (instruction_is("FREMOVE")) return fremove_function();
-	if (instruction_is("FSEEK")) return fseek_statement();
-	if (instruction_is("SETDIR")) return setdir_function();
-	if (instruction_is("FRENAME")) return frename_function();
-	if (instruction_is("MKDIR")) return mkdir_function();
-	// Timer and interrupt statements
-	if (instruction_is("USETIMER")) return usetimer_statement();
-	if (instruction_is("TIMER")) return timer_statement();
-	if (instruction_is("INTERRUPT")) return interrupt_statement();
-	if (instruction_is("CORETIMER")) return coretimer_statement();
-	// Music statements
-	if (instruction_is("MUSIC")) return music_statement();
-	if (instruction_is("SOUND")) return sound_statement();
-	if (instruction_is("PLAYWAVE")) return playwave_statement();
-	// RTC statement
-	if (instruction_is("SETTIME")) return settime_statement();
 	// IO statements
 	e=io_statements();
 	if (e!=ERROR_STATEMENT_NOT_DETECTED) return e;
@@ -13,6 +13,8 @@ static struct repeating_timer g_timer;
 static int g_timer_counter;
 static struct repeating_timer g_drawcount_timer;
 static unsigned short g_drawcount;
+static volatile char g_vsync_detected;
+static volatile unsigned int g_vsync_time;
 static void* g_interrupt_vector[7];
 static struct repeating_timer g_coretimer_timer;
 static unsigned int g_interrupt_flags;
@@ -124,10 +126,11 @@ bool repeating_timer_callback(struct repeating_timer *t) {
 	return true;
 }
 
-bool repeating_drawcount_callback(struct repeating_timer *t) {
+static void drawcount_interrupt(void) {
 	static char s_keys=-1;
 	char keys;
 	g_drawcount++;
+	textqueue_flush();
 	if (g_interrupt_vector[INTERRUPT_DRAWCOUNT]) call_interrupt_function(g_interrupt_vector[INTERRUPT_DRAWCOUNT]);
 	if (g_interrupt_vector[INTERRUPT_KEYS]) {
 		keys=lib_keys(63,0,0);
@@ -151,9 +154,28 @@ bool repeating_drawcount_callback(struct repeating_timer *t) {
 		if (check_keypress()) call_interrupt_function(g_interrupt_vector[INTERRUPT_INKEY]);
 		drop_interrupt_flag(INTERRUPT_INKEY);
 	}
+}
+
+bool repeating_drawcount_callback(struct repeating_timer *t) {
+	// Used while /VSYNC from the NTSC display is not detected
+	// If /VSYNC stops for about 2 frames (e.g. reset of the display or its cable),
+	// the timer drives DRAWCOUNT again
+	if (g_vsync_detected) {
+		if (time_us_32()-g_vsync_time<33334) return true;
+		g_vsync_detected=0;
+	}
+	drawcount_interrupt();
 	return true;
 }
 
+static void vsync_callback(void) {
+	// Falling edge of /VSYNC from the NTSC display (59.94 Hz)
+	// This replaces the timer, so DRAWCOUNT is synchronized to the display
+	g_vsync_time=time_us_32();
+	g_vsync_detected=1;
+	drawcount_interrupt();
+}
+
 int64_t alarm_coretimer_callback(alarm_id_t id, void *user_data) {
 	if (g_interrupt_vector[INTERRUPT_CORETIMER]) call_interrupt_function(g_interrupt_vector[INTERRUPT_CORETIMER]);
 	return 0;
@@ -179,7 +201,10 @@ void timer_init(void){
 	for(i=0;i<(sizeof g_interrupt_vector)/(sizeof g_interrupt_vector[0]);i++) g_interrupt_vector[i]=0;
 	g_interrupt_flags=0;
 	// Start drawcount interrupt (every 1/60 sec)
+	// The timer is used while /VSYNC from the NTSC display is not detected
+	g_vsync_detected=0;
 	add_repeating_timer_us(-16667, repeating_drawcount_callback, NULL, &g_drawcount_timer);
+	parallel_vsync_init(vsync_callback);
 }
 
 int lib_timer(int r0, int r1, int r2){
@@ -105,6 +105,8 @@ int end_of_value(void){
 
 // Pointer to stack subtraction code
 static unsigned short* g_scodeaddr;
+// Pointer to the last "str r0, [sp, #xx]" code
+static unsigned short* g_spushaddr;
 
 int value_push_r0(void){
 	check_object(2);
@@ -113,6 +115,7 @@ int value_push_r0(void){
 		g_scodeaddr=object;
 		(object++)[0]=0xb080; // sub	sp, #xx
 	}
+	g_spushaddr=object;
 	(object++)[0]=0x9000 | g_sdepth; // str	r0, [sp, #xx]
 	g_sdepth++;
 	if (g_maxsdepth<g_sdepth) g_maxsdepth=g_sdepth;
@@ -120,8 +123,20 @@ int value_push_r0(void){
 }
 
 int value_pop_r1(void){
-	check_object(1);
+	unsigned short* spushaddr=g_spushaddr;
+	g_spushaddr=0;
 	g_sdepth--;
+	if (spushaddr && peephole_is_simple_value(spushaddr+1)) {
+		// Only a constant or a variable value is set to r0 after pushing r0.
+		// Use "movs r1, r0" instead of pushing and popping (see peephole.c)
+		if (1==g_maxsdepth && g_scodeaddr+1==spushaddr) {
+			// Stack isn't used any more
+			g_maxsdepth=0;
+			spushaddr=g_scodeaddr;
+		}
+		return peephole_r0_to_r1(spushaddr);
+	}
+	check_object(1);
 	(object++)[0]=0x9900 | g_sdepth; // ldr	r1, [sp, #xx]
 	return 0;
 }
@@ -201,7 +216,9 @@ int get_value(int vmode){
 	int prev_sdepth=g_sdepth;
 	int prev_maxsdepth=g_maxsdepth;
 	unsigned short* prev_scodeaddr=g_scodeaddr;
+	unsigned short* prev_spushaddr=g_spushaddr;
 	g_sdepth=g_maxsdepth=0;
+	g_spushaddr=0;
 	// Raise constant flag, first
 	g_constant_value_flag=1;
 	// Get value
@@ -214,6 +231,7 @@ int get_value(int vmode){
 	g_sdepth=prev_sdepth;
 	g_maxsdepth=prev_maxsdepth;
 	g_scodeaddr=prev_scodeaddr;
+	g_spushaddr=prev_spushaddr;
 	// Everything done
 	return e;
 }
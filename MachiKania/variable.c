@@ -82,11 +82,13 @@ int get_var_number(void){
 int r0_to_variable(int vn){
 	int e;
 	if (vn<32) {
-		check_object(4);
+		check_object(5);
 		(object++)[0]=0x6028 | (vn<<6); // str	r0, [r5, #xx]
 		(object++)[0]=0x2300;           // movs	r3, #0
 		(object++)[0]=0x68ba;           // ldr	r2, [r7, #8]
 		(object++)[0]=0x8013 | (vn<<6); // strh	r3, [r2, #xx]
+		// Write-through when the variable is kept in R4 (see for_r4_record() in statements.c)
+		if (vn==g_r4_varnum) (object++)[0]=0x0004; // movs	r4, r0
 		return 0;
 	} else if (vn<256) {
 		e=set_value_in_register(1,vn*4);
@@ -102,7 +104,12 @@ int r0_to_variable(int vn){
 }
 int variable_to_r0(int vn){
 	int e;
-	if (vn<32) {
+	if (vn==g_r4_varnum) {
+		// The variable is kept in R4 (see for_r4_record() in statements.c)
+		check_object(1);
+		(object++)[0]=0x0020;           // movs	r0, r4
+		return 0;
+	} else if (vn<32) {
 		check_object(1);
 		(object++)[0]=0x6828 | (vn<<6); // ldr	r0, [r5, #xx]
 		return 0;
@@ -114,3 +121,11 @@ int variable_to_r0(int vn){
 		return 0;
 	} else return ERROR_UNKNOWN;
 }
+
+int reload_r4(void){
+	// Load the FOR loop counter to R4 again from memory (see for_r4_record() in statements.c)
+	if (g_r4_varnum<0) return 0;
+	check_object(1);
+	(object++)[0]=0x682c | (g_r4_varnum<<6); // ldr	r4, [r5, #xx]
+	return 0;
+}
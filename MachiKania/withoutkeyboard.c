@@ -59,6 +59,8 @@ int lib_input(int r0, int r1, int r2){
 	unsigned char* str=alloc_memory(4,-1);
 	unsigned char* str2;
 	int c;
+	// Show all characters before waiting
+	textqueue_flush();
 	while(1){
 		// Get a character from console
 		c=getchar_timeout_us(1000);
@@ -0,0 +1,77 @@
+/*
+	Benchmark of the BASIC compiler on the host
+	Compiles each BASIC file given as an argument (MachiKania/samples) many
+	times, and shows the lines compiled per second. The time is of the host
+	CPU, so compare the numbers before and after a change of the compiler,
+	not with the RP2040.
+
+	A file using a class that is not found (the class files are on the SD
+	card, not in this repository) is skipped. Any other error fails.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "compiler.h"
+#include "kmbasic_host.h"
+
+#define BENCH_SECONDS 0.2 // Time to compile each file
+
+static double seconds(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+static int count_lines(const char* file){
+	FILE* fp;
+	int c,n;
+	fp=fopen(file,"rb");
+	if (!fp) return 0;
+	n=0;
+	while(EOF!=(c=fgetc(fp))){
+		if ('\n'==c) n++;
+	}
+	fclose(fp);
+	return n;
+}
+
+int main(int argc,char* argv[]){
+	int i,k,e,size,lines,errors,files;
+	long total_lines;
+	double t,total_time;
+	const char* name;
+	errors=files=0;
+	total_lines=0;
+	total_time=0;
+	for(i=1;i<argc;i++){
+		name=strrchr(argv[i],'/') ? strrchr(argv[i],'/')+1:argv[i];
+		e=kmbasic_compile(argv[i],&size);
+		if (e) {
+			if (strstr(kmbasic_messages,"Class file not found")) {
+				printf("compile_bench: %-12s skipped (class file not found)\n",name);
+				continue;
+			}
+			printf("compile_bench: %-12s error %d: %s\n",name,e,kmbasic_messages);
+			errors++;
+			continue;
+		}
+		lines=count_lines(argv[i]);
+		t=seconds();
+		for(k=0;seconds()-t<BENCH_SECONDS;k++) kmbasic_compile(argv[i],&size);
+		t=(seconds()-t)/k;
+		printf("compile_bench: %-12s %5d lines %7d bytes %8.1f us %9.0f lines/s\n",
+			name,lines,size,t*1e6,lines/t);
+		files++;
+		total_lines+=lines;
+		total_time+=t;
+	}
+	if (files) printf("compile_bench: %d files %ld lines %.1f ms %.0f lines/s\n",
+		files,total_lines,total_time*1e3,total_lines/total_time);
+	if (errors) {
+		printf("compile_bench: %d errors\n",errors);
+		return 1;
+	}
+	printf("compile_bench: OK\n");
+	return 0;
+}
@@ -0,0 +1,427 @@
+/*
+	Co-simulation of MachiKania (master) and the NTSC board (slave)
+
+	Threads:
+		bus:   runs the simulated chips (sim_run()) and the IRQs of master
+		video: core0 of slave; calls the DMA IRQ handler of NTSC signal once
+		       per scanline, and keeps the samples made by makeDmaBuffer()
+		core1: main_loop() of slave
+		main:  scenarios of master (cosim_master.c)
+
+	The CPUs take no simulated time; only the bus, PIO, and DMA do. So the
+	throughput below is the limit of the interface, not of the drawing.
+
+	Output (in build/, <name> is the name of the program, e.g. cosim):
+		<name>_<checkpoint>.ppm: screen decoded from the NTSC samples
+		<name>_metrics.csv:      bytes, handshakes, and throughput of each checkpoint
+		<name>_commands.csv:     number and bytes of each command
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "rp2040_pwm_ntsc_textgraph.h"
+#include "hardware/sync.h"
+#include "sim_chip.h"
+#include "cosim.h"
+
+#define OUTPUT_DIR "build/"
+
+// Master
+#define MASTER_DC_PIN 10
+#define MASTER_WR_PIN 11
+#define MASTER_RD_PIN 13
+
+// Pairs of (master pin, slave pin)
+static const int g_wire[]={
+	0,0, 1,1, 2,2, 3,3, 4,4, 5,5, 6,6, 7,7,
+	10,8,  // DC
+	11,9,  // /WR
+	13,10, // /RD
+	12,11, // /BUSY
+	15,12, // /VSYNC
+};
+
+#define BUS_BATCH 1000 // Master cycles run at once by the bus thread
+
+static volatile bool g_slave_ready;
+static volatile bool g_bus_stop;
+static int g_errors;
+static const char* g_checkpoint="init";
+static const char* g_name;
+
+// Samples of each scanline (index is the line number given to makeDmaBuffer())
+static uint16_t g_lines[NUM_LINES][NUM_LINE_SAMPLES];
+
+// Words on the bus
+#define STREAM_SIZE 65536
+static unsigned short g_stream[STREAM_SIZE];
+static unsigned int g_stream_head,g_stream_tail;
+static unsigned long long g_stream_errors;
+
+// Statistics of commands (0x00-0x7F are characters of COMMAND_PRINTCHAR)
+static unsigned long long g_command_num[256];
+static unsigned long long g_command_bytes[256];
+static unsigned long long g_bytes;
+static int g_command;
+
+typedef struct {
+	unsigned long long bytes,commands,handshakes,reads,busy_stalls,cycles;
+} metrics;
+static metrics g_last;
+static FILE* g_metrics_fp;
+
+static void error(const char* msg){
+	printf("%s: %s: %s\n",g_name,g_checkpoint,msg);
+	g_errors++;
+}
+
+/*
+	Bus
+*/
+
+static void on_send(uint32_t word){
+	unsigned int w=(word&0xff)|(((word>>MASTER_DC_PIN)&1)<<8);
+	if (w&0x100) {
+		g_command=w&0xff;
+		g_command_num[g_command]++;
+	}
+	g_command_bytes[g_command]++;
+	g_bytes++;
+	if (STREAM_SIZE<=g_stream_head-g_stream_tail) {
+		g_stream_errors++;
+		return;
+	}
+	g_stream[g_stream_head++%STREAM_SIZE]=w;
+}
+
+static void on_receive(uint32_t word){
+	// Slave receives 8 bit data and DC in bit 8
+	if (g_stream_head==g_stream_tail || g_stream[g_stream_tail++%STREAM_SIZE]!=(word&0x1ff)) g_stream_errors++;
+}
+
+static void* bus_thread(void* arg){
+	while(!g_bus_stop){
+		sim_run(BUS_BATCH);
+		sim_deliver_irqs(&sim_master);
+		sched_yield();
+	}
+	return 0;
+}
+
+/*
+	Slave
+*/
+
+static unsigned long long slave_cycles(void){
+	return *(volatile unsigned long long*)&sim_slave.cycles;
+}
+
+static void* video_thread(void* arg){
+	int chan[2],num,ch,k;
+	unsigned long long next;
+	sim_set_chip(&sim_slave);
+	cosim_slave_init();
+	// Two channels of PWM play the DMA buffers alternately
+	num=0;
+	for(ch=0;ch<NUM_DMA_CHANNELS && num<2;ch++){
+		if (DREQ_PWM_WRAP0<=sim_slave.dma_ch[ch].config.dreq && DREQ_FORCE!=sim_slave.dma_ch[ch].config.dreq) chan[num++]=ch;
+	}
+	if (num<2) {
+		fprintf(stderr,"%s: DMA channels of PWM are not found\n",g_name);
+		exit(1);
+	}
+	g_slave_ready=true;
+	next=slave_cycles();
+	for(k=0;;k++){
+		next+=LINE_CYCLES;
+		while(slave_cycles()<next) sim_poll();
+		// The channel that finished plays the buffer made by the handler
+		// after the other one, so the k-th call makes line k
+		ch=chan[k&1];
+		sim_lock();
+		sim_slave.dma.ints0=1u<<ch;
+		sim_unlock();
+		sim_call_irq(&sim_slave,DMA_IRQ_0);
+		memcpy(g_lines[k%NUM_LINES],(void*)(uintptr_t)sim_slave.dma.ch[ch].read_addr,sizeof g_lines[0]);
+	}
+	return 0;
+}
+
+static void* core1_thread(void* arg){
+	sim_set_chip(&sim_slave);
+	cosim_slave_main_loop();
+	return 0;
+}
+
+void cosim_wait_frames(int n){
+	unsigned long long t=slave_cycles()+(unsigned long long)n*NUM_LINES*LINE_CYCLES;
+	while(slave_cycles()<t) sched_yield();
+}
+
+/*
+	Interrupt of the master
+	The handler is called at random when the master enables the interrupts
+	again, as a pending IRQ would be taken there. So it runs between any two
+	critical sections of the master, but never inside one.
+*/
+
+static void (*g_interrupt_handler)(void);
+static bool g_interrupt_running;
+static int g_interrupt_count;
+static unsigned int g_interrupt_random;
+
+static void interrupt_hook(void){
+	unsigned int s;
+	// IRQs of the same priority are not nested
+	if (g_interrupt_running) return;
+	g_interrupt_random=g_interrupt_random*1103515245+12345;
+	if ((g_interrupt_random>>16)&3) return;
+	g_interrupt_running=true;
+	s=save_and_disable_interrupts();
+	g_interrupt_handler();
+	restore_interrupts(s);
+	g_interrupt_running=false;
+	g_interrupt_count++;
+}
+
+void cosim_start_interrupt(void (*handler)(void)){
+	g_interrupt_handler=handler;
+	g_interrupt_count=0;
+	g_interrupt_random=1;
+	sim_master.irq_enabled_hook=interrupt_hook;
+}
+
+int cosim_stop_interrupt(void){
+	sim_master.irq_enabled_hook=0;
+	return g_interrupt_count;
+}
+
+/*
+	Decoding NTSC signal
+	Four samples make a cycle of the color subcarrier. Each sample is
+	Y+A, Y+B, Y-A, or Y-B (see set_palette() in rp2040_pwm_ntsc_textgraph.c).
+*/
+
+static void decode(int x,int y,unsigned char* rgb){
+	const uint16_t* s=g_lines[V_SYNC+V_PREEQ+y]+H_PICTURE;
+	double w[4],yy,a,b,u,v,c[3];
+	int i,k;
+	// Window of 4 samples from sample x-1 (H_PICTURE is multiple of 4)
+	k=x-1;
+	if (k<0) k=0;
+	if (FRAME_WIDTH*2-4<k) k=FRAME_WIDTH*2-4;
+	for(i=0;i<4;i++) w[(k+i)&3]=s[k+i];
+	yy=((w[0]+w[1]+w[2]+w[3])/4-2)*65536/1792;
+	a=(w[0]-w[2])/2*65536;
+	b=(w[1]-w[3])/2*65536;
+	// a=441*(B-Y)+1361*(R-Y), b=764*(B-Y)-786*(R-Y)
+	u=(a*-786-1361*b)/-1386430;
+	v=(441*b-764*a)/-1386430;
+	c[2]=u+yy;
+	c[0]=v+yy;
+	c[1]=(256*yy-29*c[2]-77*c[0])/150;
+	for(i=0;i<3;i++) rgb[i]=c[i]<0 ? 0:(255<c[i] ? 255:(unsigned char)(c[i]+0.5));
+}
+
+static unsigned int crc32(unsigned int crc,const unsigned char* p,size_t n){
+	int i;
+	crc=~crc;
+	while(n--){
+		crc^=*p++;
+		for(i=0;i<8;i++) crc=(crc>>1)^(0xedb88320&-(crc&1));
+	}
+	return ~crc;
+}
+
+// Writes PPM (lines are doubled for the aspect ratio), and returns CRC of the image
+static unsigned int write_frame(const char* name){
+	static unsigned char rgb[FRAME_HEIGHT][FRAME_WIDTH*2][3];
+	char file[256];
+	FILE* fp;
+	int x,y;
+	for(y=0;y<FRAME_HEIGHT;y++){
+		for(x=0;x<FRAME_WIDTH*2;x++) decode(x,y,rgb[y][x]);
+	}
+	snprintf(file,sizeof file,OUTPUT_DIR "%s_%s.ppm",g_name,name);
+	fp=fopen(file,"wb");
+	if (fp) {
+		fprintf(fp,"P6\n%d %d\n255\n",FRAME_WIDTH*2,FRAME_HEIGHT*2);
+		for(y=0;y<FRAME_HEIGHT;y++){
+			fwrite(rgb[y],sizeof rgb[y],1,fp);
+			fwrite(rgb[y],sizeof rgb[y],1,fp);
+		}
+		fclose(fp);
+	} else {
+		perror(file);
+	}
+	return crc32(0,(const unsigned char*)rgb,sizeof rgb);
+}
+
+/*
+	Checks called by the master
+*/
+
+void cosim_expect(bool ok,const char* msg){
+	if (!ok) error(msg);
+}
+
+// Color c (0-7: b=bit 0, r=bit 1, g=bit 2 as init_palette()) must be shown
+// at dot (x,y), and at dot (x+1,y)
+void cosim_expect_color(int x,int y,int c){
+	unsigned char rgb[3];
+	int i,d,best,best_d;
+	char msg[64];
+	decode(x*2+1,y,rgb);
+	best=0;
+	best_d=0x7fffffff;
+	for(i=0;i<8;i++){
+		d=(rgb[0]-255*((i>>1)&1))*(rgb[0]-255*((i>>1)&1))+
+			(rgb[1]-255*(i>>2))*(rgb[1]-255*(i>>2))+
+			(rgb[2]-255*(i&1))*(rgb[2]-255*(i&1));
+		if (d<best_d) {
+			best_d=d;
+			best=i;
+		}
+	}
+	snprintf(msg,sizeof msg,"color %d is shown at (%d,%d) instead of %d",best,x,y,c);
+	if (best!=c) error(msg);
+}
+
+static metrics get_metrics(void){
+	metrics m;
+	const pio_sim_sm* sm;
+	sim_lock();
+	m.bytes=g_bytes;
+	m.commands=0;
+	for(int i=0;i<256;i++) m.commands+=g_command_num[i];
+	m.handshakes=sim_master.falls[MASTER_WR_PIN];
+	m.reads=sim_master.falls[MASTER_RD_PIN];
+	sm=sim_find_sm(&sim_master,"parallel_master");
+	m.busy_stalls=sm ? sm->wait_stalls:0;
+	m.cycles=sim_master.cycles;
+	sim_unlock();
+	return m;
+}
+
+unsigned long long cosim_command_bytes(int command){
+	unsigned long long n;
+	sim_lock();
+	n=g_command_bytes[command&0xff];
+	sim_unlock();
+	return n;
+}
+
+/*
+	Returns the number of bytes of TVRAM that differ between master and slave
+	text and color are the text screen of the master.
+	Call this after reading from the slave, so all commands have been executed.
+*/
+int cosim_compare_tvram(const unsigned char* text,const unsigned char* color){
+	int i,diff;
+	diff=0;
+	for(i=0;i<ATTROFFSET;i++){
+		if (text[i]!=cosim_slave_tvram(i)) diff++;
+		if (color[i]!=cosim_slave_tvram(ATTROFFSET+i)) diff++;
+	}
+	return diff;
+}
+
+/*
+	The master calls this after reading from the slave, so all commands
+	have been executed.
+*/
+void cosim_checkpoint(const char* name,const unsigned char* text,const unsigned char* color){
+	metrics m;
+	unsigned int crc;
+	int diff;
+	char msg[64];
+	m=get_metrics();
+	g_checkpoint=name;
+	// Two frames to show the screen from the top
+	cosim_wait_frames(2);
+	crc=write_frame(name);
+	diff=cosim_compare_tvram(text,color);
+	if (diff) {
+		snprintf(msg,sizeof msg,"%d bytes of TVRAM differ",diff);
+		error(msg);
+	}
+	if (g_stream_errors) {
+		snprintf(msg,sizeof msg,"%llu words are lost or changed on the bus",g_stream_errors);
+		error(msg);
+		g_stream_errors=0;
+	}
+	fprintf(g_metrics_fp,"%s,%llu,%llu,%llu,%llu,%llu,%llu,%.0f,%08x\n",name,
+		m.bytes-g_last.bytes,m.commands-g_last.commands,m.handshakes-g_last.handshakes,
+		m.reads-g_last.reads,m.busy_stalls-g_last.busy_stalls,m.cycles-g_last.cycles,
+		(m.cycles-g_last.cycles) ? (double)(m.bytes-g_last.bytes)*1e12/((m.cycles-g_last.cycles)*sim_master.period):0.0,
+		crc);
+	printf("%s: %-11s %7llu bytes %6llu handshakes %8.0f bytes/s  crc %08x\n",g_name,
+		name,m.bytes-g_last.bytes,m.handshakes-g_last.handshakes,
+		(m.cycles-g_last.cycles) ? (double)(m.bytes-g_last.bytes)*1e12/((m.cycles-g_last.cycles)*sim_master.period):0.0,
+		crc);
+	// Waiting time is not counted
+	g_last=get_metrics();
+}
+
+static FILE* open_output(const char* suffix){
+	char file[256];
+	FILE* fp;
+	snprintf(file,sizeof file,OUTPUT_DIR "%s_%s",g_name,suffix);
+	fp=fopen(file,"w");
+	if (!fp) perror(file);
+	return fp;
+}
+
+static void write_commands(void){
+	FILE* fp;
+	int i;
+	unsigned long long n,b;
+	fp=open_output("commands.csv");
+	if (!fp) return;
+	fprintf(fp,"command,number,bytes\n");
+	n=b=0;
+	for(i=0;i<0x80;i++){
+		n+=g_command_num[i];
+		b+=g_command_bytes[i];
+	}
+	if (n) fprintf(fp,"printchar,%llu,%llu\n",n,b);
+	for(i=0x80;i<0x100;i++){
+		if (g_command_num[i]) fprintf(fp,"0x%02X,%llu,%llu\n",i,g_command_num[i],g_command_bytes[i]);
+	}
+	fclose(fp);
+}
+
+int main(int argc,char* argv[]){
+	pthread_t bus,video,core1;
+	g_name=strrchr(argv[0],'/') ? strrchr(argv[0],'/')+1:argv[0];
+	g_metrics_fp=open_output("metrics.csv");
+	if (!g_metrics_fp) return 1;
+	fprintf(g_metrics_fp,"checkpoint,bytes,commands,handshakes,reads,busy_stall_cycles,master_cycles,bytes_per_sec,frame_crc\n");
+	sim_init(g_wire,sizeof g_wire/sizeof g_wire[0]/2);
+	sim_on_send=on_send;
+	sim_on_receive=on_receive;
+	// Slave starts first, as the master resets it
+	pthread_create(&video,0,video_thread,0);
+	while(!g_slave_ready) sched_yield();
+	pthread_create(&bus,0,bus_thread,0);
+	pthread_create(&core1,0,core1_thread,0);
+	sim_set_chip(&sim_master);
+	cosim_master_main(argc,argv);
+	// Stop the slave, then the bus
+	sim_stop=true;
+	pthread_join(core1,0);
+	pthread_join(video,0);
+	g_bus_stop=true;
+	pthread_join(bus,0);
+	fclose(g_metrics_fp);
+	write_commands();
+	if (g_errors) {
+		printf("%s: %d errors\n",g_name,g_errors);
+		return 1;
+	}
+	printf("%s: OK\n",g_name);
+	return 0;
+}
@@ -0,0 +1,32 @@
+/*
+	Co-simulation of MachiKania (master, graphlib.c) and the NTSC board
+	(slave, ntsc/) on a simulated parallel bus
+
+	The master and the slave are linked separately (see Makefile), as both
+	define TVRAM, g_pset(), etc. Only the functions below connect them.
+*/
+
+#ifndef COSIM_H
+#define COSIM_H
+
+#include <stdbool.h>
+
+// cosim_slave.c (linked with the slave)
+void cosim_slave_init(void);
+void cosim_slave_main_loop(void);
+unsigned char cosim_slave_tvram(unsigned int a);
+
+// cosim_master.c (linked with the master)
+void cosim_master_main(int argc,char* argv[]);
+
+// cosim.c
+void cosim_checkpoint(const char* name,const unsigned char* text,const unsigned char* color);
+int cosim_compare_tvram(const unsigned char* text,const unsigned char* color);
+unsigned long long cosim_command_bytes(int command);
+void cosim_wait_frames(int n);
+void cosim_start_interrupt(void (*handler)(void));
+int cosim_stop_interrupt(void);
+void cosim_expect(bool ok,const char* msg);
+void cosim_expect_color(int x,int y,int c);
+
+#endif // COSIM_H
@@ -0,0 +1,292 @@
+/*
+	Scenarios of the master for the co-simulation
+	Each scenario calls the API of graphlib.c, then cosim_checkpoint()
+	compares the screen of the slave with the expected one.
+*/
+
+#include <stdio.h>
+#include "graphlib.h"
+#include "LCDdriver.h"
+#include "config.h"
+#include "cosim.h"
+
+extern unsigned char TVRAM[];
+
+// Defined by the LCD drivers in MachiKania
+int X_RES,Y_RES;
+
+#define COMMAND_SETCURSOR 0x90
+
+static unsigned char g_pcg[8*256];
+static volatile int g_vsync_count;
+
+static void checkpoint(const char* name){
+	// Reading from the slave waits until all commands are executed
+	g_color(0,0);
+	cosim_checkpoint(name,TVRAM,TVRAM+ATTROFFSET);
+}
+
+static void expect_pixel(int x,int y,unsigned int c){
+	char msg[64];
+	snprintf(msg,sizeof msg,"g_color(%d,%d) is not %u",x,y,c);
+	cosim_expect(g_color(x,y)==c,msg);
+}
+
+static void scenario_text(void){
+	int i;
+	cls();
+	for(i=0;i<40;i++){
+		setcursorcolor(1+i%7);
+		printstr((unsigned char*)"Line ");
+		printnum2(i,3);
+		printstr((unsigned char*)" of the text scroll test\n");
+	}
+	windowscroll(3,10);
+	setcursor(5,20,6);
+	printstr((unsigned char*)"CURSOR");
+	checkpoint("text");
+	// Whole screen is sent by COMMAND_TEXTREDRAW(_RLE)
+	textredraw();
+	checkpoint("textredraw");
+}
+
+static void scenario_graphics(void){
+	static const unsigned char bmp[4*4]={
+		1,1,0,0,
+		1,1,0,0,
+		0,0,2,2,
+		0,0,2,2,
+	};
+	cls();
+	g_clearscreen();
+	g_boxfill(0,0,99,49,2);
+	g_boxfill(100,0,199,49,4);
+	g_boxfill(200,0,335,49,1);
+	g_circlefill(60,130,40,7);
+	g_circle(160,130,40,6);
+	g_gline(220,90,330,200,3);
+	g_hline(0,335,215,5);
+	g_pset(300,100,7);
+	g_putbmpmn(240,60,4,4,bmp);
+	g_printstr(100,200,7,0,(unsigned char*)"GRAPHIC");
+	expect_pixel(50,25,2);
+	expect_pixel(150,25,4);
+	expect_pixel(60,130,7);
+	expect_pixel(160,90,6);
+	expect_pixel(300,100,7);
+	expect_pixel(242,62,2);
+	checkpoint("graphics");
+	cosim_expect_color(50,25,2);
+	cosim_expect_color(150,25,4);
+	cosim_expect_color(250,25,1);
+	cosim_expect_color(60,130,7);
+}
+
+static void scenario_blitter(void){
+	static unsigned char pat[16*16];
+	int i;
+	for(i=0;i<16*16;i++) pat[i]=(i&1) ? 3:0;
+	cls();
+	g_clearscreen();
+	g_fill(10,10,109,59,4);
+	g_copy(10,10,100,50,120,10);
+	g_blitpattern(0,16*16,pat);
+	g_blit(240,10,16,16,0,0);
+	g_get(10,10,8,8,1024);
+	g_blit(240,40,8,8,1024,-1);
+	expect_pixel(60,30,4);
+	expect_pixel(170,30,4);
+	expect_pixel(241,10,3);
+	expect_pixel(240,10,0);
+	expect_pixel(244,44,4);
+	checkpoint("blitter");
+	cosim_expect_color(60,30,4);
+	cosim_expect_color(170,30,4);
+}
+
+static void scenario_pages(void){
+	cls();
+	g_drawpage(1);
+	g_clearscreen();
+	g_boxfill(0,0,335,215,2);
+	g_flip();
+	// Page 0 is drawn while page 1 is shown
+	g_boxfill(0,0,335,215,4);
+	expect_pixel(100,100,4);
+	checkpoint("pages");
+	cosim_expect_color(100,100,2);
+	g_flip();
+	g_drawpage(0);
+	g_displaypage(0);
+	checkpoint("pages_flip");
+	cosim_expect_color(100,100,4);
+}
+
+static void scenario_sprites(void){
+	static unsigned char sp[16*16];
+	static unsigned char tile[64];
+	int i;
+	cls();
+	g_clearscreen();
+	for(i=0;i<16*16;i++) sp[i]=(i/16<8) ? 7:1;
+	g_spritepattern(0,16*16,sp);
+	g_spritedefine(0,16,16,0,0);
+	g_spritemove(0,100,100);
+	checkpoint("sprites");
+	cosim_expect_color(104,102,7);
+	cosim_expect_color(104,110,1);
+	g_spritereset();
+	for(i=0;i<64;i++) tile[i]=2;
+	g_tiledefine(1,tile);
+	for(i=0;i<64;i++) tile[i]=4;
+	g_tiledefine(2,tile);
+	for(i=0;i<TILEMAP_WIDTH;i++){
+		g_tileput(i,0,1);
+		g_tileput(i,1,2);
+	}
+	g_tilemode(1);
+	g_tilescroll(0,0);
+	g_linescroll(0,7,4);
+	checkpoint("tiles");
+	cosim_expect_color(20,4,2);
+	cosim_expect_color(20,12,4);
+	g_tilemode(0);
+}
+
+static void scenario_pcg(void){
+	int i;
+	cls();
+	startPCG(g_pcg,1);
+	for(i=0;i<8;i++) g_pcg['A'*8+i]=0xff;
+	pcg_sync();
+	setcursor(0,0,2);
+	printstr((unsigned char*)"AAAA");
+	checkpoint("pcg");
+	cosim_expect_color(2,2,2);
+	stopPCG();
+}
+
+static void scenario_readback(void){
+	int i;
+	char msg[64];
+	cls();
+	setcursor(0,3,3);
+	printstr((unsigned char*)"READ BACK");
+	textqueue_flush();
+	for(i=WIDTH_X*3;i<WIDTH_X*4;i++){
+		snprintf(msg,sizeof msg,"parallel_read_tvram(%d)",i);
+		cosim_expect(parallel_read_tvram(i)==TVRAM[i],msg);
+		snprintf(msg,sizeof msg,"parallel_read_tvram(%d)",WIDTH_X*WIDTH_Y+i);
+		cosim_expect(parallel_read_tvram(WIDTH_X*WIDTH_Y+i)==TVRAM[ATTROFFSET+i],msg);
+	}
+	checkpoint("readback");
+}
+
+static volatile int g_interrupt_prints;
+
+static void interrupt_print(void){
+	// PRINT in an INTERRUPT routine of BASIC
+	int n=g_interrupt_prints++;
+	printchar('0'+n%10);
+	if (0==n%7) setcursorcolor(1+n%7);
+}
+
+static void scenario_interrupt(void){
+	int i,k;
+	char msg[64];
+	cls();
+	cosim_start_interrupt(interrupt_print);
+	// Keep printing until the interrupts have happened enough times
+	for(i=0;i<200 || g_interrupt_prints<50;i++){
+		setcursorcolor(1+i%7);
+		printstr((unsigned char*)"Interrupted text ");
+		printnum(i);
+		if (0==i%3) setcursor(i%WIDTH_X,i%WIDTH_Y,7);
+		if (0==i%5) printchar('\n');
+	}
+	k=cosim_stop_interrupt();
+	snprintf(msg,sizeof msg,"interrupt is called %d times",k);
+	cosim_expect(50<=k,msg);
+	checkpoint("interrupt");
+}
+
+static volatile int g_interrupt_reads;
+static volatile int g_interrupt_read_errors;
+
+static void interrupt_read(void){
+	// POINT or READ_TVRAM in an INTERRUPT routine of BASIC
+	int i=(g_interrupt_reads++*37)%(WIDTH_X*WIDTH_Y);
+	if (parallel_read_tvram(i)!=TVRAM[i]) g_interrupt_read_errors++;
+	parallel_read_status(NTSC_STATUS_DRAWCOUNT);
+}
+
+static void scenario_interrupt_read(void){
+	// A read between the command and /RD of another read makes the
+	// slave discard the data, and the first read waits for ever
+	int i,k;
+	char msg[64];
+	g_interrupt_read_errors=0;
+	cosim_start_interrupt(interrupt_read);
+	for(i=0;i<200 || g_interrupt_reads<50;i++){
+		k=(i*53)%(WIDTH_X*WIDTH_Y);
+		snprintf(msg,sizeof msg,"parallel_read_tvram(%d)",k);
+		cosim_expect(parallel_read_tvram(k)==TVRAM[k],msg);
+		g_color(i%X_RES,i%Y_RES);
+	}
+	cosim_stop_interrupt();
+	cosim_expect(0==g_interrupt_read_errors,"parallel_read_tvram() in interrupt");
+	checkpoint("interrupt_read");
+}
+
+static void scenario_merge(void){
+	unsigned long long n;
+	cls();
+	setcursor(0,5,3);
+	printstr((unsigned char*)"ABCDEFGHIJKLMNOPQRST");
+	setcursor(3,5,3);
+	printchar('X');
+	parallel_flush();
+	// Skipping a few characters of the same color needs no SETCURSOR
+	n=cosim_command_bytes(COMMAND_SETCURSOR);
+	setcursor(6,5,3);
+	printchar('Y');
+	setcursor(9,5,3);
+	printchar('Z');
+	setcursor(12,5,3);
+	printchar('W');
+	parallel_flush();
+	cosim_expect(n==cosim_command_bytes(COMMAND_SETCURSOR),"SETCURSOR is sent for a cursor near the last character");
+	checkpoint("merge");
+}
+
+static void vsync_callback(void){
+	g_vsync_count++;
+}
+
+static void scenario_vsync(void){
+	unsigned int d1,d2;
+	d1=parallel_read_status(NTSC_STATUS_DRAWCOUNT);
+	g_vsync_count=0;
+	parallel_vsync_init(vsync_callback);
+	cosim_wait_frames(5);
+	parallel_vsync_init(0);
+	d2=parallel_read_status(NTSC_STATUS_DRAWCOUNT);
+	cosim_expect(4<=g_vsync_count && g_vsync_count<=6,"VSYNC callback is not called once per frame");
+	cosim_expect(4<=(unsigned short)(d2-d1) && (unsigned short)(d2-d1)<=6,"DRAWCOUNT does not count the frames");
+	checkpoint("vsync");
+}
+
+void cosim_master_main(int argc,char* argv[]){
+	init_textgraph(0);
+	scenario_text();
+	scenario_graphics();
+	scenario_blitter();
+	scenario_pages();
+	scenario_sprites();
+	scenario_pcg();
+	scenario_readback();
+	scenario_vsync();
+	scenario_merge();
+	scenario_interrupt();
+	scenario_interrupt_read();
+}
@@ -0,0 +1,26 @@
+/*
+	Entry points of the slave (ntsc/) for the co-simulation
+	main.c of the slave is replaced by the threads of cosim.c.
+*/
+
+#include "rp2040_pwm_ntsc_textgraph.h"
+#include "text_graph_library.h"
+#include "cosim.h"
+
+void interface_init(void);
+void main_loop(void);
+
+// Core0: rp2040_pwm_ntsc_init() registers the DMA IRQ handler of NTSC signal
+void cosim_slave_init(void){
+	rp2040_pwm_ntsc_init();
+	interface_init();
+}
+
+// Core1
+void cosim_slave_main_loop(void){
+	main_loop();
+}
+
+unsigned char cosim_slave_tvram(unsigned int a){
+	return *tvram_cell(a);
+}
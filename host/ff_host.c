@@ -0,0 +1,118 @@
+/*
+	FatFs functions used by the compiler (file.c), on the host file system
+	The root directory of the drive is set by ff_host_root(). The current
+	directory and the file names are the ones of FatFs ("/", "/lib/...").
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "ff.h"
+#include "ff_host.h"
+
+#define MAX_FILES 4
+
+static char g_root[256];
+static char g_cwd[256]="/";
+static struct {
+	FIL* fp;
+	FILE* file;
+} g_files[MAX_FILES];
+
+void ff_host_root(const char* dir){
+	snprintf(g_root,sizeof g_root,"%s",dir);
+	strcpy(g_cwd,"/");
+}
+
+// Host path of the FatFs path
+static void host_path(char* buff,int size,const TCHAR* path){
+	if ('/'==path[0]) snprintf(buff,size,"%s%s",g_root,(const char*)path);
+	else if (g_cwd[1]) snprintf(buff,size,"%s%s/%s",g_root,g_cwd,(const char*)path);
+	else snprintf(buff,size,"%s/%s",g_root,(const char*)path);
+}
+
+FRESULT f_mount(FATFS* fs,const TCHAR* path,BYTE opt){
+	return FR_OK;
+}
+
+FRESULT f_open(FIL* fp,const TCHAR* path,BYTE mode){
+	char file[512];
+	struct stat st;
+	int i;
+	if (mode!=FA_READ) return FR_DENIED;
+	host_path(file,sizeof file,path);
+	if (stat(file,&st) || !S_ISREG(st.st_mode)) return FR_NO_FILE;
+	for(i=0;i<MAX_FILES;i++){
+		if (!g_files[i].fp) break;
+	}
+	if (MAX_FILES<=i) return FR_TOO_MANY_OPEN_FILES;
+	g_files[i].file=fopen(file,"rb");
+	if (!g_files[i].file) return FR_NO_FILE;
+	g_files[i].fp=fp;
+	memset(fp,0,sizeof *fp);
+	fp->obj.objsize=st.st_size;
+	return FR_OK;
+}
+
+static FILE* host_file(FIL* fp){
+	int i;
+	for(i=0;i<MAX_FILES;i++){
+		if (g_files[i].fp==fp) return g_files[i].file;
+	}
+	return 0;
+}
+
+FRESULT f_close(FIL* fp){
+	int i;
+	for(i=0;i<MAX_FILES;i++){
+		if (g_files[i].fp!=fp) continue;
+		fclose(g_files[i].file);
+		g_files[i].fp=0;
+		return FR_OK;
+	}
+	return FR_INVALID_OBJECT;
+}
+
+FRESULT f_read(FIL* fp,void* buff,UINT btr,UINT* br){
+	FILE* file=host_file(fp);
+	if (!file) return FR_INVALID_OBJECT;
+	*br=fread(buff,1,btr,file);
+	fp->fptr+=*br;
+	return FR_OK;
+}
+
+// Reads a line including '\n' as FatFs (f_eof() sees fp->fptr)
+TCHAR* f_gets(TCHAR* buff,int len,FIL* fp){
+	FILE* file=host_file(fp);
+	int n;
+	if (!file || !fgets((char*)buff,len,file)) return 0;
+	n=strlen((char*)buff);
+	fp->fptr+=n;
+	return buff;
+}
+
+FRESULT f_getcwd(TCHAR* buff,UINT len){
+	if (len<=strlen(g_cwd)) return FR_NOT_ENOUGH_CORE;
+	strcpy((char*)buff,g_cwd);
+	return FR_OK;
+}
+
+FRESULT f_chdir(const TCHAR* path){
+	char dir[512];
+	struct stat st;
+	host_path(dir,sizeof dir,path);
+	if (stat(dir,&st) || !S_ISDIR(st.st_mode)) return FR_NO_PATH;
+	if ('/'==path[0]) snprintf(g_cwd,sizeof g_cwd,"%s",(const char*)path);
+	else if (g_cwd[1]) snprintf(g_cwd+strlen(g_cwd),sizeof g_cwd-strlen(g_cwd),"/%s",(const char*)path);
+	else snprintf(g_cwd,sizeof g_cwd,"/%s",(const char*)path);
+	return FR_OK;
+}
+
+FRESULT f_stat(const TCHAR* path,FILINFO* fno){
+	char file[512];
+	struct stat st;
+	host_path(file,sizeof file,path);
+	if (stat(file,&st)) return FR_NO_FILE;
+	fno->fsize=st.st_size;
+	return FR_OK;
+}
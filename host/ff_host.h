@@ -0,0 +1,10 @@
+/*
+	FatFs on the host file system (see ff_host.c)
+*/
+
+#ifndef FF_HOST_H
+#define FF_HOST_H
+
+void ff_host_root(const char* dir);
+
+#endif // FF_HOST_H
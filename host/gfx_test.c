@@ -0,0 +1,296 @@
+/*
+	Test and benchmark of the graphics primitives of the slave
+	(ntsc/text_graph_library.c)
+
+	g_hline(), g_boxfill(), g_circlefill(), and g_gline() draw spans of
+	pixels. Here, they are compared with the reference drawing below, which
+	puts the pixels one by one as the old code did. Each shape is drawn on
+	the same random background, and the whole frame must be the same, so
+	pixels drawn outside of the shape are also found.
+
+	Then the pixels per second of both are shown. The time is of the host,
+	so only the ratio tells about the RP2040.
+
+	Built twice, with GRAPHIC_BPP=8 and 4 (see Makefile).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "text_graph_library.h"
+
+// Defined by rp2040_pwm_ntsc_textgraph.c
+uint8_t TVRAM[ATTROFFSET*2];
+volatile uint16_t tvram_origin;
+uint8_t* gvram;
+uint8_t fontram[8*256];
+uint8_t* volatile fontp=fontram;
+void clearscreen(void){}
+
+#define SHAPES 3000 // Shapes of each primitive
+#define MARGIN 80   // Coordinates are out of screen by up to this
+
+static uint8_t g_frame[GRAPHIC_PAGE_SIZE];
+static uint8_t g_ref[GRAPHIC_PAGE_SIZE];
+static uint8_t g_background[GRAPHIC_PAGE_SIZE];
+static uint8_t* g_target;
+static int g_errors;
+
+/*
+	Reference drawing
+*/
+
+static void ref_pset(int x,int y,unsigned int c){
+	uint8_t* p;
+	if((unsigned int)x>=X_RES || (unsigned int)y>=Y_RES) return;
+#if GRAPHIC_BPP==4
+	p=g_target+y*GRAPHIC_LINE_SIZE+(x>>1);
+	if(x&1) *p=(*p&0x0f)|((c&15)<<4);
+	else *p=(*p&0xf0)|(c&15);
+#else
+	p=g_target+y*GRAPHIC_LINE_SIZE+x;
+	*p=c;
+#endif
+}
+
+static void ref_hline(int x1,int x2,int y,unsigned int c){
+	int x;
+	if(x1>x2){
+		x=x1;
+		x1=x2;
+		x2=x;
+	}
+	for(x=x1;x<=x2;x++) ref_pset(x,y,c);
+}
+
+static void ref_boxfill(int x1,int y1,int x2,int y2,unsigned int c){
+	int y;
+	if(y1>y2){
+		y=y1;
+		y1=y2;
+		y2=y;
+	}
+	for(y=y1;y<=y2;y++) ref_hline(x1,x2,y,c);
+}
+
+static void ref_circlefill(int x0,int y0,unsigned int r,unsigned int c){
+	int x,y,f;
+	x=r;
+	y=0;
+	f=-2*r+3;
+	while(x>=y){
+		ref_hline(x0-x,x0+x,y0-y,c);
+		ref_hline(x0-x,x0+x,y0+y,c);
+		ref_hline(x0-y,x0+y,y0-x,c);
+		ref_hline(x0-y,x0+y,y0+x,c);
+		if(f>=0){
+			x--;
+			f-=x*4;
+		}
+		y++;
+		f+=y*4+2;
+	}
+}
+
+static void ref_gline(int x1,int y1,int x2,int y2,unsigned int c){
+	int sx,sy,dx,dy,i,e;
+	dx=abs(x2-x1);
+	sx=(x2>x1) ? 1:-1;
+	dy=abs(y2-y1);
+	sy=(y2>y1) ? 1:-1;
+	if(dx>=dy){
+		e=-dx;
+		for(i=0;i<=dx;i++){
+			ref_pset(x1,y1,c);
+			x1+=sx;
+			e+=dy*2;
+			if(e>=0){
+				y1+=sy;
+				e-=dx*2;
+			}
+		}
+	}
+	else{
+		e=-dy;
+		for(i=0;i<=dy;i++){
+			ref_pset(x1,y1,c);
+			y1+=sy;
+			e+=dx*2;
+			if(e>=0){
+				x1+=sx;
+				e-=dy*2;
+			}
+		}
+	}
+}
+
+/*
+	Shapes
+*/
+
+typedef struct {
+	int a,b,c,d;
+	unsigned int color;
+} shape;
+
+typedef struct {
+	const char* name;
+	void (*draw)(const shape* s);
+	void (*ref)(const shape* s);
+	void (*make)(shape* s);
+} primitive;
+
+static int rnd(int n){
+	return rand()%n;
+}
+
+static int coord(int size){
+	// Mostly on the screen, sometimes out of it
+	return rnd(4) ? rnd(size):rnd(size+MARGIN*2)-MARGIN;
+}
+
+static unsigned int color(void){
+	return rnd(256);
+}
+
+static void make_hline(shape* s){
+	s->a=coord(X_RES);
+	s->b=rnd(4) ? s->a+rnd(64)-32:coord(X_RES);
+	s->c=coord(Y_RES);
+	s->color=color();
+}
+static void draw_hline(const shape* s){ g_hline(s->a,s->b,s->c,s->color); }
+static void ref_hline_s(const shape* s){ ref_hline(s->a,s->b,s->c,s->color); }
+
+static void make_box(shape* s){
+	s->a=coord(X_RES);
+	s->b=coord(Y_RES);
+	s->c=rnd(2) ? s->a+rnd(40)-20:coord(X_RES);
+	s->d=rnd(2) ? s->b+rnd(40)-20:coord(Y_RES);
+	s->color=color();
+}
+static void draw_box(const shape* s){ g_boxfill(s->a,s->b,s->c,s->d,s->color); }
+static void ref_box(const shape* s){ ref_boxfill(s->a,s->b,s->c,s->d,s->color); }
+
+static void make_circle(shape* s){
+	s->a=coord(X_RES);
+	s->b=coord(Y_RES);
+	// Small circles (the numbers of the rows and columns are close) are
+	// the hardest for merging the rows
+	s->c=rnd(2) ? rnd(12):rnd(160);
+	s->color=color();
+}
+static void draw_circle(const shape* s){ g_circlefill(s->a,s->b,s->c,s->color); }
+static void ref_circle(const shape* s){ ref_circlefill(s->a,s->b,s->c,s->color); }
+
+static void make_line(shape* s){
+	s->a=coord(X_RES);
+	s->b=coord(Y_RES);
+	s->c=rnd(2) ? s->a+rnd(80)-40:coord(X_RES);
+	s->d=rnd(2) ? s->b+rnd(80)-40:coord(Y_RES);
+	s->color=color();
+}
+// Long lines across the screen
+static void make_long_line(shape* s){
+	s->a=rnd(X_RES);
+	s->b=rnd(Y_RES);
+	s->c=rnd(X_RES);
+	s->d=rnd(Y_RES);
+	s->color=color();
+}
+static void draw_line(const shape* s){ g_gline(s->a,s->b,s->c,s->d,s->color); }
+static void ref_line(const shape* s){ ref_gline(s->a,s->b,s->c,s->d,s->color); }
+
+static const primitive g_primitives[]={
+	{"g_hline",draw_hline,ref_hline_s,make_hline},
+	{"g_boxfill",draw_box,ref_box,make_box},
+	{"g_circlefill",draw_circle,ref_circle,make_circle},
+	{"g_gline",draw_line,ref_line,make_line},
+	{"g_gline long",draw_line,ref_line,make_long_line},
+};
+
+// Number of pixels of the shape that differ from the background
+// (the color is made different from the background for this)
+static long count_pixels(const primitive* p,const shape* s){
+	shape t;
+	long n;
+	int i;
+	t=*s;
+	memset(g_ref,0,sizeof g_ref);
+	t.color=1;
+	g_target=g_ref;
+	p->ref(&t);
+	n=0;
+	for(i=0;i<GRAPHIC_PAGE_SIZE;i++){
+#if GRAPHIC_BPP==4
+		n+=(g_ref[i]&15)!=0;
+		n+=(g_ref[i]>>4)!=0;
+#else
+		n+=g_ref[i]!=0;
+#endif
+	}
+	return n;
+}
+
+static double seconds(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+// Draws all shapes, and returns the time
+static double bench(void (*draw)(const shape* s),const shape* s,int n){
+	double t;
+	int i,k;
+	t=seconds();
+	for(k=0;k<5;k++){
+		for(i=0;i<n;i++) draw(s+i);
+	}
+	return (seconds()-t)/5;
+}
+
+static void test(const primitive* p){
+	static shape s[SHAPES];
+	long pixels;
+	double t_span,t_ref;
+	int i,k;
+	pixels=0;
+	for(i=0;i<SHAPES;i++){
+		p->make(s+i);
+		memcpy(g_frame,g_background,sizeof g_frame);
+		memcpy(g_ref,g_background,sizeof g_ref);
+		p->draw(s+i);
+		g_target=g_ref;
+		p->ref(s+i);
+		if(memcmp(g_frame,g_ref,sizeof g_frame)){
+			for(k=0;k<GRAPHIC_PAGE_SIZE && g_frame[k]==g_ref[k];k++);
+			printf("gfx_test: %s(%d,%d,%d,%d,%u) differs at byte %d (x=%d,y=%d)\n",
+				p->name,s[i].a,s[i].b,s[i].c,s[i].d,s[i].color,k,
+				k%GRAPHIC_LINE_SIZE*8/GRAPHIC_BPP,k/GRAPHIC_LINE_SIZE);
+			g_errors++;
+		}
+		pixels+=count_pixels(p,s+i);
+	}
+	// Benchmark on the drawn frame
+	g_target=g_frame;
+	t_span=bench(p->draw,s,SHAPES);
+	t_ref=bench(p->ref,s,SHAPES);
+	printf("gfx_test: %-12s %9ld pixels  %7.1f Mpixels/s (per pixel %7.1f)  x%.1f\n",
+		p->name,pixels,pixels/t_span*1e-6,pixels/t_ref*1e-6,t_ref/t_span);
+}
+
+int main(void){
+	int i;
+	gvram=g_frame;
+	srand(1);
+	for(i=0;i<GRAPHIC_PAGE_SIZE;i++) g_background[i]=rand();
+	printf("gfx_test: GRAPHIC_BPP=%d\n",GRAPHIC_BPP);
+	for(i=0;i<(int)(sizeof g_primitives/sizeof g_primitives[0]);i++) test(g_primitives+i);
+	if(g_errors){
+		printf("gfx_test: %d errors\n",g_errors);
+		return 1;
+	}
+	printf("gfx_test: OK\n");
+	return 0;
+}
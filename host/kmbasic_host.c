@@ -0,0 +1,68 @@
+/*
+	Host build of the MachiKania BASIC compiler
+	The compiler (compiler.c, statements.c, ..., file.c) is built for the
+	host with the SDK headers in sdk/ and FatFs of ff_host.c. The object
+	is for the Cortex-M0+, so it is run only by the emulator (thumb_emu.c).
+
+	Modules that the pico_ili9341 build doesn't have (aux code and WiFi)
+	don't detect any statement or function.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "compiler.h"
+#include "api.h"
+#include "ff_host.h"
+#include "kmbasic_host.h"
+
+char kmbasic_messages[1024];
+
+static void message(const char* s){
+	int n=strlen(kmbasic_messages);
+	snprintf(kmbasic_messages+n,sizeof kmbasic_messages-n,"%s",s);
+}
+
+void _printchar(unsigned char c){
+	char s[2]={c,0};
+	message(s);
+}
+
+void _printstr(unsigned char* s){
+	message((const char*)s);
+}
+
+void printint(int i){
+	char s[16];
+	snprintf(s,sizeof s,"%d",i);
+	message(s);
+}
+
+int aux_statements(void){ return ERROR_STATEMENT_NOT_DETECTED; }
+int aux_int_functions(void){ return ERROR_STATEMENT_NOT_DETECTED; }
+int aux_float_functions(void){ return ERROR_STATEMENT_NOT_DETECTED; }
+int aux_str_functions(void){ return ERROR_STATEMENT_NOT_DETECTED; }
+int wifi_statements(void){ return ERROR_STATEMENT_NOT_DETECTED; }
+int wifi_int_functions(void){ return ERROR_STATEMENT_NOT_DETECTED; }
+int wifi_str_functions(void){ return ERROR_STATEMENT_NOT_DETECTED; }
+
+int kmbasic_compile(const char* file,int* size){
+	char dir[256];
+	const char* name;
+	int e;
+	// The directory of the file is the root of the drive
+	name=strrchr(file,'/');
+	if (name) {
+		snprintf(dir,sizeof dir,"%.*s",(int)(name-file),file);
+		name++;
+	} else {
+		strcpy(dir,".");
+		name=file;
+	}
+	ff_host_root(dir);
+	kmbasic_messages[0]=0;
+	init_compiler();
+	e=compile_file((unsigned char*)name,0);
+	if (!e) e=post_compile();
+	*size=(object-kmbasic_object)*2;
+	return e;
+}
@@ -0,0 +1,15 @@
+/*
+	Host build of the MachiKania BASIC compiler (see kmbasic_host.c)
+*/
+
+#ifndef KMBASIC_HOST_H
+#define KMBASIC_HOST_H
+
+// Compiles a BASIC file with compile_file() and post_compile() as main.c
+// does. Returns 0 or the error of the compiler, and the size of the object
+// in *size. The messages of the compiler are kept in kmbasic_messages.
+int kmbasic_compile(const char* file,int* size);
+
+extern char kmbasic_messages[1024];
+
+#endif // KMBASIC_HOST_H
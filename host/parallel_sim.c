@@ -0,0 +1,288 @@
+/*
+	Host simulation of the handshake on the parallel bus
+
+	The master state machine (MachiKania/interface/parallel.pio) and the
+	slave state machines (ntsc/interface.pio) are connected by a simulated
+	bus, and run by their own clocks. The CPU of the master feeds random
+	commands and data to TX FIFO and sometimes reads a byte from the slave
+	in the same way as parallel_receive_data() in graphlib.c; the CPU of the
+	slave drains RX FIFO with random pauses so that /BUSY stalls the master.
+
+	Checked:
+		every word reaches the slave once and in order,
+		data and DC never change while /WR is L,
+		the byte read through /RD is the one the slave put,
+		no pin is driven by both sides at the same time.
+
+	Usage: parallel_sim [number of words per run]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pio_sim.h"
+
+#define MASTER_PIO "../MachiKania/interface/parallel.pio"
+#define SLAVE_PIO  "../ntsc/interface.pio"
+
+// Pins of the master (see graphlib.c)
+#define M_DC_PIN   10
+#define M_WR_PIN   11
+#define M_BUSY_PIN 12
+#define M_RD_PIN   13
+#define M_DATA_MASK 0xff
+// Pins of the slave (see ntsc/interface.c)
+#define S_DC_PIN   8
+#define S_WR_PIN   9
+#define S_RD_PIN   10
+#define S_BUSY_PIN 11
+
+static const int g_master_wire[]={0,0, 1,1, 2,2, 3,3, 4,4, 5,5, 6,6, 7,7,
+	M_DC_PIN,S_DC_PIN, M_WR_PIN,S_WR_PIN, M_BUSY_PIN,S_BUSY_PIN, M_RD_PIN,S_RD_PIN};
+static const int g_slave_wire[]={0,0, 1,1, 2,2, 3,3, 4,4, 5,5, 6,6, 7,7,
+	S_DC_PIN,M_DC_PIN, S_WR_PIN,M_WR_PIN, S_BUSY_PIN,M_BUSY_PIN, S_RD_PIN,M_RD_PIN};
+#define WIRE_NUM (sizeof(g_master_wire)/sizeof(g_master_wire[0])/2)
+
+static pio_sim_program g_master_progs[PIO_SIM_MAX_PROGRAM];
+static pio_sim_program g_slave_progs[PIO_SIM_MAX_PROGRAM];
+static int g_master_prog_num,g_slave_prog_num;
+
+static unsigned int g_seed;
+
+static unsigned int rnd(unsigned int n){
+	g_seed=g_seed*1103515245+12345;
+	return (g_seed>>8)%n;
+}
+
+/*
+	States of the CPU of the master
+*/
+enum {
+	MCPU_SEND,      // Put words to TX FIFO
+	MCPU_WAIT_SENT, // parallel_wait_sent()
+	MCPU_WAIT_BUSY_H,
+	MCPU_WAIT_BUSY_L,
+	MCPU_WAIT_RELEASE,
+	MCPU_RELEASE,   // Data lines are returned to PIO one by one
+};
+
+typedef struct {
+	// Bus
+	pio_sim_gpio mgpio,sgpio;
+	pio_sim_sm master,slave,slave_read;
+	// CPU of master
+	int mstate;
+	int mwait;
+	int release_pin;
+	unsigned int mpio_oe;
+	unsigned int sent,received;
+	unsigned int* words;
+	unsigned int num;
+	// CPU of slave
+	int swait;
+	int spause;
+	unsigned int read_data;
+	bool read_pending;
+	// Results
+	unsigned int reads;
+	unsigned int errors;
+	unsigned int contentions;
+	unsigned long long mcycles;
+} sim_state;
+
+static void error(sim_state* st,const char* msg,unsigned int a,unsigned int b){
+	if (st->errors++<10) fprintf(stderr,"  error: %s (%x, %x)\n",msg,a,b);
+}
+
+static void sim_init(sim_state* st,unsigned int num){
+	const pio_sim_program* p;
+	memset(st,0,sizeof(*st));
+	// Master: parallel_pio_init()
+	p=pio_sim_find(g_master_progs,g_master_prog_num,"parallel_master");
+	pio_sim_sm_init(&st->master,p,&st->mgpio,8,0);
+	st->master.out_base=0;
+	st->master.out_count=M_DC_PIN+1;
+	st->master.side_base=M_WR_PIN;
+	st->master.in_base=M_BUSY_PIN;
+	st->mgpio.out=(1<<M_DC_PIN)|(1<<M_WR_PIN)|(1<<M_RD_PIN);
+	st->mpio_oe=M_DATA_MASK|(1<<M_DC_PIN)|(1<<M_WR_PIN);
+	st->mgpio.oe=st->mpio_oe|(1<<M_RD_PIN);
+	// Slave: interface_init()
+	p=pio_sim_find(g_slave_progs,g_slave_prog_num,"parallel_slave");
+	pio_sim_sm_init(&st->slave,p,&st->sgpio,0,8);
+	st->slave.in_base=0;
+	st->slave.side_base=S_BUSY_PIN;
+	p=pio_sim_find(g_slave_progs,g_slave_prog_num,"parallel_slave_read");
+	pio_sim_sm_init(&st->slave_read,p,&st->sgpio,8,0);
+	st->slave_read.out_base=0;
+	st->slave_read.out_count=8;
+	st->slave_read.in_base=0;
+	st->slave_read.side_base=S_BUSY_PIN;
+	st->sgpio.out=1<<S_BUSY_PIN;
+	st->sgpio.oe=1<<S_BUSY_PIN;
+	memset(st->mgpio.sync,0xff,sizeof(st->mgpio.sync));
+	memset(st->sgpio.sync,0xff,sizeof(st->sgpio.sync));
+	st->mgpio.in=st->sgpio.in=0xffffffff;
+	// Words to send: data in bit 0-7 and DC in bit 10
+	st->num=num;
+	st->words=malloc(num*sizeof(unsigned int));
+	for(unsigned int i=0;i<num;i++) st->words[i]=rnd(256)|(rnd(4) ? 0:1<<M_DC_PIN);
+}
+
+static void master_cpu(sim_state* st){
+	if (st->mwait) {
+		st->mwait--;
+		return;
+	}
+	switch(st->mstate){
+		case MCPU_SEND:
+			if (st->num<=st->sent) break;
+			if (0==rnd(200)) {
+				// Read a byte from the slave
+				st->mstate=MCPU_WAIT_SENT;
+				break;
+			}
+			if (pio_sim_put(&st->master,st->words[st->sent])) st->sent++;
+			// Sometimes the CPU is busy with other jobs
+			if (0==rnd(64)) st->mwait=rnd(400);
+			break;
+		case MCPU_WAIT_SENT:
+			// All data must be sent before reading
+			if (!pio_sim_tx_empty(&st->master) || 0!=st->master.pc) break;
+			// The slave prepares the result after receiving all data
+			if (st->received<st->sent) break;
+			st->read_data=rnd(256);
+			st->read_pending=true;
+			// Data lines are input mode by SIO while reading
+			st->mgpio.oe&=~M_DATA_MASK;
+			st->mstate=MCPU_WAIT_BUSY_H;
+			st->mwait=8;
+			break;
+		case MCPU_WAIT_BUSY_H:
+			if (!(st->mgpio.in&(1<<M_BUSY_PIN))) break;
+			// Set /RD to L
+			st->mgpio.out&=~(1<<M_RD_PIN);
+			st->mstate=MCPU_WAIT_BUSY_L;
+			break;
+		case MCPU_WAIT_BUSY_L:
+			if (st->mgpio.in&(1<<M_BUSY_PIN)) break;
+			if ((st->mgpio.in&M_DATA_MASK)!=st->read_data) error(st,"read data",st->mgpio.in&M_DATA_MASK,st->read_data);
+			st->reads++;
+			// Set /RD to H
+			st->mgpio.out|=1<<M_RD_PIN;
+			st->mstate=MCPU_WAIT_RELEASE;
+			st->release_pin=0;
+			st->mwait=2;
+			break;
+		case MCPU_WAIT_RELEASE:
+			// Wait until the slave returns data lines to input mode
+			if (!(st->mgpio.in&(1<<M_BUSY_PIN))) break;
+			st->mstate=MCPU_RELEASE;
+			break;
+		case MCPU_RELEASE:
+			// pio_gpio_init() for each data line
+			st->mgpio.oe|=st->mpio_oe&(1<<st->release_pin);
+			if (8<=++st->release_pin) st->mstate=MCPU_SEND;
+			st->mwait=6;
+			break;
+	}
+}
+
+static void slave_cpu(sim_state* st){
+	unsigned int w,expect;
+	if (st->swait) {
+		st->swait--;
+		return;
+	}
+	if (st->read_pending && st->received==st->sent) {
+		// Result of read command (put_read_data())
+		pio_sim_put(&st->slave_read,st->read_data);
+		st->read_pending=false;
+	}
+	if (pio_sim_get(&st->slave,&w)) {
+		// interface.pio puts data in bit 0-7 and DC in bit 8
+		expect=st->received<st->num ? st->words[st->received]:0xffffffff;
+		expect=(expect&M_DATA_MASK)|((expect>>M_DC_PIN)&1)<<S_DC_PIN;
+		if (w!=expect) error(st,"received word",w,expect);
+		st->received++;
+		// Executing a command takes time
+		st->swait=rnd(st->spause+1);
+		if (0==rnd(100)) st->swait+=rnd(2000);
+	}
+}
+
+static int run(unsigned int num,unsigned int mperiod,unsigned int speriod,unsigned int spause){
+	sim_state st;
+	unsigned long long t,mt,stime,limit;
+	unsigned int out;
+	sim_init(&st,num);
+	st.spause=spause;
+	mt=stime=0;
+	limit=(unsigned long long)num*(spause+100)*8+1000000;
+	while((st.received<num || st.mstate!=MCPU_SEND) && st.mcycles<limit){
+		t=mt<stime ? mt:stime;
+		if (t==mt) {
+			// A cycle of master
+			mt+=mperiod;
+			st.mcycles++;
+			pio_sim_bus_update(&st.mgpio,&st.sgpio,g_master_wire,WIRE_NUM);
+			master_cpu(&st);
+			out=st.mgpio.out;
+			pio_sim_step(&st.master);
+			if ((out^st.mgpio.out)&(M_DATA_MASK|(1<<M_DC_PIN))) {
+				if (!(out&st.mgpio.out&(1<<M_WR_PIN))) error(&st,"data changed while /WR is L",out,st.mgpio.out);
+			}
+		}
+		if (t==stime) {
+			// A cycle of slave
+			stime+=speriod;
+			pio_sim_bus_update(&st.sgpio,&st.mgpio,g_slave_wire,WIRE_NUM);
+			slave_cpu(&st);
+			pio_sim_step(&st.slave);
+			pio_sim_step(&st.slave_read);
+		}
+		// Bus contention
+		if (st.mgpio.oe&st.sgpio.oe&M_DATA_MASK) st.contentions++;
+	}
+	if (limit<=st.mcycles) error(&st,"timeout",st.received,st.sent);
+	if (st.received!=num) error(&st,"number of words",st.received,num);
+	if (st.contentions) error(&st,"bus contention (cycles)",st.contentions,0);
+	printf("  clock %3u:%3u MHz, slave pause %3u: %u words, %u reads, %.2f master cycles/word, %llu stalls%s\n",
+		1000000/mperiod,1000000/speriod,spause,st.received,st.reads,
+		(double)st.mcycles/num,st.master.stalls,st.errors ? " NG":"");
+	free(st.words);
+	return st.errors ? 1:0;
+}
+
+int main(int argc,char** argv){
+	static const unsigned int clocks[][2]={
+		// Periods (ps) of master and slave clock
+		{8000,6349}, // 125 MHz and 157.5 MHz
+		{6349,8000},
+		{8000,8000},
+		{4000,13000},
+		{13000,4000},
+	};
+	static const unsigned int pauses[]={0,20,300};
+	unsigned int num,i,j;
+	int ng=0;
+	num=1<argc ? atoi(argv[1]):20000;
+	g_master_prog_num=pio_sim_load(MASTER_PIO,g_master_progs,PIO_SIM_MAX_PROGRAM);
+	g_slave_prog_num=pio_sim_load(SLAVE_PIO,g_slave_progs,PIO_SIM_MAX_PROGRAM);
+	if (g_master_prog_num<=0 || g_slave_prog_num<=0) return 1;
+	if (!pio_sim_find(g_master_progs,g_master_prog_num,"parallel_master") ||
+		!pio_sim_find(g_slave_progs,g_slave_prog_num,"parallel_slave") ||
+		!pio_sim_find(g_slave_progs,g_slave_prog_num,"parallel_slave_read")) {
+		fprintf(stderr,"program not found\n");
+		return 1;
+	}
+	printf("parallel_sim: handshake of %s and %s\n",MASTER_PIO,SLAVE_PIO);
+	g_seed=1;
+	for(i=0;i<sizeof(clocks)/sizeof(clocks[0]);i++){
+		for(j=0;j<sizeof(pauses)/sizeof(pauses[0]);j++){
+			ng|=run(num,clocks[i][0],clocks[i][1],pauses[j]);
+		}
+	}
+	printf("parallel_sim: %s\n",ng ? "FAILED":"OK");
+	return ng;
+}
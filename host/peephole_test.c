@@ -0,0 +1,442 @@
+/*
+	Test of the peephole optimizer of the BASIC compiler (peephole.c)
+
+	Without arguments, random integer programs are made, and each is
+	compiled with and without the optimization (g_disable_peephole). Both
+	objects run in the Thumb emulator (thumb_emu.c), and the variables A-Z
+	at the end must be the same. The programs use nested FOR loops with and
+	without STEP, BREAK, CONTINUE, DO WHILE, GOSUB, and GOTO to labels and
+	line numbers (also by a value), in and out of the loops.
+
+	A program that doesn't end in MAX_STEPS instructions in both runs (for
+	example, a subroutine moves back the counter of the loop calling it) is
+	skipped. A failed program is saved as PEEPFAIL.BAS.
+
+	With BASIC files as arguments (MANDELBR.BAS and RAYTRACE.BAS by "make
+	bench"), the sizes of the objects with and without the optimization
+	are shown instead.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "compiler.h"
+#include "kmbasic_host.h"
+#include "thumb_emu.h"
+
+#define PROGRAMS 2000
+#define MAX_STEPS 1000000
+#define VARS 26 // A-Z
+
+/*
+	Random programs
+*/
+
+static unsigned int g_seed;
+static char g_program[1<<16];
+static int g_length;
+static char g_line[256];
+static int g_label;
+static char g_subs[2][16];
+static int g_subs_num;
+
+// Counters of the loops the statement is in
+typedef struct {
+	char name[4];
+	char up[4]; // The counter goes up (it may be increased in the loop)
+	int num;
+} counters;
+
+static int rnd(int n){
+	g_seed^=g_seed<<13;
+	g_seed^=g_seed>>17;
+	g_seed^=g_seed<<5;
+	return g_seed%n;
+}
+
+static char var(void){
+	return "ABCDEFGH"[rnd(8)];
+}
+
+static void put(const char* format,...){
+	va_list args;
+	int n=strlen(g_line);
+	va_start(args,format);
+	vsnprintf(g_line+n,sizeof g_line-n,format,args);
+	va_end(args);
+}
+
+static void end_line(void){
+	g_length+=snprintf(g_program+g_length,sizeof g_program-g_length,"%s\n",g_line);
+	if ((int)sizeof g_program<=g_length) g_length=sizeof g_program-1;
+	g_line[0]=0;
+}
+
+static void atom(const counters* cs){
+	static const int constants[]={0,1,2,3,5,7,100};
+	int x=rnd(100);
+	if (x<40 && cs->num) put("%c",cs->name[rnd(cs->num)]);
+	else if (x<70) put("%c",var());
+	else put("%d",constants[rnd(7)]);
+}
+
+static void expression(const counters* cs){
+	static const char* const operators[]={"+","-","*","AND","OR","XOR","<",">=","<<",">>","/","%"};
+	const char* op;
+	int k;
+	atom(cs);
+	for(k=rnd(3);0<k;k--){
+		op=operators[rnd(12)];
+		put(" %s ",op);
+		// Shift and divide by a constant
+		if ('<'==op[1] || '>'==op[1]) put("%d",rnd(33));
+		else if ('/'==op[0] || '%'==op[0]) put("%d",1+rnd(9));
+		else atom(cs);
+	}
+}
+
+static void compare(const counters* cs){
+	static const char* const operators[]={"<","<=",">",">=","=","!="};
+	expression(cs);
+	put(" %s ",operators[rnd(6)]);
+	expression(cs);
+}
+
+static void assign(const counters* cs){
+	put("%c=",var());
+	expression(cs);
+	end_line();
+}
+
+static void loop(const counters* cs,int depth,const char* backlabel);
+
+static void body(const counters* cs,int depth,const char* backlabel){
+	int n,x,k;
+	for(n=1+rnd(4);0<n;n--){
+		x=rnd(100);
+		if (x<30) {
+			assign(cs);
+		} else if (x<38) {
+			// Increase a counter going up
+			for(k=cs->num-1;0<=k && !cs->up[k];k--);
+			if (k<0) {
+				assign(cs);
+			} else {
+				put("%c=%c+%d",cs->name[k],cs->name[k],1+rnd(2));
+				end_line();
+			}
+		} else if (x<45) {
+			put("IF ");
+			compare(cs);
+			put(" THEN BREAK");
+			end_line();
+		} else if (x<50) {
+			put("IF ");
+			compare(cs);
+			put(" THEN");
+			end_line();
+			assign(cs);
+			put("CONTINUE");
+			end_line();
+			put("ENDIF");
+			end_line();
+		} else if (x<65 && depth<3) {
+			loop(cs,depth+1,backlabel);
+		} else if (x<72 && g_subs_num) {
+			put("GOSUB %s",g_subs[rnd(g_subs_num)]);
+			end_line();
+		} else if (x<77 && backlabel) {
+			put("IF Z<3 AND (");
+			compare(cs);
+			put(") THEN");
+			end_line();
+			put("Z=Z+1");
+			end_line();
+			put("GOTO %s",backlabel);
+			end_line();
+			put("ENDIF");
+			end_line();
+		} else if (x<84) {
+			// Forward to a line number, given as a constant or by a value
+			k=10000+100*++g_label;
+			put("IF ");
+			compare(cs);
+			if (x<80) put(" THEN GOTO %d",k);
+			else put(" THEN GOTO (%c AND 0)+%d",var(),k);
+			end_line();
+			assign(cs);
+			put("%d ",k);
+			assign(cs);
+		} else if (x<87) {
+			k=++g_label;
+			put("IF ");
+			compare(cs);
+			put(" THEN GOTO F%d",k);
+			end_line();
+			assign(cs);
+			put("LABEL F%d",k);
+			end_line();
+		} else if (x<91) {
+			put("K=0:DO WHILE K<2");
+			end_line();
+			assign(cs);
+			put("K=K+1:LOOP");
+			end_line();
+		} else {
+			put("%c=",var());
+			put("%c+",var());
+			if (cs->num) put("%c",cs->name[rnd(cs->num)]);
+			else put("1");
+			end_line();
+		}
+	}
+}
+
+static void loop(const counters* cs,int depth,const char* backlabel){
+	static const int steps[]={-1,-2,2,3};
+	static const char free_counters[]="IJLM"; // K is for DO, N for the subroutines
+	counters inner;
+	char label[16];
+	char c;
+	int a,b,x,k;
+	// A counter not used by the outer loops
+	do {
+		c=free_counters[rnd(4)];
+	} while(memchr(cs->name,c,cs->num));
+	inner=*cs;
+	inner.name[inner.num]=c;
+	inner.up[inner.num]=1;
+	a=rnd(7)-3;
+	b=rnd(9)-3;
+	x=rnd(100);
+	if (x<60) {
+		put("FOR %c=%d TO %d",c,a,b);
+	} else if (x<80) {
+		k=steps[rnd(4)];
+		put("FOR %c=%d TO %d STEP %d",c,b,a,k);
+		inner.up[inner.num]=0<k;
+	} else {
+		put("FOR %c=%d TO %c AND 7",c,a,var());
+		put(" STEP 1+(%c AND 1)",var());
+	}
+	inner.num++;
+	end_line();
+	if (rnd(100)<40) {
+		snprintf(label,sizeof label,"B%d",++g_label);
+		put("LABEL %s",label);
+		end_line();
+		backlabel=label;
+	}
+	body(&inner,depth,backlabel);
+	x=rnd(100);
+	if (x<15) {
+		// Out of the loop to a label
+		k=++g_label;
+		put("IF ");
+		compare(&inner);
+		put(" THEN GOTO E%d",k);
+		end_line();
+		assign(&inner);
+		put("NEXT");
+		end_line();
+		put("LABEL E%d",k);
+		end_line();
+	} else if (x<30) {
+		// Out of the loop to a line number
+		k=10000+100*++g_label;
+		put("IF ");
+		compare(&inner);
+		put(" THEN GOTO %d",k);
+		end_line();
+		assign(&inner);
+		put("NEXT");
+		end_line();
+		put("%d ",k);
+		assign(cs);
+	} else {
+		put("NEXT");
+		end_line();
+	}
+	put("%c=",var());
+	put("%c+%c",var(),c);
+	end_line();
+}
+
+static void make_program(unsigned int seed){
+	static const counters none;
+	char subs[256];
+	char c;
+	int i,n;
+	g_seed=seed*2654435761u+1;
+	g_length=0;
+	g_line[0]=0;
+	g_label=0;
+	// Subroutines (put after END)
+	subs[0]=0;
+	n=0;
+	g_subs_num=rnd(3);
+	for(i=0;i<g_subs_num;i++){
+		snprintf(g_subs[i],sizeof g_subs[i],"S%d",++g_label);
+		n+=snprintf(subs+n,sizeof subs-n,"LABEL %s\n",g_subs[i]);
+		if (rnd(2)) n+=snprintf(subs+n,sizeof subs-n,"FOR N=1 TO 3\nA=A+N\nNEXT\n");
+		if (rnd(2)) {
+			c="IJL"[rnd(3)];
+			n+=snprintf(subs+n,sizeof subs-n,"%c=%d\n",c,rnd(2) ? 5:9);
+		}
+		n+=snprintf(subs+n,sizeof subs-n,"B=B+1\nRETURN\n");
+	}
+	put("Z=0");
+	end_line();
+	for(i=0;i<8;i++){
+		put("%c=%d","ABCDEFGH"[i],rnd(11)-5);
+		end_line();
+	}
+	for(n=1+rnd(4);0<n;n--){
+		if (rnd(100)<70) loop(&none,0,0);
+		else assign(&none);
+	}
+	put("END");
+	end_line();
+	g_length+=snprintf(g_program+g_length,sizeof g_program-g_length,"%s",subs);
+}
+
+/*
+	Compile and run
+*/
+
+typedef struct {
+	int result;
+	int vars[VARS];
+	unsigned long steps;
+	int size;
+	char message[128];
+} run_result;
+
+static void compile_and_run(const char* file,int disable,run_result* res){
+	thumb_emu cpu;
+	int e;
+	memset(res,0,sizeof *res);
+	g_disable_peephole=disable;
+	e=kmbasic_compile(file,&res->size);
+	g_disable_peephole=0;
+	if (e) {
+		res->result=THUMB_EMU_ERROR;
+		snprintf(res->message,sizeof res->message,"compile error %d: %.100s",e,kmbasic_messages);
+		return;
+	}
+	thumb_emu_init(&cpu);
+	res->result=thumb_emu_run(&cpu,MAX_STEPS);
+	res->steps=cpu.steps;
+	snprintf(res->message,sizeof res->message,"%s",cpu.message);
+	memcpy(res->vars,kmbasic_variables,sizeof res->vars);
+}
+
+static void show(const char* name,const run_result* res){
+	int i;
+	printf("peephole_test:   %s: ",name);
+	if (THUMB_EMU_ERROR==res->result) printf("%s\n",res->message);
+	else if (THUMB_EMU_TIMEOUT==res->result) printf("timeout\n");
+	else {
+		for(i=0;i<VARS;i++) printf(" %c=%d",'A'+i,res->vars[i]);
+		printf("\n");
+	}
+}
+
+static int test_random(const char* dir){
+	static run_result off,on;
+	char file[256],fail[256];
+	FILE* fp;
+	int seed,failed,skipped,size_off,size_on;
+	unsigned long long steps_off,steps_on;
+	snprintf(file,sizeof file,"%s/PEEPTEST.BAS",dir);
+	snprintf(fail,sizeof fail,"%s/PEEPFAIL.BAS",dir);
+	failed=skipped=0;
+	size_off=size_on=0;
+	steps_off=steps_on=0;
+	for(seed=1;seed<=PROGRAMS;seed++){
+		make_program(seed);
+		fp=fopen(file,"wb");
+		if (!fp) {
+			perror(file);
+			return 1;
+		}
+		fwrite(g_program,1,g_length,fp);
+		fclose(fp);
+		compile_and_run(file,1,&off);
+		compile_and_run(file,0,&on);
+		if (THUMB_EMU_TIMEOUT==off.result && THUMB_EMU_TIMEOUT==on.result) {
+			skipped++;
+			continue;
+		}
+		if (THUMB_EMU_END==off.result && THUMB_EMU_END==on.result && !memcmp(off.vars,on.vars,sizeof on.vars)) {
+			size_off+=off.size;
+			size_on+=on.size;
+			steps_off+=off.steps;
+			steps_on+=on.steps;
+			continue;
+		}
+		printf("peephole_test: program %d failed\n",seed);
+		show("without",&off);
+		show("with   ",&on);
+		if (!failed) {
+			fp=fopen(fail,"wb");
+			if (fp) {
+				fwrite(g_program,1,g_length,fp);
+				fclose(fp);
+				printf("peephole_test:   saved as %s\n",fail);
+			}
+		}
+		failed++;
+	}
+	printf("peephole_test: %d programs (%d skipped by timeout)\n",PROGRAMS,skipped);
+	if (size_off && steps_off) {
+		printf("peephole_test: %d -> %d bytes (%.1f%%), %llu -> %llu instructions (%.1f%%)\n",
+			size_off,size_on,100.0*size_on/size_off,steps_off,steps_on,100.0*steps_on/steps_off);
+	}
+	if (failed) {
+		printf("peephole_test: %d failed\n",failed);
+		return 1;
+	}
+	printf("peephole_test: OK\n");
+	return 0;
+}
+
+/*
+	Object sizes
+*/
+
+static int test_sizes(int argc,char* argv[]){
+	int i,e,size_off,size_on,errors;
+	const char* name;
+	errors=0;
+	for(i=1;i<argc;i++){
+		name=strrchr(argv[i],'/') ? strrchr(argv[i],'/')+1:argv[i];
+		g_disable_peephole=1;
+		e=kmbasic_compile(argv[i],&size_off);
+		g_disable_peephole=0;
+		if (!e) e=kmbasic_compile(argv[i],&size_on);
+		if (e) {
+			printf("peephole_test: %-12s error %d: %s\n",name,e,kmbasic_messages);
+			errors++;
+			continue;
+		}
+		printf("peephole_test: %-12s %7d -> %7d bytes (%5.1f%%)\n",
+			name,size_off,size_on,100.0*size_on/size_off);
+	}
+	if (errors) {
+		printf("peephole_test: %d errors\n",errors);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc,char* argv[]){
+	char dir[256];
+	const char* p;
+	if (1<argc) return test_sizes(argc,argv);
+	// The programs are written in the directory of this executable
+	p=strrchr(argv[0],'/');
+	if (p) snprintf(dir,sizeof dir,"%.*s",(int)(p-argv[0]),argv[0]);
+	else strcpy(dir,".");
+	return test_random(dir);
+}
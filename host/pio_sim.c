@@ -0,0 +1,305 @@
+/*
+	Cycle level simulator of RP2040 PIO state machines (see pio_sim.h)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "pio_sim.h"
+
+static int parse_error(const char* file,int line,const char* msg){
+	fprintf(stderr,"%s:%d: %s\n",file,line,msg);
+	return -1;
+}
+
+static char* skip_space(char* p){
+	while(isspace((unsigned char)*p)) p++;
+	return p;
+}
+
+static int parse_instr(char* p,pio_sim_instr* in,const pio_sim_program* prog){
+	char* s;
+	int n;
+	memset(in,0,sizeof(*in));
+	in->side=-1;
+	// Delay
+	s=strchr(p,'[');
+	if (s) {
+		in->delay=atoi(s+1);
+		*s=0;
+	}
+	// Side-set
+	s=strstr(p," side ");
+	if (s) {
+		if (0==prog->side_set_bits) return -1;
+		in->side=atoi(s+6);
+		*s=0;
+	}
+	// Replace commas with spaces, and remove duplicated spaces
+	for(s=p;*s;s++) if (','==*s) *s=' ';
+	for(s=p;*s;s++){
+		while(' '==s[0] && ' '==s[1]) memmove(s,s+1,strlen(s));
+	}
+	if (!strncmp(p,"wait ",5)) {
+		char type[8];
+		int pol;
+		if (3!=sscanf(p+5,"%d %7s %d",&pol,type,&n)) return -1;
+		in->arg=pol;
+		in->index=n;
+		if (!strcmp(type,"pin")) in->op=PIO_SIM_WAIT_PIN;
+		else if (!strcmp(type,"gpio")) in->op=PIO_SIM_WAIT_GPIO;
+		else return -1;
+	} else if (1==sscanf(p,"in pins %d",&n)) {
+		in->op=PIO_SIM_IN_PINS;
+		in->index=n;
+	} else if (1==sscanf(p,"out pins %d",&n)) {
+		in->op=PIO_SIM_OUT_PINS;
+		in->index=n;
+	} else if (1==sscanf(p,"out pindirs %d",&n)) {
+		in->op=PIO_SIM_OUT_PINDIRS;
+		in->index=n;
+	} else if (!strncmp(p,"push block",10) || !strcmp(skip_space(p),"push")) {
+		in->op=PIO_SIM_PUSH;
+	} else if (!strncmp(p,"pull block",10) || !strcmp(skip_space(p),"pull")) {
+		in->op=PIO_SIM_PULL;
+	} else if (!strncmp(p,"mov osr ~null",13)) {
+		in->op=PIO_SIM_MOV_OSR;
+		in->arg=1;
+	} else if (!strncmp(p,"mov osr null",12)) {
+		in->op=PIO_SIM_MOV_OSR;
+		in->arg=0;
+	} else if (!strncmp(p,"nop",3)) {
+		in->op=PIO_SIM_NOP;
+	} else {
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Read all programs in a .pio file.
+	Returns the number of programs, or -1 if an error occurs.
+*/
+int pio_sim_load(const char* file,pio_sim_program* progs,int max){
+	FILE* fp;
+	char buff[256];
+	char* p;
+	char* s;
+	int num=0;
+	int line=0;
+	pio_sim_program* prog=0;
+	fp=fopen(file,"r");
+	if (!fp) {
+		perror(file);
+		return -1;
+	}
+	while(fgets(buff,sizeof buff,fp)){
+		line++;
+		// Remove comment and line end
+		s=strchr(buff,';');
+		if (s) *s=0;
+		for(s=buff;*s;s++) if ('\r'==*s || '\n'==*s || '\t'==*s) *s=' ';
+		p=skip_space(buff);
+		for(s=p+strlen(p);p<s && ' '==s[-1];s--) s[-1]=0;
+		if (!*p) continue;
+		if (!strncmp(p,".program ",9)) {
+			if (prog) {
+				if (prog->wrap<0) prog->wrap=prog->length-1;
+			}
+			if (max<=num) {
+				fclose(fp);
+				return parse_error(file,line,"too many programs");
+			}
+			prog=&progs[num++];
+			memset(prog,0,sizeof(*prog));
+			snprintf(prog->name,sizeof prog->name,"%s",skip_space(p+9));
+			prog->wrap=-1;
+		} else if (!prog) {
+			fclose(fp);
+			return parse_error(file,line,"instruction before .program");
+		} else if (!strncmp(p,".side_set ",10)) {
+			prog->side_set_bits=atoi(p+10);
+			prog->side_set_opt=strstr(p," opt") ? true:false;
+		} else if (!strcmp(p,".wrap_target")) {
+			prog->wrap_target=prog->length;
+		} else if (!strcmp(p,".wrap")) {
+			prog->wrap=prog->length-1;
+		} else if ('.'==p[0]) {
+			fclose(fp);
+			return parse_error(file,line,"unsupported directive");
+		} else {
+			if (PIO_SIM_MAX_INSTR<=prog->length || parse_instr(p,&prog->instr[prog->length],prog)) {
+				fclose(fp);
+				return parse_error(file,line,"unsupported instruction");
+			}
+			prog->length++;
+		}
+	}
+	fclose(fp);
+	if (prog && prog->wrap<0) prog->wrap=prog->length-1;
+	return num;
+}
+
+const pio_sim_program* pio_sim_find(const pio_sim_program* progs,int num,const char* name){
+	int i;
+	for(i=0;i<num;i++) if (!strcmp(progs[i].name,name)) return &progs[i];
+	return 0;
+}
+
+void pio_sim_sm_init(pio_sim_sm* sm,const pio_sim_program* prog,pio_sim_gpio* gpio,int tx_depth,int rx_depth){
+	memset(sm,0,sizeof(*sm));
+	sm->prog=prog;
+	sm->gpio=gpio;
+	sm->tx_depth=tx_depth;
+	sm->rx_depth=rx_depth;
+	sm->out_count=32;
+	sm->enabled=true;
+}
+
+bool pio_sim_put(pio_sim_sm* sm,unsigned int data){
+	if (sm->tx_depth<=sm->tx_num) return false;
+	sm->tx[(sm->tx_pos+sm->tx_num++)%PIO_SIM_FIFO_DEPTH]=data;
+	return true;
+}
+
+bool pio_sim_get(pio_sim_sm* sm,unsigned int* data){
+	if (0==sm->rx_num) return false;
+	*data=sm->rx[sm->rx_pos];
+	sm->rx_pos=(sm->rx_pos+1)%PIO_SIM_FIFO_DEPTH;
+	sm->rx_num--;
+	return true;
+}
+
+bool pio_sim_tx_full(const pio_sim_sm* sm){
+	return sm->tx_depth<=sm->tx_num;
+}
+
+bool pio_sim_tx_empty(const pio_sim_sm* sm){
+	return 0==sm->tx_num;
+}
+
+bool pio_sim_rx_empty(const pio_sim_sm* sm){
+	return 0==sm->rx_num;
+}
+
+void pio_sim_clear_fifos(pio_sim_sm* sm){
+	sm->tx_num=sm->rx_num=0;
+}
+
+static void write_pins(unsigned int* reg,int base,int count,unsigned int value){
+	unsigned int mask;
+	mask=count<32 ? (1u<<count)-1:0xffffffff;
+	value&=mask;
+	mask=(mask<<base)|(base ? mask>>(32-base):0);
+	value=(value<<base)|(base ? value>>(32-base):0);
+	*reg=(*reg&~mask)|value;
+}
+
+static unsigned int out_shift(pio_sim_sm* sm,int n){
+	// Shift to right (sm_config_set_out_shift(&c,true,...))
+	unsigned int v;
+	if (32==n) {
+		v=sm->osr;
+		sm->osr=0;
+	} else {
+		v=sm->osr&((1u<<n)-1);
+		sm->osr>>=n;
+	}
+	sm->osr_count+=n;
+	return v;
+}
+
+/*
+	Execute a cycle of the state machine.
+	Side-set takes effect even if the instruction stalls, as the real PIO does.
+*/
+void pio_sim_step(pio_sim_sm* sm){
+	const pio_sim_instr* in;
+	unsigned int v;
+	bool stall=false;
+	if (!sm->enabled) return;
+	sm->cycles++;
+	if (sm->delay) {
+		sm->delay--;
+		return;
+	}
+	in=&sm->prog->instr[sm->pc];
+	if (0<=in->side) write_pins(&sm->gpio->out,sm->side_base,1,in->side);
+	switch(in->op){
+		case PIO_SIM_WAIT_PIN:
+		case PIO_SIM_WAIT_GPIO:
+			v=PIO_SIM_WAIT_PIN==in->op ? (in->index+sm->in_base)&31:in->index;
+			stall=((sm->gpio->in>>v)&1)!=in->arg;
+			if (stall) sm->wait_stalls++;
+			break;
+		case PIO_SIM_IN_PINS:
+			v=(sm->gpio->in>>sm->in_base)|(sm->in_base ? sm->gpio->in<<(32-sm->in_base):0);
+			if (in->index<32) v&=(1u<<in->index)-1;
+			// Shift to left (sm_config_set_in_shift(&c,false,...))
+			sm->isr=in->index<32 ? (sm->isr<<in->index)|v:v;
+			sm->isr_count+=in->index;
+			break;
+		case PIO_SIM_OUT_PINS:
+			write_pins(&sm->gpio->out,sm->out_base,sm->out_count,out_shift(sm,in->index));
+			break;
+		case PIO_SIM_OUT_PINDIRS:
+			write_pins(&sm->gpio->oe,sm->out_base,sm->out_count,out_shift(sm,in->index));
+			break;
+		case PIO_SIM_PUSH:
+			if (sm->rx_depth<=sm->rx_num) {
+				stall=true;
+				break;
+			}
+			sm->rx[(sm->rx_pos+sm->rx_num++)%PIO_SIM_FIFO_DEPTH]=sm->isr;
+			sm->isr=0;
+			sm->isr_count=0;
+			break;
+		case PIO_SIM_PULL:
+			if (0==sm->tx_num) {
+				stall=true;
+				break;
+			}
+			sm->osr=sm->tx[sm->tx_pos];
+			sm->tx_pos=(sm->tx_pos+1)%PIO_SIM_FIFO_DEPTH;
+			sm->tx_num--;
+			sm->osr_count=0;
+			break;
+		case PIO_SIM_MOV_OSR:
+			sm->osr=in->arg ? 0xffffffff:0;
+			sm->osr_count=0;
+			break;
+		default:
+			break;
+	}
+	if (stall) {
+		sm->stalls++;
+		return;
+	}
+	sm->delay=in->delay;
+	if (sm->pc==sm->prog->wrap) sm->pc=sm->prog->wrap_target;
+	else sm->pc++;
+}
+
+/*
+	Calculate the input levels of a chip
+	wire[] contains the pairs of connected pins (pin of this chip, pin of the
+	other chip). A pin is H when nobody drives it (all inputs are pulled up).
+	The level reaches gpio->in after PIO_SIM_SYNC_STAGES calls.
+*/
+void pio_sim_bus_update(pio_sim_gpio* gpio,const pio_sim_gpio* other,const int* wire,int num){
+	unsigned int level,bit;
+	int i;
+	level=~gpio->oe;
+	for(i=0;i<num;i++){
+		bit=1u<<wire[i*2];
+		if (gpio->oe&bit) continue;
+		if (other->oe&(1u<<wire[i*2+1])) {
+			if (!(other->out&(1u<<wire[i*2+1]))) level&=~bit;
+		}
+	}
+	level|=gpio->out&gpio->oe;
+	gpio->in=gpio->sync[PIO_SIM_SYNC_STAGES-1];
+	for(i=PIO_SIM_SYNC_STAGES-1;0<i;i--) gpio->sync[i]=gpio->sync[i-1];
+	gpio->sync[0]=level;
+}
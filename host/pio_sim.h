@@ -0,0 +1,94 @@
+/*
+	Cycle level simulator of RP2040 PIO state machines for the host (Linux)
+
+	The programs are read from the .pio source files, so the simulation
+	always follows the code in the tree. Only the instructions used by
+	parallel.pio and interface.pio are supported:
+		wait, in pins, out pins/pindirs, push block, pull block,
+		mov osr (~)null, nop, side-set, and delay.
+*/
+
+#ifndef PIO_SIM_H
+#define PIO_SIM_H
+
+#include <stdbool.h>
+
+#define PIO_SIM_MAX_INSTR   32
+#define PIO_SIM_MAX_PROGRAM 8
+#define PIO_SIM_FIFO_DEPTH  8
+#define PIO_SIM_SYNC_STAGES 2
+
+enum {
+	PIO_SIM_WAIT_PIN,
+	PIO_SIM_WAIT_GPIO,
+	PIO_SIM_IN_PINS,
+	PIO_SIM_OUT_PINS,
+	PIO_SIM_OUT_PINDIRS,
+	PIO_SIM_PUSH,
+	PIO_SIM_PULL,
+	PIO_SIM_MOV_OSR,
+	PIO_SIM_NOP,
+};
+
+typedef struct {
+	unsigned char op;
+	unsigned char arg;   // polarity of wait, inverted for mov
+	unsigned char index; // pin number of wait, bit count of in/out
+	signed char side;    // value of side-set, or -1 if not specified
+	unsigned char delay;
+} pio_sim_instr;
+
+typedef struct {
+	char name[32];
+	int side_set_bits;
+	bool side_set_opt;
+	int wrap_target;
+	int wrap;
+	int length;
+	pio_sim_instr instr[PIO_SIM_MAX_INSTR];
+} pio_sim_program;
+
+/*
+	GPIO of a chip
+	out and oe are driven by the state machines (or by the CPU).
+	in is the level seen by the chip after the input synchronizer;
+	pio_sim_bus_update() calculates it from the pins of both chips.
+*/
+typedef struct {
+	unsigned int out;
+	unsigned int oe;
+	unsigned int in;
+	unsigned int sync[PIO_SIM_SYNC_STAGES];
+} pio_sim_gpio;
+
+typedef struct {
+	const pio_sim_program* prog;
+	pio_sim_gpio* gpio;
+	int pc;
+	int delay;
+	unsigned int osr,isr;
+	int osr_count,isr_count;
+	// FIFOs (depth is 4, or 8 when joined)
+	unsigned int tx[PIO_SIM_FIFO_DEPTH],rx[PIO_SIM_FIFO_DEPTH];
+	int tx_num,rx_num,tx_depth,rx_depth;
+	int tx_pos,rx_pos;
+	// Pin mapping
+	int out_base,out_count,in_base,side_base;
+	bool enabled;
+	// Statistics (wait_stalls: cycles stalled by wait instructions)
+	unsigned long long cycles,stalls,wait_stalls;
+} pio_sim_sm;
+
+int pio_sim_load(const char* file,pio_sim_program* progs,int max);
+const pio_sim_program* pio_sim_find(const pio_sim_program* progs,int num,const char* name);
+void pio_sim_sm_init(pio_sim_sm* sm,const pio_sim_program* prog,pio_sim_gpio* gpio,int tx_depth,int rx_depth);
+void pio_sim_step(pio_sim_sm* sm);
+bool pio_sim_put(pio_sim_sm* sm,unsigned int data);
+bool pio_sim_get(pio_sim_sm* sm,unsigned int* data);
+bool pio_sim_tx_full(const pio_sim_sm* sm);
+bool pio_sim_tx_empty(const pio_sim_sm* sm);
+bool pio_sim_rx_empty(const pio_sim_sm* sm);
+void pio_sim_clear_fifos(pio_sim_sm* sm);
+void pio_sim_bus_update(pio_sim_gpio* gpio,const pio_sim_gpio* other,const int* wire,int num);
+
+#endif // PIO_SIM_H
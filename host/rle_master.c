@@ -0,0 +1,200 @@
+/*
+	Round trip test of COMMAND_TEXTREDRAW_RLE
+	The master (textredraw_rle() in graphlib.c) encodes the text screen, and
+	the slave (put_rle_data() in ntsc/interface.c) decodes it. The TVRAM of
+	both must be the same after textredraw().
+
+	Screens:
+		listings of the BASIC files given as arguments (MachiKania/samples), a
+		page of 27 lines at a time, as shown by the editor
+		synthetic screens around the limits of the runs and the literals
+	The master TVRAM is written directly (not sent), so only textredraw()
+	updates the slave. The slave is scrolled beforehand, so that its TVRAM
+	does not start at the top of the ring buffer.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "graphlib.h"
+#include "LCDdriver.h"
+#include "config.h"
+#include "cosim.h"
+
+extern unsigned char TVRAM[];
+
+// Defined by the LCD drivers in MachiKania
+int X_RES,Y_RES;
+
+#define COMMAND_TEXTREDRAW     0x98
+#define COMMAND_TEXTREDRAW_RLE 0x9E
+
+static int g_screens,g_rle_screens,g_failed;
+static unsigned long long g_raw_total,g_sent_total;
+
+static unsigned long long sent_bytes(void){
+	return cosim_command_bytes(COMMAND_TEXTREDRAW)+cosim_command_bytes(COMMAND_TEXTREDRAW_RLE);
+}
+
+static void clear_master(void){
+	memset(TVRAM,0,WIDTH_X*WIDTH_Y);
+	memset(TVRAM+ATTROFFSET,0,WIDTH_X*WIDTH_Y);
+}
+
+// Sends the master TVRAM by textredraw(), and compares it with the slave
+// Returns the bytes sent
+static unsigned long long redraw(const char* name,int scroll){
+	static unsigned char text[ATTROFFSET],color[ATTROFFSET];
+	unsigned long long rle,sent;
+	int i,diff;
+	char msg[128];
+	// Scroll the slave, and restore the screen of the master
+	memcpy(text,TVRAM,sizeof text);
+	memcpy(color,TVRAM+ATTROFFSET,sizeof color);
+	for(i=0;i<scroll;i++) printchar('\n');
+	memcpy(TVRAM,text,sizeof text);
+	memcpy(TVRAM+ATTROFFSET,color,sizeof color);
+	g_color(0,0);
+	rle=cosim_command_bytes(COMMAND_TEXTREDRAW_RLE);
+	sent=sent_bytes();
+	textredraw();
+	// Reading from the slave waits until all commands are executed
+	g_color(0,0);
+	sent=sent_bytes()-sent;
+	diff=cosim_compare_tvram(TVRAM,TVRAM+ATTROFFSET);
+	snprintf(msg,sizeof msg,"%s: %d bytes of TVRAM differ",name,diff);
+	cosim_expect(0==diff,msg);
+	if (diff) g_failed++;
+	g_screens++;
+	if (rle!=cosim_command_bytes(COMMAND_TEXTREDRAW_RLE)) g_rle_screens++;
+	g_raw_total+=1+WIDTH_X*WIDTH_Y*2;
+	g_sent_total+=sent;
+	return sent;
+}
+
+/*
+	Listings
+*/
+
+static int read_line(FILE* fp,unsigned char* line,int size){
+	int c,n;
+	n=0;
+	while(EOF!=(c=fgetc(fp))){
+		if ('\n'==c) break;
+		if ('\r'==c) continue;
+		if ('\t'==c) c=' ';
+		if (n<size-1) line[n++]=c;
+	}
+	line[n]=0;
+	return (EOF==c && 0==n) ? -1:n;
+}
+
+static int is_comment(const unsigned char* line){
+	while(' '==*line || ('0'<=*line && *line<='9')) line++;
+	return '\''==*line || 0==strncmp((const char*)line,"REM",3);
+}
+
+static void test_file(const char* file){
+	static unsigned char line[1024];
+	static char name[64];
+	FILE* fp;
+	const char* base;
+	int i,x,y,n,page,color;
+	unsigned long long raw,sent;
+	fp=fopen(file,"rb");
+	if (!fp) {
+		perror(file);
+		g_failed++;
+		return;
+	}
+	base=strrchr(file,'/') ? strrchr(file,'/')+1:file;
+	raw=sent=0;
+	n=0;
+	for(page=0;0<=n;page++){
+		// A page of the editor: long lines are wrapped at the right end
+		clear_master();
+		for(y=0;y<WIDTH_Y;){
+			n=read_line(fp,line,sizeof line);
+			if (n<0) break;
+			color=is_comment(line) ? 6:7;
+			for(x=0;(0==x || x<n) && y<WIDTH_Y;x+=WIDTH_X,y++){
+				for(i=0;i<WIDTH_X && x+i<n;i++){
+					TVRAM[y*WIDTH_X+i]=line[x+i];
+					TVRAM[ATTROFFSET+y*WIDTH_X+i]=color;
+				}
+			}
+		}
+		if (0==y) break;
+		snprintf(name,sizeof name,"%s:%d",base,page+1);
+		sent+=redraw(name,page%5);
+		raw+=1+WIDTH_X*WIDTH_Y*2;
+		// The first page is shown on the screen
+		if (0==page) cosim_checkpoint(base,TVRAM,TVRAM+ATTROFFSET);
+	}
+	fclose(fp);
+	printf("rle_test: %-12s %3d pages %7llu bytes (%5.1f%% of TEXTREDRAW)\n",
+		base,page,sent,raw ? 100.0*sent/raw:0.0);
+}
+
+/*
+	Synthetic screens
+*/
+
+static void fill(unsigned char c,unsigned char a){
+	memset(TVRAM,c,WIDTH_X*WIDTH_Y);
+	memset(TVRAM+ATTROFFSET,a,WIDTH_X*WIDTH_Y);
+}
+
+// Runs of length n separated by a different byte
+static void runs(int n){
+	int i;
+	for(i=0;i<WIDTH_X*WIDTH_Y;i++){
+		TVRAM[i]=(i%(n+1)==n) ? 'X':'-';
+		TVRAM[ATTROFFSET+i]=(i/(n+1))&7;
+	}
+}
+
+static void test_synthetic(void){
+	static const int lengths[]={1,2,3,4,127,128,129,130,131,257,258,259};
+	char name[64];
+	unsigned int r;
+	int i,k;
+	unsigned long long sent;
+	clear_master();
+	redraw("empty",1);
+	fill('A',7);
+	redraw("same",2);
+	// Literals only: alternating bytes, and runs of 2
+	for(i=0;i<WIDTH_X*WIDTH_Y;i++){
+		TVRAM[i]=(i&1) ? 'a':'b';
+		TVRAM[ATTROFFSET+i]=(i>>1)&1 ? 3:4;
+	}
+	redraw("alternate",3);
+	for(k=0;k<(int)(sizeof lengths/sizeof lengths[0]);k++){
+		runs(lengths[k]);
+		snprintf(name,sizeof name,"runs of %d",lengths[k]);
+		redraw(name,k%4);
+	}
+	// Noise: larger than TEXTREDRAW, so sent without compression
+	r=12345;
+	for(i=0;i<WIDTH_X*WIDTH_Y;i++){
+		r=r*1103515245+12345;
+		TVRAM[i]=r>>16;
+		TVRAM[ATTROFFSET+i]=(r>>8)&7;
+	}
+	k=g_rle_screens;
+	sent=redraw("noise",4);
+	cosim_expect(k==g_rle_screens,"noise: sent by COMMAND_TEXTREDRAW_RLE");
+	cosim_expect(sent==1+(unsigned int)(WIDTH_X*WIDTH_Y*2),"noise: size of COMMAND_TEXTREDRAW");
+	// Noise in the characters only, with the same color
+	for(i=0;i<WIDTH_X*WIDTH_Y;i++) TVRAM[ATTROFFSET+i]=7;
+	redraw("noise_text",0);
+}
+
+void cosim_master_main(int argc,char* argv[]){
+	int i;
+	init_textgraph(0);
+	for(i=1;i<argc;i++) test_file(argv[i]);
+	test_synthetic();
+	printf("rle_test: %d screens (%d by RLE, %d failed) %llu bytes (%.1f%% of TEXTREDRAW)\n",
+		g_screens,g_rle_screens,g_failed,g_sent_total,g_raw_total ? 100.0*g_sent_total/g_raw_total:0.0);
+}
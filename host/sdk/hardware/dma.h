@@ -0,0 +1,85 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size {
+	DMA_SIZE_8=0,
+	DMA_SIZE_16=1,
+	DMA_SIZE_32=2,
+};
+
+#define DREQ_PWM_WRAP0 24
+#define DREQ_FORCE 0x3f
+
+typedef struct {
+	uint8_t size;
+	bool read_increment;
+	bool write_increment;
+	bool ring_write;
+	uint8_t ring_bits;
+	uint8_t dreq;
+	uint8_t chain_to;
+	bool enable;
+} dma_channel_config;
+
+// Registers of a channel
+// Addresses are 32 bit, so the co-simulation is linked with -no-pie
+typedef struct {
+	io_rw_32 read_addr;
+	io_rw_32 write_addr;
+	io_rw_32 transfer_count;
+	io_rw_32 ctrl_trig;
+	io_rw_32 al1_ctrl;
+	io_rw_32 al1_read_addr;
+	io_rw_32 al1_write_addr;
+	io_rw_32 al1_transfer_count_trig;
+	io_rw_32 al2_ctrl;
+	io_rw_32 al2_transfer_count;
+	io_rw_32 al2_read_addr;
+	io_rw_32 al2_write_addr_trig;
+	io_rw_32 al3_ctrl;
+	io_rw_32 al3_write_addr;
+	io_rw_32 al3_transfer_count;
+	io_rw_32 al3_read_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+	dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+	io_rw_32 intr;
+	io_rw_32 inte0;
+	io_rw_32 intf0;
+	io_rw_32 ints0;
+	io_rw_32 inte1;
+	io_rw_32 intf1;
+	io_rw_32 ints1;
+} dma_hw_t;
+
+dma_hw_t* sim_dma_hw(void);
+#define dma_hw sim_dma_hw()
+
+static inline dma_channel_hw_t* dma_channel_hw_addr(uint channel){
+	return &dma_hw->ch[channel];
+}
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config* c,enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config* c,bool incr);
+void channel_config_set_write_increment(dma_channel_config* c,bool incr);
+void channel_config_set_ring(dma_channel_config* c,bool write,uint size_bits);
+void channel_config_set_dreq(dma_channel_config* c,uint dreq);
+void channel_config_set_chain_to(dma_channel_config* c,uint chain_to);
+void dma_channel_set_config(uint channel,const dma_channel_config* config,bool trigger);
+void dma_channel_configure(uint channel,const dma_channel_config* config,volatile void* write_addr,const volatile void* read_addr,uint transfer_count,bool trigger);
+void dma_channel_set_read_addr(uint channel,const volatile void* read_addr,bool trigger);
+void dma_channel_set_write_addr(uint channel,volatile void* write_addr,bool trigger);
+void dma_channel_set_trans_count(uint channel,uint32_t trans_count,bool trigger);
+void dma_start_channel_mask(uint32_t mask);
+bool dma_channel_is_busy(uint channel);
+void dma_set_irq0_channel_mask_enabled(uint32_t mask,bool enabled);
+void dma_channel_set_irq1_enabled(uint channel,bool enabled);
+
+#endif // HOST_HARDWARE_DMA_H
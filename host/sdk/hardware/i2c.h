@@ -0,0 +1,17 @@
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+#include "pico/stdlib.h"
+
+// I2C is not simulated; declared for the host build of MachiKania
+typedef struct i2c_inst i2c_inst_t;
+
+#define i2c0 ((i2c_inst_t*)0x40044000)
+#define i2c1 ((i2c_inst_t*)0x40048000)
+
+uint i2c_init(i2c_inst_t* i2c,uint baudrate);
+void i2c_deinit(i2c_inst_t* i2c);
+int i2c_write_blocking(i2c_inst_t* i2c,uint8_t addr,const uint8_t* src,size_t len,bool nostop);
+int i2c_read_blocking(i2c_inst_t* i2c,uint8_t addr,uint8_t* dst,size_t len,bool nostop);
+
+#endif // HOST_HARDWARE_I2C_H
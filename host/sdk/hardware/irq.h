@@ -0,0 +1,16 @@
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define IO_IRQ_BANK0 13
+#define UART1_IRQ 21
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num,irq_handler_t handler);
+void irq_set_enabled(uint num,bool enabled);
+
+#endif // HOST_HARDWARE_IRQ_H
@@ -0,0 +1,61 @@
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+// FIFO registers, only used as the addresses for DMA
+typedef struct {
+	io_rw_32 txf[4];
+	io_rw_32 rxf[4];
+} pio_hw_t;
+
+typedef pio_hw_t* PIO;
+
+PIO sim_pio(uint n);
+#define pio0 sim_pio(0)
+#define pio1 sim_pio(1)
+
+// The program is read from the .pio file (see *.pio.h in this directory)
+typedef struct pio_program {
+	const char* name;
+	const char* file;
+} pio_program_t;
+
+enum pio_fifo_join {
+	PIO_FIFO_JOIN_NONE=0,
+	PIO_FIFO_JOIN_TX=1,
+	PIO_FIFO_JOIN_RX=2,
+};
+
+typedef struct {
+	const pio_program_t* program;
+	uint offset;
+	int out_base,out_count;
+	int in_base;
+	int sideset_base;
+	bool out_shift_right;
+	bool in_shift_right;
+	enum pio_fifo_join join;
+} pio_sm_config;
+
+pio_sm_config sim_pio_get_default_config(const pio_program_t* program,uint offset);
+uint pio_add_program(PIO pio,const pio_program_t* program);
+int pio_claim_unused_sm(PIO pio,bool required);
+void pio_gpio_init(PIO pio,uint pin);
+void pio_sm_set_pins_with_mask(PIO pio,uint sm,uint32_t values,uint32_t mask);
+void pio_sm_set_pindirs_with_mask(PIO pio,uint sm,uint32_t dirs,uint32_t mask);
+void sm_config_set_out_pins(pio_sm_config* c,uint base,uint count);
+void sm_config_set_in_pins(pio_sm_config* c,uint base);
+void sm_config_set_sideset_pins(pio_sm_config* c,uint base);
+void sm_config_set_out_shift(pio_sm_config* c,bool shift_right,bool autopull,uint threshold);
+void sm_config_set_in_shift(pio_sm_config* c,bool shift_right,bool autopush,uint threshold);
+void sm_config_set_fifo_join(pio_sm_config* c,enum pio_fifo_join join);
+void pio_sm_init(PIO pio,uint sm,uint offset,const pio_sm_config* config);
+void pio_sm_set_enabled(PIO pio,uint sm,bool enabled);
+uint pio_get_dreq(PIO pio,uint sm,bool is_tx);
+void pio_sm_put_blocking(PIO pio,uint sm,uint32_t data);
+void pio_sm_clear_fifos(PIO pio,uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio,uint sm);
+uint8_t pio_sm_get_pc(PIO pio,uint sm);
+
+#endif // HOST_HARDWARE_PIO_H
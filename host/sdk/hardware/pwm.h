@@ -0,0 +1,34 @@
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+// PWM is not simulated; the video thread of the co-simulation takes the
+// samples made by the DMA IRQ handler instead (see sim_chip.c)
+typedef struct {
+	uint32_t csr,div,top;
+} pwm_config;
+
+typedef struct {
+	struct {
+		io_rw_32 csr,div,ctr,cc,top;
+	} slice[8];
+} pwm_hw_t;
+
+extern pwm_hw_t sim_pwm_hw;
+#define pwm_hw (&sim_pwm_hw)
+
+#define PWM_CHAN_A 0
+#define PWM_CHAN_B 1
+
+uint pwm_gpio_to_slice_num(uint gpio);
+pwm_config pwm_get_default_config(void);
+void pwm_config_set_clkdiv(pwm_config* c,float div);
+void pwm_init(uint slice,pwm_config* c,bool start);
+void pwm_set_wrap(uint slice,uint16_t wrap);
+void pwm_set_enabled(uint slice,bool enabled);
+void pwm_set_chan_level(uint slice,uint chan,uint16_t level);
+void pwm_set_counter(uint slice,uint16_t c);
+void pwm_set_clkdiv(uint slice,float divider);
+
+#endif // HOST_HARDWARE_PWM_H
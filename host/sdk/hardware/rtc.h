@@ -0,0 +1,12 @@
+#ifndef HOST_HARDWARE_RTC_H
+#define HOST_HARDWARE_RTC_H
+
+#include "pico/stdlib.h"
+#include "pico/util/datetime.h"
+
+// RTC is not simulated; declared for the host build of MachiKania
+void rtc_init(void);
+bool rtc_set_datetime(datetime_t* t);
+bool rtc_get_datetime(datetime_t* t);
+
+#endif // HOST_HARDWARE_RTC_H
@@ -0,0 +1,29 @@
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include "pico/stdlib.h"
+
+// SPI is not simulated; declared for the host build of MachiKania
+typedef struct spi_inst spi_inst_t;
+
+#define SPI0_BASE 0x4003c000
+#define SPI1_BASE 0x40040000
+#define SPI_SSPCR0_OFFSET 0
+#define spi0 ((spi_inst_t*)SPI0_BASE)
+#define spi1 ((spi_inst_t*)SPI1_BASE)
+
+typedef enum { SPI_CPHA_0=0,SPI_CPHA_1=1 } spi_cpha_t;
+typedef enum { SPI_CPOL_0=0,SPI_CPOL_1=1 } spi_cpol_t;
+typedef enum { SPI_LSB_FIRST=0,SPI_MSB_FIRST=1 } spi_order_t;
+
+uint spi_init(spi_inst_t* spi,uint baudrate);
+void spi_set_format(spi_inst_t* spi,uint data_bits,spi_cpol_t cpol,spi_cpha_t cpha,spi_order_t order);
+uint spi_set_baudrate(spi_inst_t* spi,uint baudrate);
+int spi_write_blocking(spi_inst_t* spi,const uint8_t* src,size_t len);
+int spi_read_blocking(spi_inst_t* spi,uint8_t repeated_tx_data,uint8_t* dst,size_t len);
+int spi_write_read_blocking(spi_inst_t* spi,const uint8_t* src,uint8_t* dst,size_t len);
+int spi_write16_blocking(spi_inst_t* spi,const uint16_t* src,size_t len);
+int spi_read16_blocking(spi_inst_t* spi,uint16_t repeated_tx_data,uint16_t* dst,size_t len);
+int spi_write16_read16_blocking(spi_inst_t* spi,const uint16_t* src,uint16_t* dst,size_t len);
+
+#endif // HOST_HARDWARE_SPI_H
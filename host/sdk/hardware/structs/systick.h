@@ -0,0 +1,17 @@
+#ifndef HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+	io_rw_32 csr;
+	io_rw_32 rvr;
+	io_rw_32 cvr;
+	io_ro_32 calib;
+} systick_hw_t;
+
+// SysTick counts down by the cycles of the simulated chip
+systick_hw_t* sim_systick_hw(void);
+#define systick_hw sim_systick_hw()
+
+#endif // HOST_HARDWARE_STRUCTS_SYSTICK_H
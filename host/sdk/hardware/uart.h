@@ -0,0 +1,30 @@
+#ifndef HOST_HARDWARE_UART_H
+#define HOST_HARDWARE_UART_H
+
+#include "pico/stdlib.h"
+
+// UART is not simulated; declared for the host build of MachiKania
+typedef struct uart_inst uart_inst_t;
+
+typedef struct {
+	io_rw_32 dr,rsr;
+} uart_hw_t;
+
+#define uart0 ((uart_inst_t*)0x40034000)
+#define uart1 ((uart_inst_t*)0x40038000)
+#define UART_UARTRSR_PE_BITS 0x00000002
+
+typedef enum { UART_PARITY_NONE,UART_PARITY_EVEN,UART_PARITY_ODD } uart_parity_t;
+
+uint uart_init(uart_inst_t* uart,uint baudrate);
+void uart_deinit(uart_inst_t* uart);
+uint uart_set_baudrate(uart_inst_t* uart,uint baudrate);
+void uart_set_hw_flow(uart_inst_t* uart,bool cts,bool rts);
+void uart_set_format(uart_inst_t* uart,uint data_bits,uint stop_bits,uart_parity_t parity);
+void uart_set_fifo_enabled(uart_inst_t* uart,bool enabled);
+void uart_set_irq_enables(uart_inst_t* uart,bool rx_has_data,bool tx_needs_data);
+uart_hw_t* uart_get_hw(uart_inst_t* uart);
+char uart_getc(uart_inst_t* uart);
+void uart_putc_raw(uart_inst_t* uart,char c);
+
+#endif // HOST_HARDWARE_UART_H
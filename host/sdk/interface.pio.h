@@ -0,0 +1,13 @@
+// Replaces the header generated from ntsc/interface.pio
+#include "hardware/pio.h"
+
+static const pio_program_t parallel_slave_program={"parallel_slave",COSIM_ROOT "/ntsc/interface.pio"};
+static const pio_program_t parallel_slave_read_program={"parallel_slave_read",COSIM_ROOT "/ntsc/interface.pio"};
+
+static inline pio_sm_config parallel_slave_program_get_default_config(uint offset){
+	return sim_pio_get_default_config(&parallel_slave_program,offset);
+}
+
+static inline pio_sm_config parallel_slave_read_program_get_default_config(uint offset){
+	return sim_pio_get_default_config(&parallel_slave_read_program,offset);
+}
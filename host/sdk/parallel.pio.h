@@ -0,0 +1,8 @@
+// Replaces the header generated from MachiKania/interface/parallel.pio
+#include "hardware/pio.h"
+
+static const pio_program_t parallel_master_program={"parallel_master",COSIM_ROOT "/MachiKania/interface/parallel.pio"};
+
+static inline pio_sm_config parallel_master_program_get_default_config(uint offset){
+	return sim_pio_get_default_config(&parallel_master_program,offset);
+}
@@ -0,0 +1,60 @@
+/*
+	Subset of the Pico SDK for the host co-simulation (see sim_chip.c)
+	Each call works on the chip of the calling thread.
+*/
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_ro_32;
+
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+
+enum gpio_function {
+	GPIO_FUNC_SPI=1,
+	GPIO_FUNC_UART=2,
+	GPIO_FUNC_I2C=3,
+	GPIO_FUNC_SIO=5,
+	GPIO_FUNC_PIO0=6,
+	GPIO_FUNC_PWM=4,
+};
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+#define GPIO_IRQ_EDGE_FALL 4
+#define GPIO_IRQ_EDGE_RISE 8
+
+typedef void (*gpio_irq_callback_t)(uint gpio,uint32_t events);
+
+void gpio_init(uint gpio);
+void gpio_init_mask(uint32_t mask);
+void gpio_set_dir(uint gpio,bool out);
+void gpio_set_dir_in_masked(uint32_t mask);
+void gpio_set_dir_out_masked(uint32_t mask);
+void gpio_set_function(uint gpio,enum gpio_function fn);
+void gpio_pull_up(uint gpio);
+void gpio_disable_pulls(uint gpio);
+void gpio_set_pulls(uint gpio,bool up,bool down);
+void gpio_put_masked(uint32_t mask,uint32_t value);
+void gpio_put(uint gpio,bool value);
+bool gpio_get(uint gpio);
+uint32_t gpio_get_all(void);
+void gpio_set_irq_enabled_with_callback(uint gpio,uint32_t events,bool enabled,gpio_irq_callback_t callback);
+
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void tight_loop_contents(void);
+bool set_sys_clock_khz(uint32_t freq_khz,bool required);
+
+// As hardware/gpio.h of the SDK does
+#include "hardware/irq.h"
+#include "pico/time.h"
+
+#endif // HOST_PICO_STDLIB_H
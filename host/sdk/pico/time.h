@@ -0,0 +1,30 @@
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+// Timers are not simulated; declared for the host build of MachiKania
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id,void* user_data);
+
+struct repeating_timer;
+typedef bool (*repeating_timer_callback_t)(struct repeating_timer* rt);
+struct repeating_timer {
+	int64_t delay_us;
+	alarm_id_t alarm_id;
+	repeating_timer_callback_t callback;
+	void* user_data;
+};
+
+typedef uint64_t absolute_time_t;
+
+bool add_repeating_timer_us(int64_t delay_us,repeating_timer_callback_t callback,void* user_data,struct repeating_timer* out);
+bool cancel_repeating_timer(struct repeating_timer* timer);
+alarm_id_t add_alarm_at(absolute_time_t time,alarm_callback_t callback,void* user_data,bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us,alarm_callback_t callback,void* user_data,bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+void busy_wait_ms(uint32_t delay_ms);
+void busy_wait_us_32(uint32_t delay_us);
+
+#endif // HOST_PICO_TIME_H
@@ -0,0 +1,11 @@
+#ifndef HOST_PICO_UTIL_DATETIME_H
+#define HOST_PICO_UTIL_DATETIME_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+	int16_t year;
+	int8_t month,day,dotw,hour,min,sec;
+} datetime_t;
+
+#endif // HOST_PICO_UTIL_DATETIME_H
@@ -0,0 +1,783 @@
+/*
+	Simulated RP2040 chips and the Pico SDK functions (see sim_chip.h)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/pwm.h"
+#include "hardware/structs/systick.h"
+#include "sim_chip.h"
+
+sim_chip sim_master={.name="master",.period=8000}; // 125 MHz
+sim_chip sim_slave={.name="slave",.period=8000};   // set_sys_clock_khz() changes this
+volatile bool sim_stop;
+void (*sim_on_send)(uint32_t word);
+void (*sim_on_receive)(uint32_t word);
+pwm_hw_t sim_pwm_hw;
+
+static __thread sim_chip* g_chip;
+static __thread int g_irq_depth; // Nesting of disabled interrupts
+static pthread_mutex_t g_lock=PTHREAD_MUTEX_INITIALIZER;
+static const int* g_wire;
+static int g_wire_num;
+static unsigned long long g_master_time,g_slave_time;
+
+static void fatal(const char* msg){
+	fprintf(stderr,"sim: %s\n",msg);
+	exit(1);
+}
+
+void sim_lock(void){
+	pthread_mutex_lock(&g_lock);
+}
+
+void sim_unlock(void){
+	pthread_mutex_unlock(&g_lock);
+}
+
+void sim_set_chip(sim_chip* chip){
+	g_chip=chip;
+}
+
+sim_chip* sim_get_chip(void){
+	return g_chip;
+}
+
+/*
+	Called where the CPU reads the state of the hardware.
+	Other threads run once in SIM_POLL_YIELD calls, so a CPU that checks
+	the hardware once per job (e.g. dma_channel_is_busy() in
+	parallel_send_main()) is not slowed down by the bus thread.
+	Threads of the slave end here when the simulation stops.
+*/
+#define SIM_POLL_YIELD 256
+
+void sim_poll(void){
+	static __thread unsigned int polls;
+	if (sim_stop && &sim_slave==g_chip) pthread_exit(0);
+	if (0==++polls%SIM_POLL_YIELD) sched_yield();
+}
+
+static void chip_init(sim_chip* chip){
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&chip->irq_lock,&attr);
+	pthread_mutexattr_destroy(&attr);
+	chip->pins=0xffffffff;
+	chip->pio.in=0xffffffff;
+	memset(chip->pio.sync,0xff,sizeof(chip->pio.sync));
+}
+
+/*
+	wire[] contains the pairs of connected pins (pin of master, pin of slave)
+*/
+void sim_init(const int* wire,int num){
+	g_wire=wire;
+	g_wire_num=num;
+	chip_init(&sim_master);
+	chip_init(&sim_slave);
+}
+
+/*
+	Bus
+*/
+
+static uint32_t chip_out(const sim_chip* chip){
+	return (chip->pio.out&chip->pio_func)|(chip->sio_out&~chip->pio_func);
+}
+
+static uint32_t chip_oe(const sim_chip* chip){
+	return (chip->pio.oe&chip->pio_func)|(chip->sio_oe&~chip->pio_func);
+}
+
+static void bus_update(sim_chip* chip,const sim_chip* other,bool master){
+	uint32_t level,bit,oe,ooe,oout,prev,fall,rise;
+	int i,pin,opin;
+	oe=chip_oe(chip);
+	ooe=chip_oe(other);
+	oout=chip_out(other);
+	// Pins that nobody drives are pulled up
+	level=~oe;
+	for(i=0;i<g_wire_num;i++){
+		pin=master ? g_wire[i*2]:g_wire[i*2+1];
+		opin=master ? g_wire[i*2+1]:g_wire[i*2];
+		bit=1u<<pin;
+		if (oe&bit) continue;
+		if ((ooe>>opin)&1 && !((oout>>opin)&1)) level&=~bit;
+	}
+	level|=chip_out(chip)&oe;
+	for(bit=chip->pins&~level;bit;bit&=bit-1) chip->falls[__builtin_ctz(bit)]++;
+	chip->pins=level;
+	// Input synchronizer
+	prev=chip->pio.in;
+	chip->pio.in=chip->pio.sync[PIO_SIM_SYNC_STAGES-1];
+	for(i=PIO_SIM_SYNC_STAGES-1;0<i;i--) chip->pio.sync[i]=chip->pio.sync[i-1];
+	chip->pio.sync[0]=level;
+	// GPIO interrupt
+	fall=prev&~chip->pio.in&chip->gpio_fall;
+	rise=~prev&chip->pio.in&chip->gpio_rise;
+	if (fall|rise) {
+		chip->gpio_events|=fall|rise;
+		chip->irq_pending|=1u<<IO_IRQ_BANK0;
+	}
+}
+
+/*
+	DMA
+*/
+
+static void dma_complete(sim_chip* chip,int ch);
+
+static void dma_trigger(sim_chip* chip,int ch){
+	sim_dma_channel* d=&chip->dma_ch[ch];
+	if (!d->config.enable) return;
+	chip->dma.ch[ch].transfer_count=d->reload;
+	d->busy=true;
+	if (0==d->reload) dma_complete(chip,ch);
+}
+
+static void dma_complete(sim_chip* chip,int ch){
+	sim_dma_channel* d=&chip->dma_ch[ch];
+	d->busy=false;
+	if (d->irq0) {
+		chip->dma.ints0|=1u<<ch;
+		chip->irq_pending|=1u<<DMA_IRQ_0;
+	}
+	if (d->irq1) {
+		chip->dma.ints1|=1u<<ch;
+		chip->irq_pending|=1u<<DMA_IRQ_1;
+	}
+	if (d->config.chain_to!=ch) dma_trigger(chip,d->config.chain_to);
+}
+
+/*
+	Write a register of DMA channel (n: index of the register in dma_channel_hw_t)
+	Writing 0 to a trigger register does not start the channel (null trigger).
+*/
+static void dma_reg_write(sim_chip* chip,int ch,int n,uint32_t value){
+	dma_channel_hw_t* hw=&chip->dma.ch[ch];
+	// Writes to the ctrl registers are ignored
+	switch(n){
+		case 0: case 5: case 10: case 15:
+			hw->read_addr=value;
+			break;
+		case 1: case 6: case 11: case 13:
+			hw->write_addr=value;
+			break;
+		case 2: case 7: case 9: case 14:
+			chip->dma_ch[ch].reload=value;
+			break;
+		default:
+			break;
+	}
+	if (3==(n&3) && value) dma_trigger(chip,ch);
+}
+
+static bool dma_pio_fifo(sim_chip* chip,uint32_t addr,bool tx,pio_sim_sm** sm){
+	int p,i;
+	for(p=0;p<2;p++){
+		for(i=0;i<4;i++){
+			if (addr==(uint32_t)(uintptr_t)(tx ? &chip->pio_hw[p].txf[i]:&chip->pio_hw[p].rxf[i])) {
+				*sm=&chip->sm[p][i];
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static uint32_t dma_next_addr(uint32_t addr,int inc,const dma_channel_config* c,bool write){
+	uint32_t mask;
+	if (c->ring_bits && c->ring_write==write) {
+		mask=(1u<<c->ring_bits)-1;
+		return (addr&~mask)|((addr+inc)&mask);
+	}
+	return addr+inc;
+}
+
+static void dma_step(sim_chip* chip){
+	int ch,size,rsize,p,sm;
+	uint32_t r,w,base;
+	uint64_t v;
+	bool regs;
+	pio_sim_sm* psm;
+	sim_dma_channel* d;
+	dma_channel_hw_t* hw;
+	for(ch=0;ch<NUM_DMA_CHANNELS;ch++){
+		d=&chip->dma_ch[ch];
+		if (!d->busy) continue;
+		hw=&chip->dma.ch[ch];
+		// Data request
+		if (DREQ_FORCE!=d->config.dreq) {
+			if (16<=d->config.dreq) continue; // PWM is not simulated
+			p=d->config.dreq/8;
+			sm=d->config.dreq%4;
+			if (d->config.dreq&4) {
+				if (pio_sim_rx_empty(&chip->sm[p][sm])) continue;
+			} else {
+				if (pio_sim_tx_full(&chip->sm[p][sm])) continue;
+			}
+		}
+		size=1<<d->config.size;
+		r=hw->read_addr;
+		w=hw->write_addr;
+		base=(uint32_t)(uintptr_t)chip->dma.ch;
+		regs=base<=w && w<base+sizeof(chip->dma.ch);
+		rsize=regs ? sizeof(void*):size;
+		// Read
+		v=0;
+		if (dma_pio_fifo(chip,r,false,&psm)) {
+			unsigned int data;
+			pio_sim_get(psm,&data);
+			v=data;
+			if (sim_on_receive && &sim_slave==chip) sim_on_receive(data);
+		} else {
+			memcpy(&v,(void*)(uintptr_t)r,rsize);
+		}
+		// Write
+		if (dma_pio_fifo(chip,w,true,&psm)) {
+			pio_sim_put(psm,v);
+			if (sim_on_send && &sim_master==chip) sim_on_send(v);
+		} else if (regs) {
+			dma_reg_write(chip,(w-base)/sizeof(dma_channel_hw_t),((w-base)%sizeof(dma_channel_hw_t))/4,v);
+		} else {
+			memcpy((void*)(uintptr_t)w,&v,size);
+		}
+		if (d->config.read_increment) hw->read_addr=dma_next_addr(r,rsize,&d->config,false);
+		if (d->config.write_increment) hw->write_addr=dma_next_addr(w,size,&d->config,true);
+		if (0==--hw->transfer_count) dma_complete(chip,ch);
+	}
+}
+
+/*
+	Clock
+*/
+
+static void chip_cycle(sim_chip* chip,sim_chip* other,bool master){
+	int p,i;
+	chip->cycles++;
+	// SysTick counts down from RVR (CSR bit 0: enable)
+	if (chip->systick.csr&1) chip->systick.cvr=chip->systick.cvr ? chip->systick.cvr-1:chip->systick.rvr;
+	bus_update(chip,other,master);
+	for(p=0;p<2;p++){
+		for(i=0;i<4;i++) if (chip->sm[p][i].prog) pio_sim_step(&chip->sm[p][i]);
+	}
+	dma_step(chip);
+}
+
+/*
+	Run the simulation for the cycles of master
+	(and the cycles of slave in the same time)
+*/
+void sim_run(unsigned int master_cycles){
+	sim_lock();
+	while(master_cycles){
+		if (g_master_time<=g_slave_time) {
+			chip_cycle(&sim_master,&sim_slave,true);
+			g_master_time+=sim_master.period;
+			master_cycles--;
+		} else {
+			chip_cycle(&sim_slave,&sim_master,false);
+			g_slave_time+=sim_slave.period;
+		}
+	}
+	sim_unlock();
+}
+
+/*
+	Call an IRQ handler in the context of the chip
+	The caller must hold the interrupt lock of the chip.
+*/
+void sim_call_irq(sim_chip* chip,uint num){
+	sim_chip* save=g_chip;
+	uint32_t events;
+	int pin;
+	g_chip=chip;
+	if (IO_IRQ_BANK0==num) {
+		sim_lock();
+		events=chip->gpio_events;
+		chip->gpio_events=0;
+		sim_unlock();
+		for(pin=0;pin<32;pin++){
+			if (!((events>>pin)&1)) continue;
+			chip->gpio_callback(pin,(chip->gpio_fall>>pin)&1 ? GPIO_IRQ_EDGE_FALL:GPIO_IRQ_EDGE_RISE);
+		}
+	} else {
+		chip->irq_handler[num]();
+	}
+	g_chip=save;
+}
+
+/*
+	Call the handlers of pending IRQs if the interrupts are enabled
+*/
+void sim_deliver_irqs(sim_chip* chip){
+	uint32_t pending;
+	uint num;
+	sim_lock();
+	pending=chip->irq_pending;
+	sim_unlock();
+	for(num=0;num<SIM_IRQ_NUM;num++){
+		if (!((pending>>num)&1)) continue;
+		if (!chip->irq_enabled[num] || (IO_IRQ_BANK0==num ? !chip->gpio_callback:!chip->irq_handler[num])) {
+			sim_lock();
+			chip->irq_pending&=~(1u<<num);
+			sim_unlock();
+			continue;
+		}
+		if (pthread_mutex_trylock(&chip->irq_lock)) continue;
+		sim_lock();
+		chip->irq_pending&=~(1u<<num);
+		sim_unlock();
+		g_irq_depth++;
+		sim_call_irq(chip,num);
+		g_irq_depth--;
+		pthread_mutex_unlock(&chip->irq_lock);
+	}
+}
+
+const pio_sim_sm* sim_find_sm(sim_chip* chip,const char* program){
+	int p,i;
+	for(p=0;p<2;p++){
+		for(i=0;i<4;i++){
+			if (chip->sm[p][i].prog && !strcmp(chip->sm[p][i].prog->name,program)) return &chip->sm[p][i];
+		}
+	}
+	return 0;
+}
+
+/*
+	Pico SDK: GPIO and others
+*/
+
+void gpio_init(uint gpio){
+	gpio_init_mask(1u<<gpio);
+}
+
+void gpio_init_mask(uint32_t mask){
+	sim_lock();
+	g_chip->pio_func&=~mask;
+	g_chip->sio_oe&=~mask;
+	g_chip->sio_out&=~mask;
+	sim_unlock();
+}
+
+void gpio_set_dir(uint gpio,bool out){
+	sim_lock();
+	if (out) g_chip->sio_oe|=1u<<gpio;
+	else g_chip->sio_oe&=~(1u<<gpio);
+	sim_unlock();
+}
+
+void gpio_set_dir_in_masked(uint32_t mask){
+	sim_lock();
+	g_chip->sio_oe&=~mask;
+	sim_unlock();
+}
+
+void gpio_set_dir_out_masked(uint32_t mask){
+	sim_lock();
+	g_chip->sio_oe|=mask;
+	sim_unlock();
+}
+
+void gpio_set_function(uint gpio,enum gpio_function fn){
+	sim_lock();
+	if (GPIO_FUNC_PIO0==fn) g_chip->pio_func|=1u<<gpio;
+	else g_chip->pio_func&=~(1u<<gpio);
+	sim_unlock();
+}
+
+void gpio_pull_up(uint gpio){
+	// All pins are pulled up in the simulation
+}
+
+void gpio_put(uint gpio,bool value){
+	sim_lock();
+	if (value) g_chip->sio_out|=1u<<gpio;
+	else g_chip->sio_out&=~(1u<<gpio);
+	sim_unlock();
+}
+
+bool gpio_get(uint gpio){
+	bool v=(g_chip->pio.in>>gpio)&1;
+	sim_poll();
+	return v;
+}
+
+uint32_t gpio_get_all(void){
+	return g_chip->pio.in;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio,uint32_t events,bool enabled,gpio_irq_callback_t callback){
+	sim_lock();
+	g_chip->gpio_callback=callback;
+	if (enabled && (events&GPIO_IRQ_EDGE_FALL)) g_chip->gpio_fall|=1u<<gpio;
+	else g_chip->gpio_fall&=~(1u<<gpio);
+	if (enabled && (events&GPIO_IRQ_EDGE_RISE)) g_chip->gpio_rise|=1u<<gpio;
+	else g_chip->gpio_rise&=~(1u<<gpio);
+	g_chip->irq_enabled[IO_IRQ_BANK0]=true;
+	sim_unlock();
+}
+
+void sleep_ms(uint32_t ms){
+	sim_poll();
+}
+
+void sleep_us(uint64_t us){
+	sim_poll();
+}
+
+void tight_loop_contents(void){
+	sim_poll();
+}
+
+bool set_sys_clock_khz(uint32_t freq_khz,bool required){
+	g_chip->period=1000000000u/freq_khz;
+	return true;
+}
+
+uint32_t save_and_disable_interrupts(void){
+	pthread_mutex_lock(&g_chip->irq_lock);
+	g_irq_depth++;
+	return 0;
+}
+
+void restore_interrupts(uint32_t status){
+	g_irq_depth--;
+	pthread_mutex_unlock(&g_chip->irq_lock);
+	if (0==g_irq_depth && g_chip->irq_enabled_hook) g_chip->irq_enabled_hook();
+}
+
+void __sev(void){
+	g_chip->sev=true;
+}
+
+void __wfe(void){
+	sim_poll();
+}
+
+void irq_set_exclusive_handler(uint num,irq_handler_t handler){
+	g_chip->irq_handler[num]=handler;
+}
+
+void irq_set_enabled(uint num,bool enabled){
+	g_chip->irq_enabled[num]=enabled;
+}
+
+systick_hw_t* sim_systick_hw(void){
+	return &g_chip->systick;
+}
+
+uint pwm_gpio_to_slice_num(uint gpio){
+	return (gpio>>1)&7;
+}
+
+pwm_config pwm_get_default_config(void){
+	pwm_config c={0,0,0};
+	return c;
+}
+
+void pwm_config_set_clkdiv(pwm_config* c,float div){
+}
+
+void pwm_init(uint slice,pwm_config* c,bool start){
+}
+
+void pwm_set_wrap(uint slice,uint16_t wrap){
+}
+
+/*
+	Pico SDK: DMA
+*/
+
+dma_hw_t* sim_dma_hw(void){
+	return &g_chip->dma;
+}
+
+int dma_claim_unused_channel(bool required){
+	int ch;
+	for(ch=0;ch<NUM_DMA_CHANNELS;ch++){
+		if (g_chip->dma_ch[ch].claimed) continue;
+		g_chip->dma_ch[ch].claimed=true;
+		return ch;
+	}
+	if (required) fatal("no DMA channel");
+	return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel){
+	dma_channel_config c;
+	memset(&c,0,sizeof(c));
+	c.size=DMA_SIZE_32;
+	c.read_increment=true;
+	c.write_increment=false;
+	c.dreq=DREQ_FORCE;
+	c.chain_to=channel;
+	c.enable=true;
+	return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config* c,enum dma_channel_transfer_size size){
+	c->size=size;
+}
+
+void channel_config_set_read_increment(dma_channel_config* c,bool incr){
+	c->read_increment=incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config* c,bool incr){
+	c->write_increment=incr;
+}
+
+void channel_config_set_ring(dma_channel_config* c,bool write,uint size_bits){
+	c->ring_write=write;
+	c->ring_bits=size_bits;
+}
+
+void channel_config_set_dreq(dma_channel_config* c,uint dreq){
+	c->dreq=dreq;
+}
+
+void channel_config_set_chain_to(dma_channel_config* c,uint chain_to){
+	c->chain_to=chain_to;
+}
+
+void dma_channel_set_config(uint channel,const dma_channel_config* config,bool trigger){
+	sim_lock();
+	g_chip->dma_ch[channel].config=*config;
+	if (trigger) dma_trigger(g_chip,channel);
+	sim_unlock();
+}
+
+void dma_channel_configure(uint channel,const dma_channel_config* config,volatile void* write_addr,const volatile void* read_addr,uint transfer_count,bool trigger){
+	sim_lock();
+	g_chip->dma_ch[channel].config=*config;
+	g_chip->dma.ch[channel].write_addr=(uint32_t)(uintptr_t)write_addr;
+	g_chip->dma.ch[channel].read_addr=(uint32_t)(uintptr_t)read_addr;
+	g_chip->dma_ch[channel].reload=transfer_count;
+	if (trigger) dma_trigger(g_chip,channel);
+	sim_unlock();
+}
+
+void dma_channel_set_read_addr(uint channel,const volatile void* read_addr,bool trigger){
+	sim_lock();
+	g_chip->dma.ch[channel].read_addr=(uint32_t)(uintptr_t)read_addr;
+	if (trigger) dma_trigger(g_chip,channel);
+	sim_unlock();
+}
+
+void dma_channel_set_write_addr(uint channel,volatile void* write_addr,bool trigger){
+	sim_lock();
+	g_chip->dma.ch[channel].write_addr=(uint32_t)(uintptr_t)write_addr;
+	if (trigger) dma_trigger(g_chip,channel);
+	sim_unlock();
+}
+
+void dma_channel_set_trans_count(uint channel,uint32_t trans_count,bool trigger){
+	sim_lock();
+	g_chip->dma_ch[channel].reload=trans_count;
+	if (trigger) dma_trigger(g_chip,channel);
+	sim_unlock();
+}
+
+void dma_start_channel_mask(uint32_t mask){
+	int ch;
+	sim_lock();
+	for(ch=0;ch<NUM_DMA_CHANNELS;ch++) if ((mask>>ch)&1) dma_trigger(g_chip,ch);
+	sim_unlock();
+}
+
+bool dma_channel_is_busy(uint channel){
+	bool busy=g_chip->dma_ch[channel].busy;
+	sim_poll();
+	return busy;
+}
+
+void dma_set_irq0_channel_mask_enabled(uint32_t mask,bool enabled){
+	int ch;
+	for(ch=0;ch<NUM_DMA_CHANNELS;ch++) if ((mask>>ch)&1) g_chip->dma_ch[ch].irq0=enabled;
+}
+
+void dma_channel_set_irq1_enabled(uint channel,bool enabled){
+	g_chip->dma_ch[channel].irq1=enabled;
+}
+
+/*
+	Pico SDK: PIO
+*/
+
+PIO sim_pio(uint n){
+	return &g_chip->pio_hw[n];
+}
+
+static int pio_index(PIO pio){
+	return pio-g_chip->pio_hw;
+}
+
+pio_sm_config sim_pio_get_default_config(const pio_program_t* program,uint offset){
+	pio_sm_config c;
+	memset(&c,0,sizeof(c));
+	c.program=program;
+	c.offset=offset;
+	c.out_count=32;
+	c.out_shift_right=true;
+	c.in_shift_right=true;
+	return c;
+}
+
+uint pio_add_program(PIO pio,const pio_program_t* program){
+	int p=pio_index(pio);
+	pio_sim_program progs[PIO_SIM_MAX_PROGRAM];
+	const pio_sim_program* prog;
+	int num,offset;
+	num=pio_sim_load(program->file,progs,PIO_SIM_MAX_PROGRAM);
+	if (num<0) fatal("cannot load PIO program");
+	prog=pio_sim_find(progs,num,program->name);
+	if (!prog) fatal("PIO program not found");
+	if (PIO_SIM_MAX_PROGRAM<=g_chip->prog_num[p] || 32<g_chip->next_offset[p]+prog->length) fatal("no PIO instruction memory");
+	g_chip->progs[p][g_chip->prog_num[p]]=*prog;
+	offset=g_chip->next_offset[p];
+	g_chip->loaded[p][offset]=&g_chip->progs[p][g_chip->prog_num[p]++];
+	g_chip->next_offset[p]+=prog->length;
+	return offset;
+}
+
+int pio_claim_unused_sm(PIO pio,bool required){
+	int p=pio_index(pio);
+	int i;
+	for(i=0;i<4;i++){
+		if (g_chip->sm_claimed[p][i]) continue;
+		g_chip->sm_claimed[p][i]=true;
+		return i;
+	}
+	if (required) fatal("no PIO state machine");
+	return -1;
+}
+
+void pio_gpio_init(PIO pio,uint pin){
+	sim_lock();
+	g_chip->pio_func|=1u<<pin;
+	sim_unlock();
+}
+
+void pio_sm_set_pins_with_mask(PIO pio,uint sm,uint32_t values,uint32_t mask){
+	sim_lock();
+	g_chip->pio.out=(g_chip->pio.out&~mask)|(values&mask);
+	sim_unlock();
+}
+
+void pio_sm_set_pindirs_with_mask(PIO pio,uint sm,uint32_t dirs,uint32_t mask){
+	sim_lock();
+	g_chip->pio.oe=(g_chip->pio.oe&~mask)|(dirs&mask);
+	sim_unlock();
+}
+
+void sm_config_set_out_pins(pio_sm_config* c,uint base,uint count){
+	c->out_base=base;
+	c->out_count=count;
+}
+
+void sm_config_set_in_pins(pio_sm_config* c,uint base){
+	c->in_base=base;
+}
+
+void sm_config_set_sideset_pins(pio_sm_config* c,uint base){
+	c->sideset_base=base;
+}
+
+void sm_config_set_out_shift(pio_sm_config* c,bool shift_right,bool autopull,uint threshold){
+	c->out_shift_right=shift_right;
+}
+
+void sm_config_set_in_shift(pio_sm_config* c,bool shift_right,bool autopush,uint threshold){
+	c->in_shift_right=shift_right;
+}
+
+void sm_config_set_fifo_join(pio_sm_config* c,enum pio_fifo_join join){
+	c->join=join;
+}
+
+void pio_sm_init(PIO pio,uint sm,uint offset,const pio_sm_config* config){
+	int p=pio_index(pio);
+	pio_sim_sm* s=&g_chip->sm[p][sm];
+	const pio_sim_program* prog=g_chip->loaded[p][offset];
+	int i;
+	if (!prog) fatal("PIO program is not loaded at the offset");
+	// pio_sim.c shifts OSR to right and ISR to left
+	for(i=0;i<prog->length;i++){
+		switch(prog->instr[i].op){
+			case PIO_SIM_OUT_PINS:
+			case PIO_SIM_OUT_PINDIRS:
+				if (!config->out_shift_right) fatal("unsupported shift direction of OSR");
+				break;
+			case PIO_SIM_IN_PINS:
+				if (config->in_shift_right) fatal("unsupported shift direction of ISR");
+				break;
+			default:
+				break;
+		}
+	}
+	sim_lock();
+	pio_sim_sm_init(s,prog,&g_chip->pio,
+		PIO_FIFO_JOIN_TX==config->join ? 8:(PIO_FIFO_JOIN_RX==config->join ? 0:4),
+		PIO_FIFO_JOIN_RX==config->join ? 8:(PIO_FIFO_JOIN_TX==config->join ? 0:4));
+	s->out_base=config->out_base;
+	s->out_count=config->out_count;
+	s->in_base=config->in_base;
+	s->side_base=config->sideset_base;
+	s->enabled=false;
+	// The offset is kept in PC (see pio_sm_get_pc())
+	s->pc=0;
+	sim_unlock();
+}
+
+void pio_sm_set_enabled(PIO pio,uint sm,bool enabled){
+	sim_lock();
+	g_chip->sm[pio_index(pio)][sm].enabled=enabled;
+	sim_unlock();
+}
+
+uint pio_get_dreq(PIO pio,uint sm,bool is_tx){
+	return pio_index(pio)*8+sm+(is_tx ? 0:4);
+}
+
+void pio_sm_put_blocking(PIO pio,uint sm,uint32_t data){
+	bool done;
+	while(true){
+		sim_lock();
+		done=pio_sim_put(&g_chip->sm[pio_index(pio)][sm],data);
+		sim_unlock();
+		if (done) break;
+		sim_poll();
+	}
+}
+
+void pio_sm_clear_fifos(PIO pio,uint sm){
+	sim_lock();
+	pio_sim_clear_fifos(&g_chip->sm[pio_index(pio)][sm]);
+	sim_unlock();
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio,uint sm){
+	bool empty=pio_sim_tx_empty(&g_chip->sm[pio_index(pio)][sm]);
+	if (!empty) sim_poll();
+	return empty;
+}
+
+uint8_t pio_sm_get_pc(PIO pio,uint sm){
+	int p=pio_index(pio);
+	const pio_sim_sm* s=&g_chip->sm[p][sm];
+	int offset;
+	sim_poll();
+	for(offset=0;offset<32;offset++) if (g_chip->loaded[p][offset]==s->prog) break;
+	return offset+s->pc;
+}
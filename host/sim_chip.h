@@ -0,0 +1,98 @@
+/*
+	Simulated RP2040 chips for the host co-simulation
+
+	Each chip has GPIO, two PIO blocks (pio_sim.c), DMA channels, and IRQ
+	handlers. The Pico SDK functions in sdk/ work on the chip of the calling
+	thread (sim_set_chip()). sim_run() advances the clocks of both chips,
+	steps the state machines and DMA, and moves the levels on the bus.
+
+	Interrupts: save_and_disable_interrupts() takes the interrupt lock of
+	the chip, and the bus thread calls an IRQ handler only when it can take
+	the lock. So a handler never runs while the interrupts are disabled,
+	but the code of the CPU is not stopped while the handler runs.
+
+	DMA channels whose destination is a DMA register (e.g. the control
+	channel of the blitter) read pointer sized words, as the lists of
+	addresses are made of pointers on the host.
+*/
+
+#ifndef SIM_CHIP_H
+#define SIM_CHIP_H
+
+#include <pthread.h>
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "hardware/structs/systick.h"
+#include "pio_sim.h"
+
+#define SIM_IRQ_NUM 32
+
+typedef struct {
+	dma_channel_config config;
+	uint32_t reload;
+	bool claimed;
+	bool busy;
+	bool irq0,irq1;
+} sim_dma_channel;
+
+typedef struct {
+	const char* name;
+	unsigned int period; // Clock period in ps
+	unsigned long long cycles;
+	// GPIO: PIO drives pio.out and pio.oe, CPU drives sio_out and sio_oe
+	pio_sim_gpio pio;
+	uint32_t sio_out,sio_oe;
+	uint32_t pio_func;   // Pins whose function is PIO
+	uint32_t pins;       // Levels of the pins (not synchronized)
+	unsigned long long falls[32]; // Falling edges of each pin
+	// PIO
+	pio_hw_t pio_hw[2];
+	pio_sim_program progs[2][PIO_SIM_MAX_PROGRAM];
+	int prog_num[2];
+	const pio_sim_program* loaded[2][32]; // Program at each offset
+	int next_offset[2];
+	pio_sim_sm sm[2][4];
+	bool sm_claimed[2][4];
+	// DMA
+	dma_hw_t dma __attribute__ ((aligned (64))); // Aligned for the ring of the blitter
+	sim_dma_channel dma_ch[NUM_DMA_CHANNELS];
+	// IRQ
+	irq_handler_t irq_handler[SIM_IRQ_NUM];
+	bool irq_enabled[SIM_IRQ_NUM];
+	uint32_t irq_pending;
+	gpio_irq_callback_t gpio_callback;
+	uint32_t gpio_fall,gpio_rise,gpio_events;
+	pthread_mutex_t irq_lock;
+	// Called when a thread enables the interrupts again, where an IRQ
+	// would be taken by the real chip (see cosim_start_interrupt())
+	void (*irq_enabled_hook)(void);
+	// Others
+	systick_hw_t systick;
+	bool sev;
+} sim_chip;
+
+/*
+	Words passing the bus, called with the simulation locked
+	sim_on_send(): a word is written to TX FIFO of the master state machine
+	sim_on_receive(): a word is read from RX FIFO of the slave state machine
+*/
+extern void (*sim_on_send)(uint32_t word);
+extern void (*sim_on_receive)(uint32_t word);
+
+extern sim_chip sim_master,sim_slave;
+extern volatile bool sim_stop;
+
+void sim_init(const int* wire,int num);
+void sim_set_chip(sim_chip* chip);
+sim_chip* sim_get_chip(void);
+void sim_lock(void);
+void sim_unlock(void);
+void sim_poll(void);
+void sim_run(unsigned int master_cycles);
+void sim_deliver_irqs(sim_chip* chip);
+void sim_call_irq(sim_chip* chip,uint num);
+const pio_sim_sm* sim_find_sm(sim_chip* chip,const char* program);
+
+#endif // SIM_CHIP_H
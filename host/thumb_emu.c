@@ -0,0 +1,535 @@
+/*
+	Thumb (ARMv6-M) emulator for the object code of the BASIC compiler
+	The object in kmbasic_object[] runs with the same data of the runtime as
+	on the RP2040: r5 points kmbasic_variables[], r6 the argument array, r7
+	kmbasic_data[], and "blx r8" calls kmbasic_library(). Everything is
+	linked in the low 4 GB (-no-pie), so the addresses are the host ones.
+
+	Only the library functions needed for integer and float calculations,
+	GOSUB, GOTO to a line number by a value, and END are emulated (see
+	library()). Any other one, and any access out of the areas below, stops
+	the emulation with an error.
+
+	The registers r1-r3 and r12 are broken after a library call, as the
+	calling convention allows, to find the code that depends on them.
+*/
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "compiler.h"
+#include "thumb_emu.h"
+
+#define STACK_WORDS 4096
+#define EMU_LIBRARY 0xfffffff1 // r8 (kmbasic_library)
+#define EMU_RETURN  0xfffffffd // lr when the object is called
+#define BROKEN      0xdeadbeef // r1-r3 and r12 after a library call
+
+#define address(p) ((unsigned int)(uintptr_t)(p))
+
+static unsigned int g_stack[STACK_WORDS];
+static int g_r6[3];
+
+static const struct {
+	void* data;
+	unsigned int bytes;
+} g_areas[]={
+	{kmbasic_object,sizeof kmbasic_object},
+	{kmbasic_variables,sizeof kmbasic_variables},
+	{kmbasic_var_size,sizeof kmbasic_var_size},
+	{kmbasic_data,sizeof kmbasic_data},
+	{g_stack,sizeof g_stack},
+	{g_r6,sizeof g_r6},
+};
+
+static int error(thumb_emu* cpu,const char* format,...){
+	va_list args;
+	int n;
+	n=snprintf(cpu->message,sizeof cpu->message,"%08x: ",cpu->r[15]);
+	va_start(args,format);
+	vsnprintf(cpu->message+n,sizeof cpu->message-n,format,args);
+	va_end(args);
+	return THUMB_EMU_ERROR;
+}
+
+static void* memory(thumb_emu* cpu,unsigned int a,int size){
+	uintptr_t base;
+	int i;
+	if (a&(size-1)) {
+		error(cpu,"unaligned access to %08x",a);
+		return 0;
+	}
+	for(i=0;i<(int)(sizeof g_areas/sizeof g_areas[0]);i++){
+		base=(uintptr_t)g_areas[i].data;
+		if (base<=a && a+size<=base+g_areas[i].bytes) return (void*)(uintptr_t)a;
+	}
+	error(cpu,"access to %08x",a);
+	return 0;
+}
+
+// Returns 0 if failed
+static int load(thumb_emu* cpu,unsigned int a,int size,int sign,unsigned int* value){
+	void* p=memory(cpu,a,size);
+	if (!p) return 0;
+	switch(size){
+		case 1: *value=sign ? (unsigned int)*(signed char*)p:*(unsigned char*)p; break;
+		case 2: *value=sign ? (unsigned int)*(short*)p:*(unsigned short*)p; break;
+		default: *value=*(unsigned int*)p; break;
+	}
+	return 1;
+}
+
+static int store(thumb_emu* cpu,unsigned int a,int size,unsigned int value){
+	void* p=memory(cpu,a,size);
+	if (!p) return 0;
+	switch(size){
+		case 1: *(unsigned char*)p=value; break;
+		case 2: *(unsigned short*)p=value; break;
+		default: *(unsigned int*)p=value; break;
+	}
+	return 1;
+}
+
+/*
+	Flags
+*/
+
+static unsigned int nz(thumb_emu* cpu,unsigned int v){
+	cpu->n=v>>31;
+	cpu->z=0==v;
+	return v;
+}
+
+static unsigned int add_with_carry(thumb_emu* cpu,unsigned int a,unsigned int b,int carry){
+	unsigned long long u=(unsigned long long)a+b+carry;
+	long long s=(long long)(int)a+(int)b+carry;
+	cpu->c=u>>32;
+	cpu->v=s!=(int)(unsigned int)u;
+	return nz(cpu,u);
+}
+
+static int condition(thumb_emu* cpu,int cond){
+	switch(cond){
+		case 0x0: return cpu->z;                            // eq
+		case 0x1: return !cpu->z;                           // ne
+		case 0x2: return cpu->c;                            // cs
+		case 0x3: return !cpu->c;                           // cc
+		case 0x4: return cpu->n;                            // mi
+		case 0x5: return !cpu->n;                           // pl
+		case 0x6: return cpu->v;                            // vs
+		case 0x7: return !cpu->v;                           // vc
+		case 0x8: return cpu->c && !cpu->z;                 // hi
+		case 0x9: return !cpu->c || cpu->z;                 // ls
+		case 0xa: return cpu->n==cpu->v;                    // ge
+		case 0xb: return cpu->n!=cpu->v;                    // lt
+		case 0xc: return !cpu->z && cpu->n==cpu->v;         // gt
+		default:  return cpu->z || cpu->n!=cpu->v;          // le
+	}
+}
+
+// Shift by a register (the lowest byte of b)
+static unsigned int shift(thumb_emu* cpu,int type,unsigned int a,unsigned int b){
+	b&=0xff;
+	if (0==b) return a;
+	switch(type){
+		case 0: // lsl
+			cpu->c=b<32 ? (a>>(32-b))&1 : 32==b ? a&1:0;
+			return b<32 ? a<<b:0;
+		case 1: // lsr
+			cpu->c=b<32 ? (a>>(b-1))&1 : 32==b ? a>>31:0;
+			return b<32 ? a>>b:0;
+		case 2: // asr
+			if (32<=b) b=32;
+			cpu->c=((int)a>>(b-1))&1;
+			return b<32 ? (unsigned int)((int)a>>b) : (unsigned int)((int)a>>31);
+		default: // ror
+			b&=31;
+			if (b) a=(a>>b)|(a<<(32-b));
+			cpu->c=a>>31;
+			return a;
+	}
+}
+
+/*
+	Library
+*/
+
+static float to_float(unsigned int i){
+	float f;
+	memcpy(&f,&i,4);
+	return f;
+}
+
+static unsigned int from_float(float f){
+	unsigned int i;
+	memcpy(&i,&f,4);
+	return i;
+}
+
+// See lib_calc_float_main() in library.c
+static float calc_float(float r0,float r1,int r2){
+	switch(r2){
+		case OP_EQ:  return r1==r0 ? 1:0;
+		case OP_NEQ: return r1!=r0 ? 1:0;
+		case OP_LT:  return r1<r0 ? 1:0;
+		case OP_LTE: return r1<=r0 ? 1:0;
+		case OP_MT:  return r1>r0 ? 1:0;
+		case OP_MTE: return r1>=r0 ? 1:0;
+		case OP_ADD: return r1+r0;
+		case OP_SUB: return r1-r0;
+		case OP_MUL: return r1*r0;
+		case OP_DIV: return r1/r0;
+		case OP_OR:  return (r1||r0) ? 1:0;
+		case OP_AND: return (r1&&r0) ? 1:0;
+		default:     return r0;
+	}
+}
+
+// Returns -1 to continue
+static int library(thumb_emu* cpu){
+	unsigned int* r=cpu->r;
+	int i;
+	switch(r[3]){
+		case LIB_CALC:
+			if (OP_DIV!=r[2] && OP_REM!=r[2]) break;
+			if (0==r[0]) return error(cpu,"division by zero");
+			// INT_MIN/-1 is INT_MIN as on the RP2040
+			if (0xffffffff==r[0]) r[0]=OP_DIV==r[2] ? -r[1]:0;
+			else r[0]=OP_DIV==r[2] ? (int)r[1]/(int)r[0] : (int)r[1]%(int)r[0];
+			break;
+		case LIB_CALC_FLOAT:
+			r[0]=from_float(calc_float(to_float(r[0]),to_float(r[1]),r[2]));
+			break;
+		case LIB_POST_GOSUB:
+			// No garbage collection, as no string or object is used
+			break;
+		case LIB_END:
+			return THUMB_EMU_END;
+		case LIB_LINE_NUM:
+			// See lib_line_num() in library.c
+			for(i=g_line_table_num-1;0<=i;i--){
+				if (g_line_table[i*2+1]==(int)r[0]) break;
+			}
+			if (i<0) {
+				for(i=g_line_table_num-1;0<=i;i--){
+					if ((g_line_table[i*2+1]&0xffff)==(int)r[0]) break;
+				}
+			}
+			if (i<0) return error(cpu,"line %d not found",r[0]);
+			r[0]=g_line_table[i*2];
+			break;
+		default:
+			return error(cpu,"library %d is not supported",r[3]);
+	}
+	r[1]=r[2]=r[3]=r[12]=BROKEN;
+	return -1;
+}
+
+/*
+	Instructions
+*/
+
+// bx, blx, and pop {pc}
+static int interwork(thumb_emu* cpu,unsigned int target,unsigned int* next){
+	if (EMU_RETURN==target) return THUMB_EMU_END;
+	if (!(target&1)) return error(cpu,"branch to ARM state (%08x)",target);
+	*next=target&~1;
+	return -1;
+}
+
+static int alu(thumb_emu* cpu,unsigned int i){
+	unsigned int* r=cpu->r;
+	unsigned int rd=i&7;
+	unsigned int a=r[rd];
+	unsigned int b=r[(i>>3)&7];
+	switch((i>>6)&15){
+		case 0x0: r[rd]=nz(cpu,a&b); break;                      // ands
+		case 0x1: r[rd]=nz(cpu,a^b); break;                      // eors
+		case 0x2: r[rd]=nz(cpu,shift(cpu,0,a,b)); break;         // lsls
+		case 0x3: r[rd]=nz(cpu,shift(cpu,1,a,b)); break;         // lsrs
+		case 0x4: r[rd]=nz(cpu,shift(cpu,2,a,b)); break;         // asrs
+		case 0x5: r[rd]=add_with_carry(cpu,a,b,cpu->c); break;   // adcs
+		case 0x6: r[rd]=add_with_carry(cpu,a,~b,cpu->c); break;  // sbcs
+		case 0x7: r[rd]=nz(cpu,shift(cpu,3,a,b)); break;         // rors
+		case 0x8: nz(cpu,a&b); break;                            // tst
+		case 0x9: r[rd]=add_with_carry(cpu,0,~b,1); break;       // rsbs
+		case 0xa: add_with_carry(cpu,a,~b,1); break;             // cmp
+		case 0xb: add_with_carry(cpu,a,b,0); break;              // cmn
+		case 0xc: r[rd]=nz(cpu,a|b); break;                      // orrs
+		case 0xd: r[rd]=nz(cpu,a*b); break;                      // muls
+		case 0xe: r[rd]=nz(cpu,a&~b); break;                     // bics
+		default:  r[rd]=nz(cpu,~b); break;                       // mvns
+	}
+	return -1;
+}
+
+// add, cmp, mov, bx, and blx with high registers
+static int high_registers(thumb_emu* cpu,unsigned int i,unsigned int pc,unsigned int* next){
+	unsigned int* r=cpu->r;
+	unsigned int rd=(i&7)|((i>>4)&8);
+	unsigned int rm=(i>>3)&15;
+	unsigned int b=15==rm ? pc+4:r[rm];
+	int k;
+	switch((i>>8)&3){
+		case 0: // add
+			if (15==rd) *next=(pc+4+b)&~1;
+			else r[rd]+=b;
+			return -1;
+		case 1: // cmp
+			add_with_carry(cpu,15==rd ? pc+4:r[rd],~b,1);
+			return -1;
+		case 2: // mov
+			if (15==rd) *next=b&~1;
+			else r[rd]=b;
+			return -1;
+		default:
+			if (!(i&0x80)) return interwork(cpu,b,next); // bx
+			// blx
+			r[14]=*next|1;
+			if (EMU_LIBRARY!=b) return interwork(cpu,b,next);
+			kmbasic_data[3]=r[14];
+			k=library(cpu);
+			if (0<=k) return k;
+			return -1;
+	}
+}
+
+static int load_store(thumb_emu* cpu,unsigned int i,unsigned int pc){
+	unsigned int* r=cpu->r;
+	unsigned int rd=i&7;
+	unsigned int base=r[(i>>3)&7];
+	unsigned int a,imm5=(i>>6)&31;
+	int ok;
+	switch(i>>11){
+		case 0x0a: case 0x0b: // Register offset
+			a=base+r[(i>>6)&7];
+			switch((i>>9)&7){
+				case 0: ok=store(cpu,a,4,r[rd]); break;  // str
+				case 1: ok=store(cpu,a,2,r[rd]); break;  // strh
+				case 2: ok=store(cpu,a,1,r[rd]); break;  // strb
+				case 3: ok=load(cpu,a,1,1,&r[rd]); break; // ldrsb
+				case 4: ok=load(cpu,a,4,0,&r[rd]); break; // ldr
+				case 5: ok=load(cpu,a,2,0,&r[rd]); break; // ldrh
+				case 6: ok=load(cpu,a,1,0,&r[rd]); break; // ldrb
+				default: ok=load(cpu,a,2,1,&r[rd]); break; // ldrsh
+			}
+			break;
+		case 0x0c: ok=store(cpu,base+imm5*4,4,r[rd]); break;   // str	rd, [rn, #xx]
+		case 0x0d: ok=load(cpu,base+imm5*4,4,0,&r[rd]); break; // ldr	rd, [rn, #xx]
+		case 0x0e: ok=store(cpu,base+imm5,1,r[rd]); break;     // strb
+		case 0x0f: ok=load(cpu,base+imm5,1,0,&r[rd]); break;   // ldrb
+		case 0x10: ok=store(cpu,base+imm5*2,2,r[rd]); break;   // strh
+		case 0x11: ok=load(cpu,base+imm5*2,2,0,&r[rd]); break; // ldrh
+		case 0x09: // ldr	rd, [pc, #xx]
+			ok=load(cpu,((pc+4)&~3)+(i&0xff)*4,4,0,&r[(i>>8)&7]);
+			break;
+		case 0x12: // str	rd, [sp, #xx]
+			ok=store(cpu,r[13]+(i&0xff)*4,4,r[(i>>8)&7]);
+			break;
+		default: // ldr	rd, [sp, #xx]
+			ok=load(cpu,r[13]+(i&0xff)*4,4,0,&r[(i>>8)&7]);
+			break;
+	}
+	return ok ? -1:THUMB_EMU_ERROR;
+}
+
+// ldmia, stmia, push, and pop
+static int multiple(thumb_emu* cpu,unsigned int i,unsigned int* next){
+	unsigned int* r=cpu->r;
+	unsigned int a,v,list;
+	int k,rn;
+	list=i&0xff;
+	switch(i&0xfe00){
+		case 0xb400: // push
+			if (i&0x100) list|=1<<14;
+			for(k=0;k<16;k++) if (list&(1<<k)) r[13]-=4;
+			a=r[13];
+			for(k=0;k<16;k++){
+				if (!(list&(1<<k))) continue;
+				if (!store(cpu,a,4,r[k])) return THUMB_EMU_ERROR;
+				a+=4;
+			}
+			return -1;
+		case 0xbc00: // pop
+			a=r[13];
+			for(k=0;k<8;k++){
+				if (!(list&(1<<k))) continue;
+				if (!load(cpu,a,4,0,&r[k])) return THUMB_EMU_ERROR;
+				a+=4;
+			}
+			if (i&0x100) {
+				if (!load(cpu,a,4,0,&v)) return THUMB_EMU_ERROR;
+				a+=4;
+				r[13]=a;
+				return interwork(cpu,v,next);
+			}
+			r[13]=a;
+			return -1;
+	}
+	rn=(i>>8)&7;
+	a=r[rn];
+	for(k=0;k<8;k++){
+		if (!(list&(1<<k))) continue;
+		if (i&0x0800) {
+			if (!load(cpu,a,4,0,&r[k])) return THUMB_EMU_ERROR; // ldmia
+		} else {
+			if (!store(cpu,a,4,r[k])) return THUMB_EMU_ERROR;   // stmia
+		}
+		a+=4;
+	}
+	if (!(i&0x0800) || !(list&(1<<rn))) r[rn]=a;
+	return -1;
+}
+
+static int misc(thumb_emu* cpu,unsigned int i,unsigned int* next){
+	unsigned int* r=cpu->r;
+	unsigned int rd=i&7;
+	unsigned int rm=r[(i>>3)&7];
+	switch(i&0xff00){
+		case 0xb000: // add	sp, #xx (or sub	sp, #xx)
+			if (i&0x80) r[13]-=(i&0x7f)*4;
+			else r[13]+=(i&0x7f)*4;
+			return -1;
+		case 0xb200:
+			switch((i>>6)&3){
+				case 0: r[rd]=(short)rm; break;          // sxth
+				case 1: r[rd]=(signed char)rm; break;    // sxtb
+				case 2: r[rd]=rm&0xffff; break;          // uxth
+				default: r[rd]=rm&0xff; break;           // uxtb
+			}
+			return -1;
+		case 0xba00:
+			switch((i>>6)&3){
+				case 0: r[rd]=__builtin_bswap32(rm); break;                          // rev
+				case 1: r[rd]=((rm>>8)&0x00ff00ff)|((rm<<8)&0xff00ff00); break;      // rev16
+				case 3: r[rd]=(short)(((rm>>8)&0xff)|((rm<<8)&0xff00)); break;       // revsh
+				default: return error(cpu,"undefined code %04x",i);
+			}
+			return -1;
+		case 0xbf00: // nop and the other hints
+			return -1;
+		case 0xb400: case 0xb500: case 0xbc00: case 0xbd00:
+			return multiple(cpu,i,next);
+		default:
+			return error(cpu,"undefined code %04x",i);
+	}
+}
+
+static int step(thumb_emu* cpu){
+	unsigned int* r=cpu->r;
+	unsigned int pc=r[15];
+	unsigned int next=pc+2;
+	unsigned int i,j,a,b,s,imm;
+	int k;
+	if (!load(cpu,pc,2,0,&i)) return THUMB_EMU_ERROR;
+	a=r[(i>>3)&7];
+	k=-1;
+	switch(i>>11){
+		case 0x00: // lsls	rd, rm, #xx
+			imm=(i>>6)&31;
+			r[i&7]=nz(cpu,imm ? shift(cpu,0,a,imm):a);
+			break;
+		case 0x01: // lsrs	rd, rm, #xx
+			imm=(i>>6)&31;
+			r[i&7]=nz(cpu,shift(cpu,1,a,imm ? imm:32));
+			break;
+		case 0x02: // asrs	rd, rm, #xx
+			imm=(i>>6)&31;
+			r[i&7]=nz(cpu,shift(cpu,2,a,imm ? imm:32));
+			break;
+		case 0x03: // adds/subs	rd, rn, rm (or #xx)
+			b=(i&0x400) ? (i>>6)&7 : r[(i>>6)&7];
+			if (i&0x200) r[i&7]=add_with_carry(cpu,a,~b,1);
+			else r[i&7]=add_with_carry(cpu,a,b,0);
+			break;
+		case 0x04: // movs	rd, #xx
+			r[(i>>8)&7]=nz(cpu,i&0xff);
+			break;
+		case 0x05: // cmp	rd, #xx
+			add_with_carry(cpu,r[(i>>8)&7],~(i&0xff),1);
+			break;
+		case 0x06: // adds	rd, #xx
+			r[(i>>8)&7]=add_with_carry(cpu,r[(i>>8)&7],i&0xff,0);
+			break;
+		case 0x07: // subs	rd, #xx
+			r[(i>>8)&7]=add_with_carry(cpu,r[(i>>8)&7],~(i&0xff),1);
+			break;
+		case 0x08:
+			if (i&0x400) k=high_registers(cpu,i,pc,&next);
+			else k=alu(cpu,i);
+			break;
+		case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+		case 0x10: case 0x11: case 0x12: case 0x13:
+			k=load_store(cpu,i,pc);
+			break;
+		case 0x14: // adr	rd, label
+			r[(i>>8)&7]=((pc+4)&~3)+(i&0xff)*4;
+			break;
+		case 0x15: // add	rd, sp, #xx
+			r[(i>>8)&7]=r[13]+(i&0xff)*4;
+			break;
+		case 0x16: case 0x17:
+			k=misc(cpu,i,&next);
+			break;
+		case 0x18: case 0x19:
+			k=multiple(cpu,i,&next);
+			break;
+		case 0x1a: case 0x1b: // bxx.n	label
+			if (0xe==((i>>8)&15) || 0xf==((i>>8)&15)) return error(cpu,"undefined code %04x",i);
+			if (condition(cpu,(i>>8)&15)) next=pc+4+(int)(signed char)(i&0xff)*2;
+			break;
+		case 0x1c: // b.n	label
+			next=pc+4+((int)((i&0x7ff)<<21)>>20);
+			break;
+		case 0x1e: // bl	label
+			if (!load(cpu,pc+2,2,0,&j)) return THUMB_EMU_ERROR;
+			if (0xd000!=(j&0xd000)) return error(cpu,"undefined code %04x %04x",i,j);
+			s=(i>>10)&1;
+			imm=(s<<24)|((!(((j>>13)&1)^s))<<23)|((!(((j>>11)&1)^s))<<22)|((i&0x3ff)<<12)|((j&0x7ff)<<1);
+			r[14]=(pc+4)|1;
+			next=pc+4+((int)(imm<<7)>>7);
+			break;
+		default:
+			return error(cpu,"undefined code %04x",i);
+	}
+	if (0<=k) return k;
+	r[15]=next;
+	return -1;
+}
+
+/*
+	Public functions
+*/
+
+void thumb_emu_init(thumb_emu* cpu){
+	memset(cpu,0,sizeof *cpu);
+	// The area of variables is also used by the compiler (g_file_buffer etc.)
+	memset(kmbasic_variables,0,sizeof kmbasic_variables);
+	memset(kmbasic_var_size,0,sizeof kmbasic_var_size);
+	memset(kmbasic_data,0,sizeof kmbasic_data);
+	g_r6[0]=0;
+	g_r6[1]=address(g_r6);
+	g_r6[2]=0;
+	cpu->r[5]=address(kmbasic_variables);
+	cpu->r[6]=address(g_r6);
+	cpu->r[7]=address(kmbasic_data);
+	cpu->r[8]=EMU_LIBRARY;
+	cpu->r[13]=address(g_stack+STACK_WORDS);
+	cpu->r[14]=EMU_RETURN;
+	cpu->r[15]=address(kmbasic_object);
+	kmbasic_data[0]=cpu->r[13];
+	kmbasic_data[2]=address(kmbasic_var_size);
+}
+
+int thumb_emu_run(thumb_emu* cpu,unsigned long max_steps){
+	int k;
+	for(;cpu->steps<max_steps;cpu->steps++){
+		k=step(cpu);
+		if (0<=k) {
+			cpu->steps++;
+			return k;
+		}
+	}
+	return THUMB_EMU_TIMEOUT;
+}
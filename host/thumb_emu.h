@@ -0,0 +1,27 @@
+/*
+	Thumb (ARMv6-M) emulator for the object code of the BASIC compiler
+	(see thumb_emu.c)
+*/
+
+#ifndef THUMB_EMU_H
+#define THUMB_EMU_H
+
+// Results of thumb_emu_run()
+#define THUMB_EMU_END     0 // END statement, or return from the object code
+#define THUMB_EMU_TIMEOUT 1 // max_steps instructions are executed
+#define THUMB_EMU_ERROR   2 // see message
+
+typedef struct {
+	unsigned int r[16];
+	int n,z,c,v;
+	unsigned long steps;
+	char message[128];
+} thumb_emu;
+
+// Sets the registers and the data of the runtime (as run_code() and
+// pre_run() do) for the object just compiled in kmbasic_object[]
+void thumb_emu_init(thumb_emu* cpu);
+
+int thumb_emu_run(thumb_emu* cpu,unsigned long max_steps);
+
+#endif
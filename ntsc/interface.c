@@ -2,7 +2,9 @@
 #include "text_graph_library.h"
 #include <stdlib.h>
 #include "pico/stdlib.h"
-#include "text_graph_library.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "interface.pio.h"
 
 /*
 	GP0-GP7: 8 bit I/O
@@ -10,6 +12,7 @@
 	GP9: MOSI, /WR
 	GP10: MOSI, /RD
 	GP11: MISO, /BUSY
+	GP12: MISO, /VSYNC (see rp2040_pwm_ntsc_textgraph.c)
 */
 
 #define MOSI_DC_PIN 8
@@ -35,23 +38,240 @@
 #define COMMAND_CLS			   0x96
 #define COMMAND_SET_PALETTE    0x97
 #define COMMAND_TEXTREDRAW     0x98
+#define COMMAND_SCROLL_UP      0x99
+#define COMMAND_SCROLL_DOWN    0x9A
+#define COMMAND_WINDOW_SCROLL  0x9B
+#define COMMAND_SET_PALETTE_RANGE 0x9C
+#define COMMAND_WRITE_TVRAM_RECT  0x9D
+#define COMMAND_TEXTREDRAW_RLE 0x9E
+#define COMMAND_G_PSET         0xA0
+#define COMMAND_G_GLINE        0xA1
+#define COMMAND_G_HLINE        0xA2
+#define COMMAND_G_BOXFILL      0xA3
+#define COMMAND_G_CIRCLE       0xA4
+#define COMMAND_G_CIRCLEFILL   0xA5
+#define COMMAND_G_PUTBMPMN     0xA6
+#define COMMAND_G_CLRBMPMN     0xA7
+#define COMMAND_G_PUTFONT      0xA8
+#define COMMAND_G_PRINTSTR     0xA9
+#define COMMAND_G_CLEARSCREEN  0xAA
+#define COMMAND_G_DRAWPAGE     0xAB
+#define COMMAND_G_DISPLAYPAGE  0xAC
+#define COMMAND_G_FLIP         0xAD
+#define COMMAND_SPRITE_PATTERN 0xAE
+#define COMMAND_SPRITE_DEFINE  0xAF
+#define COMMAND_SPRITE_MOVE    0xB0
+#define COMMAND_SPRITE_RESET   0xB1
+#define COMMAND_TILE_MODE      0xB2
+#define COMMAND_TILE_PATTERN   0xB3
+#define COMMAND_TILE_MAP       0xB4
+#define COMMAND_TILE_SCROLL    0xB5
+#define COMMAND_LINE_SCROLL    0xB6
+#define COMMAND_READ_PIXEL     0xB7
+#define COMMAND_READ_TVRAM     0xB8
+#define COMMAND_READ_STATUS    0xB9
+#define COMMAND_RESET_STATUS   0xBA
+#define COMMAND_USE_PCG        0xBB
+#define COMMAND_PCG_DEFINE     0xBC
+#define COMMAND_PCG_RESET      0xBD
+#define COMMAND_BLIT_PATTERN   0xBE
+#define COMMAND_G_COPY         0xBF
+#define COMMAND_G_FILL         0xC0
+#define COMMAND_G_BLIT         0xC1
+#define COMMAND_G_GET          0xC2
+#define COMMAND_G_PALETTE_BANK 0xC3
+
+// Status numbers for COMMAND_READ_STATUS
+#define STATUS_DRAWCOUNT     0
+#define STATUS_QUEUE         1
+#define STATUS_QUEUE_MAX     2
+#define STATUS_QUEUE_FULL    3
+#define STATUS_LINE_MAX      4
+#define STATUS_LINE_AVG      5
+#define STATUS_LINE_OVERRUN  6
 
 static unsigned char g_command;
-static unsigned char g_parameters[256];
+static unsigned char g_parameters[256] __attribute__ ((aligned (4)));
 static unsigned char g_parameter_pos;
 static short* g_short_parameters=(short*)&g_parameters[0];
 static int* g_int_parameters=(int*)&g_parameters[0];
 static int g_redraw_pos;
+static int g_rle_count;
+static bool g_rle_run;
+static int g_bmp_x,g_bmp_y;
+
+/*
+	Receiving data by PIO (see interface.pio)
+	DMA transfers the received data (data in bit 0-7, DC in bit 8) from
+	RX FIFO to the ring buffer, and main_loop() executes them.
+	When the ring buffer is full, DMA stops and the state machine keeps
+	/BUSY L until main_loop() restarts DMA.
+*/
+#define RECEIVE_PIO pio0
+#define RECEIVE_RING_BITS 12
+#define RECEIVE_RING_SIZE (1<<RECEIVE_RING_BITS)
+#define RECEIVE_RING_MASK (RECEIVE_RING_SIZE-1)
+
+static unsigned short g_receive_ring[RECEIVE_RING_SIZE] __attribute__ ((aligned (RECEIVE_RING_SIZE*2)));
+static unsigned int g_receive_ring_rpos;
+static unsigned int g_receive_sm;
+static unsigned int g_receive_offset;
+static unsigned int g_receive_dma;
+static unsigned int g_read_sm;
+static unsigned int g_read_offset;
+
+// Statistics of the ring buffer
+static unsigned int g_queue_depth;
+static unsigned int g_queue_max;
+static unsigned int g_queue_full;
+
+/*
+	Range commands
+
+	COMMAND_SET_PALETTE_RANGE: num (16 bit),n, then b,r,g of palette n, n+1, ... (num entries)
+	COMMAND_WRITE_TVRAM_RECT:  x,y,w,h, then w*h characters and w*h colors (row by row)
+	COMMAND_TEXTREDRAW_RLE:    run-length encoded characters and colors of whole screen
+		0x00-0x7F: c, then c+1 literal bytes
+		0x80-0xFF: c, then a byte repeated (c-0x80)+2 times
+
+	Graphic commands
+	Coordinates are sent as 16 bit signed integers (little endian)
+
+	COMMAND_G_PSET:        x,y,c
+	COMMAND_G_GLINE:       x1,y1,x2,y2,c
+	COMMAND_G_HLINE:       x1,x2,y,c
+	COMMAND_G_BOXFILL:     x1,y1,x2,y2,c
+	COMMAND_G_CIRCLE:      x0,y0,r,c
+	COMMAND_G_CIRCLEFILL:  x0,y0,r,c
+	COMMAND_G_PUTBMPMN:    x,y,m,n, then m*n bytes of bitmap
+	COMMAND_G_CLRBMPMN:    x,y,m,n
+	COMMAND_G_PUTFONT:     x,y,bc,c,n
+	COMMAND_G_PRINTSTR:    x,y,bc,c, then null-terminated string
+	COMMAND_G_CLEARSCREEN: (none)
+	COMMAND_G_DRAWPAGE:    p
+	COMMAND_G_DISPLAYPAGE: p (takes effect at the next vertical blanking)
+	COMMAND_G_PALETTE_BANK: b (4 bpp mode only; dot n is shown in palette b*16+n
+	                        from the next vertical blanking)
+	COMMAND_G_FLIP:        (none; waits for the next vertical blanking)
+
+	Sprite commands
+	Changes of sprites take effect at the next vertical blanking
+
+	COMMAND_SPRITE_PATTERN: a, then bytes to write in sprite_pattern[] from a
+	COMMAND_SPRITE_DEFINE:  a,n,w,h,key (w=0 or h=0 hides the sprite)
+	COMMAND_SPRITE_MOVE:    x,y,n
+	COMMAND_SPRITE_RESET:   (none; hides all sprites)
+
+	Tile commands
+	Changes of the mode and scroll registers take effect at the next vertical blanking
+
+	COMMAND_TILE_MODE:    m (0: graphic, also clears scroll; 1: tile map)
+	COMMAND_TILE_PATTERN: a, then bytes to write in tile_pattern[] from a
+	COMMAND_TILE_MAP:     a, then bytes to write in tilemap[] from a
+	COMMAND_TILE_SCROLL:  x,y
+	COMMAND_LINE_SCROLL:  y, then 16 bit x offsets of line y, y+1, ... (little endian)
+
+	Read commands
+	The result is read by the master through /RD (see parallel_slave_read
+	in interface.pio). The state machine keeps /BUSY H until the result is
+	ready, so the master may read just after sending the command.
+
+	COMMAND_READ_PIXEL:   x,y (result: palette number of the drawing page)
+	COMMAND_READ_TVRAM:   a (result: character (or color) at position a of the screen)
+	COMMAND_READ_STATUS:  n (result: 32 bit value of STATUS_xxx, little endian)
+	COMMAND_RESET_STATUS: (none; resets maximum and counters)
+
+	PCG commands
+	COMMAND_USE_PCG:    m (1: use PCG, 0: use system font)
+	COMMAND_PCG_DEFINE: n, then 8 bytes of font of character n
+	COMMAND_PCG_RESET:  (none; copies system font to PCG)
+
+	Blitter commands
+	Rectangles are transferred by DMA. The commands return before the transfer
+	finishes; graphic commands wait for it before touching the pages.
+
+	COMMAND_BLIT_PATTERN: a, then bytes to write in blit_pattern[] from a
+	COMMAND_G_COPY:       x1,y1,w,h,x2,y2 (copies w*h dots from (x1,y1) to (x2,y2))
+	COMMAND_G_FILL:       x1,y1,x2,y2,c
+	COMMAND_G_BLIT:       x,y,w,h,a,key (draws w*h dots from blit_pattern[a]; key<0: no transparent color)
+	COMMAND_G_GET:        x,y,w,h,a (copies w*h dots at (x,y) to blit_pattern[a])
+*/
+
+void put_read_data(unsigned char data8){
+	// Data will be sent to the master when /RD becomes L
+	pio_sm_put_blocking(RECEIVE_PIO,g_read_sm,data8);
+}
+
+void read_status(unsigned char n){
+	unsigned int i,v;
+	// Discard the results that were not read
+	pio_sm_clear_fifos(RECEIVE_PIO,g_read_sm);
+	switch(n){
+		case STATUS_DRAWCOUNT:    v=drawcount;        break;
+		case STATUS_QUEUE:        v=g_queue_depth;    break;
+		case STATUS_QUEUE_MAX:    v=g_queue_max;      break;
+		case STATUS_QUEUE_FULL:   v=g_queue_full;     break;
+		case STATUS_LINE_MAX:     v=line_cycles_max;  break;
+		case STATUS_LINE_AVG:     v=line_cycles_avg;  break;
+		case STATUS_LINE_OVERRUN: v=line_overrun;     break;
+		default:                  v=0;                break;
+	}
+	for(i=0;i<4;i++) put_read_data(v>>(i*8));
+}
+
+void put_bmp_pixel(unsigned char data8){
+	// Put a pixel of the bitmap sent by COMMAND_G_PUTBMPMN
+	// x: g_short_parameters[0], y: g_short_parameters[1]
+	// m: g_short_parameters[2], n: g_short_parameters[3]
+	if (g_short_parameters[3]<=g_bmp_y) return;
+	if (data8) g_pset(g_short_parameters[0]+g_bmp_x,g_short_parameters[1]+g_bmp_y,data8);
+	if (g_short_parameters[2]<=++g_bmp_x) {
+		g_bmp_x=0;
+		g_bmp_y++;
+	}
+}
+
+void put_tvram_rect(unsigned char data8){
+	// Write a byte sent after the header of COMMAND_WRITE_TVRAM_RECT
+	// x: g_parameters[0], y: g_parameters[1], w: g_parameters[2], h: g_parameters[3]
+	unsigned int n,i,x,y;
+	n=g_parameters[2]*g_parameters[3];
+	if (n*2<=g_redraw_pos) return;
+	i=g_redraw_pos%n;
+	x=g_parameters[0]+i%g_parameters[2];
+	y=g_parameters[1]+i/g_parameters[2];
+	if (x<WIDTH_X && y<WIDTH_Y) *tvram_cell(y*WIDTH_X+x+(g_redraw_pos<n ? 0:ATTROFFSET))=data8;
+	g_redraw_pos++;
+}
+
+void put_rle_data(unsigned char data8){
+	// Decode a byte sent by COMMAND_TEXTREDRAW_RLE
+	if (0==g_rle_count) {
+		// Control byte
+		g_rle_run=(data8&0x80) ? true:false;
+		g_rle_count=(data8&0x7f)+(g_rle_run ? 2:1);
+		return;
+	}
+	do {
+		if (g_redraw_pos<ATTROFFSET*2) *tvram_cell(g_redraw_pos++)=data8;
+		g_rle_count--;
+	} while (g_rle_run && g_rle_count);
+}
+
+void put_stream_data(unsigned char* dest,unsigned int size,unsigned char data8){
+	// Write a byte sent after the address (g_short_parameters[0]) of
+	// COMMAND_SPRITE_PATTERN, COMMAND_TILE_PATTERN, etc.
+	unsigned short a=g_short_parameters[0]++;
+	if (a<size) dest[a]=data8;
+}
 
 void set_command(unsigned char data8){
 	// Read 8 bit data
 	g_command=data8;
-	// Busy line will be L
-	gpio_put(MISO_BUSY_PIN,0);
 	// Reset parameter position
 	g_parameter_pos=0;
-	// Wait until WR to H
-	while(!gpio_get(MOSI_WR_PIN));
+	// Wait for the blitter before touching the graphic pages or blit_pattern[]
+	if ((COMMAND_G_PSET<=data8 && data8<=COMMAND_G_FLIP) || COMMAND_READ_PIXEL==data8 || COMMAND_BLIT_PATTERN==data8) blit_wait();
 	// Do immediate command
 	switch(data8){
 		case COMMAND_CLS:
@@ -60,6 +280,33 @@ void set_command(unsigned char data8){
 		case COMMAND_TEXTREDRAW:
 			g_redraw_pos=0;
 			break;
+		case COMMAND_TEXTREDRAW_RLE:
+			g_redraw_pos=0;
+			g_rle_count=0;
+			break;
+		case COMMAND_G_CLEARSCREEN:
+			g_clearscreen();
+			break;
+		case COMMAND_SCROLL_UP:
+			vramscroll();
+			break;
+		case COMMAND_SCROLL_DOWN:
+			vramscrolldown();
+			break;
+		case COMMAND_G_FLIP:
+			flip_page();
+			break;
+		case COMMAND_SPRITE_RESET:
+			sprite_reset();
+			break;
+		case COMMAND_PCG_RESET:
+			pcg_reset();
+			break;
+		case COMMAND_RESET_STATUS:
+			g_queue_max=0;
+			g_queue_full=0;
+			reset_line_status();
+			break;
 		default:
 			if (data8<0x80) printchar(data8);
 			break;
@@ -70,10 +317,6 @@ void set_command(unsigned char data8){
 void set_data(unsigned char data8){
 	// Read 8 bit data
 	g_parameters[g_parameter_pos++]=data8;
-	// Busy line will be L
-	gpio_put(MISO_BUSY_PIN,0);
-	// Wait until WR to H
-	while(!gpio_get(MOSI_WR_PIN));
 	// Do command
 	switch(g_command){
 		//void printchar(unsigned char n);
@@ -94,7 +337,93 @@ void set_data(unsigned char data8){
 			}
 			break;
 		case COMMAND_TEXTREDRAW:
-			if (g_redraw_pos<ATTROFFSET*2) TVRAM[g_redraw_pos++]=data8;
+			if (g_redraw_pos<ATTROFFSET*2) *tvram_cell(g_redraw_pos++)=data8;
+			break;
+		case COMMAND_TEXTREDRAW_RLE:
+			put_rle_data(data8);
+			g_parameter_pos=0;
+			return;
+		case COMMAND_SET_PALETTE_RANGE:
+			if (6==g_parameter_pos) {
+				// b,r,g of a palette entry follow the header
+				if (0<g_short_parameters[0]) {
+					set_palette(g_parameters[2]++,g_parameters[3],g_parameters[4],g_parameters[5]);
+					g_short_parameters[0]--;
+				}
+				g_parameter_pos=3;
+				return;
+			}
+			break;
+		case COMMAND_WRITE_TVRAM_RECT:
+			if (4<g_parameter_pos) {
+				// Characters and colors follow the header
+				put_tvram_rect(data8);
+				g_parameter_pos=4;
+				return;
+			}
+			// Characters will follow
+			if (4==g_parameter_pos) g_redraw_pos=0;
+			break;
+		case COMMAND_G_PUTBMPMN:
+			if (8<g_parameter_pos) {
+				// Bitmap data follows the header
+				put_bmp_pixel(data8);
+				g_parameter_pos=8;
+				return;
+			}
+			break;
+		case COMMAND_G_PRINTSTR:
+			if (7<g_parameter_pos) {
+				// String follows the header
+				if (data8) {
+					g_putfont(g_short_parameters[0],g_short_parameters[1],g_parameters[6],g_short_parameters[2],data8);
+					g_short_parameters[0]+=8;
+				}
+				g_parameter_pos=7;
+				return;
+			}
+			break;
+		case COMMAND_SPRITE_PATTERN:
+			if (2<g_parameter_pos) {
+				// Pattern data follows the address
+				put_stream_data(sprite_pattern,SPRITE_PATTERN_SIZE,data8);
+				g_parameter_pos=2;
+				return;
+			}
+			break;
+		case COMMAND_TILE_PATTERN:
+			if (2<g_parameter_pos) {
+				// Pattern data follows the address
+				put_stream_data(tile_pattern,TILE_PATTERN_SIZE,data8);
+				g_parameter_pos=2;
+				return;
+			}
+			break;
+		case COMMAND_BLIT_PATTERN:
+			if (2<g_parameter_pos) {
+				// Pattern data follows the address
+				put_stream_data(blit_pattern,BLIT_PATTERN_SIZE,data8);
+				g_parameter_pos=2;
+				return;
+			}
+			break;
+		case COMMAND_TILE_MAP:
+			if (2<g_parameter_pos) {
+				// Map data follows the address
+				put_stream_data(tilemap,TILEMAP_SIZE,data8);
+				g_parameter_pos=2;
+				return;
+			}
+			break;
+		case COMMAND_LINE_SCROLL:
+			if (2<g_parameter_pos) {
+				// Offsets follow the line number
+				put_stream_data((unsigned char*)line_scroll,FRAME_HEIGHT*2,data8);
+				g_parameter_pos=2;
+				return;
+			}
+			// Convert line number to address in line_scroll[]
+			if (2==g_parameter_pos) g_short_parameters[0]*=2;
 			break;
 		default:
 			break;
@@ -103,8 +432,27 @@ void set_data(unsigned char data8){
 		case 1:
 			//void setcursorcolor(unsigned char c);
 			if (COMMAND_SETCURSORCOLOR==g_command) setcursorcolor(g_parameters[0]);
+			//void set_tilemode(unsigned char m);
+			if (COMMAND_TILE_MODE==g_command) set_tilemode(g_parameters[0]);
+			//void use_pcg(unsigned char m);
+			if (COMMAND_USE_PCG==g_command) use_pcg(g_parameters[0]);
+			//void read_status(unsigned char n);
+			if (COMMAND_READ_STATUS==g_command) read_status(g_parameters[0]);
+			//void set_drawpage(unsigned char p);
+			if (COMMAND_G_DRAWPAGE==g_command) set_drawpage(g_parameters[0]);
+			//void set_displaypage(unsigned char p);
+			if (COMMAND_G_DISPLAYPAGE==g_command) set_displaypage(g_parameters[0]);
+			//void set_palette_bank(unsigned char b);
+			if (COMMAND_G_PALETTE_BANK==g_command) set_palette_bank(g_parameters[0]);
 			break;
 		case 2:
+			//void windowscroll(int y1,int y2);
+			if (COMMAND_WINDOW_SCROLL==g_command) windowscroll(g_parameters[0],g_parameters[1]);
+			if (COMMAND_READ_TVRAM==g_command) {
+				pio_sm_clear_fifos(RECEIVE_PIO,g_read_sm);
+				if ((unsigned short)g_short_parameters[0]<ATTROFFSET*2) put_read_data(*tvram_cell((unsigned short)g_short_parameters[0]));
+				else put_read_data(0);
+			}
 			break;
 		case 3:
 			//void setcursor(unsigned char x,unsigned char y,unsigned char c);
@@ -115,10 +463,64 @@ void set_data(unsigned char data8){
 			if (COMMAND_PRINTNUM==g_command) printnum((unsigned int)g_int_parameters[0]);
 			//void set_palette(unsigned char c,unsigned char b,unsigned char r,unsigned char g);
 			if (COMMAND_SET_PALETTE==g_command) set_palette(g_parameters[0],g_parameters[1],g_parameters[2],g_parameters[3]);
+			//void set_tilescroll(short x,short y);
+			if (COMMAND_TILE_SCROLL==g_command) set_tilescroll(g_short_parameters[0],g_short_parameters[1]);
+			//unsigned int g_color(int x,int y);
+			if (COMMAND_READ_PIXEL==g_command) {
+				pio_sm_clear_fifos(RECEIVE_PIO,g_read_sm);
+				put_read_data(g_color(g_short_parameters[0],g_short_parameters[1]));
+			}
 			break;
 		case 5:
 			//void printnum2(unsigned int n,unsigned char e);
 			if (COMMAND_PRINTNUM2==g_command) printnum2((unsigned int)g_int_parameters[0],g_parameters[4]);
+			//void g_pset(int x, int y, int c);
+			if (COMMAND_G_PSET==g_command) g_pset(g_short_parameters[0],g_short_parameters[1],g_parameters[4]);
+			//void sprite_move(unsigned char n,short x,short y);
+			if (COMMAND_SPRITE_MOVE==g_command) sprite_move(g_parameters[4],g_short_parameters[0],g_short_parameters[1]);
+			break;
+		case 6:
+			//void sprite_define(unsigned char n,unsigned char w,unsigned char h,unsigned char key,unsigned short pattern);
+			if (COMMAND_SPRITE_DEFINE==g_command) sprite_define(g_parameters[2],g_parameters[3],g_parameters[4],g_parameters[5],(unsigned short)g_short_parameters[0]);
+			break;
+		case 7:
+			//void g_hline(int x1,int x2,int y,unsigned int c);
+			if (COMMAND_G_HLINE==g_command) g_hline(g_short_parameters[0],g_short_parameters[1],g_short_parameters[2],g_parameters[6]);
+			//void g_circle(int x0,int y0,unsigned int r,unsigned int c);
+			if (COMMAND_G_CIRCLE==g_command) g_circle(g_short_parameters[0],g_short_parameters[1],(unsigned short)g_short_parameters[2],g_parameters[6]);
+			//void g_circlefill(int x0,int y0,unsigned int r,unsigned int c);
+			if (COMMAND_G_CIRCLEFILL==g_command) g_circlefill(g_short_parameters[0],g_short_parameters[1],(unsigned short)g_short_parameters[2],g_parameters[6]);
+			break;
+		case 8:
+			// Clear m*n dots by g_boxfill() as m and n may exceed 127
+			if (COMMAND_G_CLRBMPMN==g_command && 0<g_short_parameters[2] && 0<g_short_parameters[3]) {
+				g_boxfill(g_short_parameters[0],g_short_parameters[1],
+					g_short_parameters[0]+g_short_parameters[2]-1,g_short_parameters[1]+g_short_parameters[3]-1,0);
+			}
+			// Bitmap data will follow
+			if (COMMAND_G_PUTBMPMN==g_command) g_bmp_x=g_bmp_y=0;
+			//void g_putfont(int x,int y,unsigned int c,int bc,unsigned char n);
+			if (COMMAND_G_PUTFONT==g_command) g_putfont(g_short_parameters[0],g_short_parameters[1],g_parameters[6],g_short_parameters[2],g_parameters[7]);
+			break;
+		case 9:
+			//void g_gline(int x1,int y1,int x2,int y2,unsigned int c);
+			if (COMMAND_G_GLINE==g_command) g_gline(g_short_parameters[0],g_short_parameters[1],g_short_parameters[2],g_short_parameters[3],g_parameters[8]);
+			//void g_boxfill(int x1,int y1,int x2,int y2,unsigned int c);
+			if (COMMAND_G_BOXFILL==g_command) g_boxfill(g_short_parameters[0],g_short_parameters[1],g_short_parameters[2],g_short_parameters[3],g_parameters[8]);
+			//void pcg_define(unsigned char n,const uint8_t* p);
+			if (COMMAND_PCG_DEFINE==g_command) pcg_define(g_parameters[0],&g_parameters[1]);
+			//void g_fill(int x1,int y1,int x2,int y2,unsigned int c);
+			if (COMMAND_G_FILL==g_command) g_fill(g_short_parameters[0],g_short_parameters[1],g_short_parameters[2],g_short_parameters[3],g_parameters[8]);
+			break;
+		case 10:
+			//void g_get(int x,int y,int w,int h,unsigned short a);
+			if (COMMAND_G_GET==g_command) g_get(g_short_parameters[0],g_short_parameters[1],g_short_parameters[2],g_short_parameters[3],(unsigned short)g_short_parameters[4]);
+			break;
+		case 12:
+			//void g_copy(int x1,int y1,int w,int h,int x2,int y2);
+			if (COMMAND_G_COPY==g_command) g_copy(g_short_parameters[0],g_short_parameters[1],g_short_parameters[2],g_short_parameters[3],g_short_parameters[4],g_short_parameters[5]);
+			//void g_blit(int x,int y,int w,int h,unsigned short a,int key);
+			if (COMMAND_G_BLIT==g_command) g_blit(g_short_parameters[0],g_short_parameters[1],g_short_parameters[2],g_short_parameters[3],(unsigned short)g_short_parameters[4],g_short_parameters[5]);
 			break;
 		default:
 			break;
@@ -126,28 +528,51 @@ void set_data(unsigned char data8){
 	// All done
 }
 
+/*
+	Execute a received word (data in bit 0-7, DC in bit 8).
+	Anything that supplies the words in the same order as PIO does
+	(e.g. a simulated bus) can drive the slave through this function.
+*/
+void interface_receive(unsigned short input_data){
+	if (input_data&MOSI_DC_MASK) set_command(input_data&IO_8_BIT_MASK);
+	else set_data(input_data&IO_8_BIT_MASK);
+}
+
 /*
 	The main loop follows.
+	Received data are read from the ring buffer and executed here.
+	This runs on core1 (see main.c), so the DMA IRQ of NTSC signal in core0
+	is never delayed by the commands. The ring buffer is written only by
+	DMA and read only by this loop, so no lock is needed.
 */
 void main_loop(void){
-	unsigned int input_data;
+	unsigned short input_data;
+	unsigned int wpos,n;
+	bool full=false;
 	while(true){
-		// Not busy now
-		gpio_put(MISO_BUSY_PIN,1);
-		while(true){
-			input_data=gpio_get_all();
-			switch(input_data&MOSI_WR_RD_MASK){
-				case 1<<MOSI_RD_PIN: // /RD=H, /WR=L
-					if (input_data&MOSI_DC_MASK) set_command(input_data&IO_8_BIT_MASK);
-					else set_data(input_data&IO_8_BIT_MASK);
-					break;
-				case 1<<MOSI_WR_PIN: // /RD=L, /WR=H
-					break;
-				default:
-					continue;
+		// Restart DMA if the previous transfer has finished
+		if (!dma_channel_is_busy(g_receive_dma)) {
+			wpos=((dma_channel_hw_addr(g_receive_dma)->write_addr-(unsigned int)g_receive_ring)>>1)&RECEIVE_RING_MASK;
+			n=(g_receive_ring_rpos-wpos-1)&RECEIVE_RING_MASK;
+			if (n) {
+				dma_channel_set_write_addr(g_receive_dma,&g_receive_ring[wpos],false);
+				dma_channel_set_trans_count(g_receive_dma,n,true);
+				full=false;
+			} else if (!full) {
+				// The ring buffer is full and the master is waiting
+				full=true;
+				g_queue_full++;
 			}
-			// All job(s) done. Not busy now
-			gpio_put(MISO_BUSY_PIN,1);
+		}
+		// Current writing position of DMA
+		wpos=((dma_channel_hw_addr(g_receive_dma)->write_addr-(unsigned int)g_receive_ring)>>1)&RECEIVE_RING_MASK;
+		g_queue_depth=(wpos-g_receive_ring_rpos)&RECEIVE_RING_MASK;
+		if (g_queue_max<g_queue_depth) g_queue_max=g_queue_depth;
+		// Execute all received data
+		while(g_receive_ring_rpos!=wpos){
+			input_data=g_receive_ring[g_receive_ring_rpos];
+			g_receive_ring_rpos=(g_receive_ring_rpos+1)&RECEIVE_RING_MASK;
+			interface_receive(input_data);
 		}
 	}
 }
@@ -157,16 +582,57 @@ void main_loop(void){
 */
 void interface_init(void){
 	int i;
+	pio_sm_config c;
 	// Input ports (all pull up)
 	gpio_init_mask(INTERFACE_IN_MASK);
 	gpio_set_dir_in_masked(INTERFACE_IN_MASK);
 	for (i=0;i<29;i++) {
 		if (INTERFACE_IN_MASK&(1<<i)) gpio_pull_up(i);
 	}
-	// Output ports (output H in the beginning)
-	gpio_init_mask(INTERFACE_OUT_MASK);
-	gpio_set_dir_out_masked(INTERFACE_OUT_MASK);
-	gpio_put_masked(INTERFACE_OUT_MASK,INTERFACE_OUT_MASK);
+	// Output port (/BUSY) is controlled by PIO (output H in the beginning)
+	g_receive_offset=pio_add_program(RECEIVE_PIO,&parallel_slave_program);
+	g_receive_sm=pio_claim_unused_sm(RECEIVE_PIO,true);
+	pio_gpio_init(RECEIVE_PIO,MISO_BUSY_PIN);
+	pio_sm_set_pins_with_mask(RECEIVE_PIO,g_receive_sm,INTERFACE_OUT_MASK,INTERFACE_OUT_MASK);
+	pio_sm_set_pindirs_with_mask(RECEIVE_PIO,g_receive_sm,INTERFACE_OUT_MASK,INTERFACE_OUT_MASK);
+	c=parallel_slave_program_get_default_config(g_receive_offset);
+	sm_config_set_in_pins(&c,0);
+	sm_config_set_sideset_pins(&c,MISO_BUSY_PIN);
+	sm_config_set_in_shift(&c,false,false,32);
+	sm_config_set_fifo_join(&c,PIO_FIFO_JOIN_RX);
+	pio_sm_init(RECEIVE_PIO,g_receive_sm,g_receive_offset,&c);
+	// DMA from RX FIFO to the ring buffer
+	g_receive_ring_rpos=0;
+	g_receive_dma=dma_claim_unused_channel(true);
+	dma_channel_config dc=dma_channel_get_default_config(g_receive_dma);
+	channel_config_set_transfer_data_size(&dc,DMA_SIZE_16);
+	channel_config_set_read_increment(&dc,false);
+	channel_config_set_write_increment(&dc,true);
+	channel_config_set_ring(&dc,true,RECEIVE_RING_BITS+1);
+	channel_config_set_dreq(&dc,pio_get_dreq(RECEIVE_PIO,g_receive_sm,false));
+	dma_channel_configure(
+		g_receive_dma,
+		&dc,
+		g_receive_ring,
+		&RECEIVE_PIO->rxf[g_receive_sm],
+		RECEIVE_RING_SIZE-1,
+		true
+	);
+	pio_sm_set_enabled(RECEIVE_PIO,g_receive_sm,true);
+	// Another state machine for reading from the slave
+	// Data lines are input mode (/BUSY is already output mode)
+	g_read_offset=pio_add_program(RECEIVE_PIO,&parallel_slave_read_program);
+	g_read_sm=pio_claim_unused_sm(RECEIVE_PIO,true);
+	for(i=0;i<8;i++) pio_gpio_init(RECEIVE_PIO,i);
+	pio_sm_set_pindirs_with_mask(RECEIVE_PIO,g_read_sm,0,IO_8_BIT_MASK);
+	c=parallel_slave_read_program_get_default_config(g_read_offset);
+	sm_config_set_out_pins(&c,0,8);
+	sm_config_set_in_pins(&c,0);
+	sm_config_set_sideset_pins(&c,MISO_BUSY_PIN);
+	sm_config_set_out_shift(&c,true,false,32);
+	sm_config_set_fifo_join(&c,PIO_FIFO_JOIN_TX);
+	pio_sm_init(RECEIVE_PIO,g_read_sm,g_read_offset,&c);
+	pio_sm_set_enabled(RECEIVE_PIO,g_read_sm,true);
 	// NOP command in the beginning
 	g_command=COMMAND_NOP;
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #include "rp2040_pwm_ntsc_textgraph.h"
 #include "text_graph_library.h"
 #include <stdlib.h>
+#include "pico/multicore.h"
 
 void demo(void)
 {
@@ -56,8 +57,12 @@ void interface_init(void);
 void main_loop(void);
 
 void main(void){
+    // Core0: NTSC signal generation (DMA IRQ)
     rp2040_pwm_ntsc_init();
     interface_init();
     //demo();
-    main_loop();
+    // Core1: receiving and executing commands
+    // Long drawing commands never delay the scanline IRQ in core0
+    multicore_launch_core1(main_loop);
+    while(true) asm("wfi");
 }
@@ -19,24 +19,42 @@ caused by using this program.
 // This signal generation program (using PWM and DMA) is the idea of @lovyan03.
 // https://github.com/lovyan03/
 
-//#pragma GCC optimize ("O3")
+#pragma GCC optimize ("O3")
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "pico/stdlib.h"
 #include "hardware/dma.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/structs/systick.h"
 #include "rp2040_pwm_ntsc_textgraph.h"
+#include "text_graph_library.h"
 
 // NTSC信号をPWM出力するピン
 #define PIN_OUTPUT 19
 
+// 映像区間の終了（垂直ブランキング開始）時に1ラインの間LOWになるピン
+// MachiKania側のDRAWCOUNTをNTSC信号に同期させる
+#define PIN_VSYNC 12
+
 // デバッグ用、割込み処理中HIGHになるピン
 //#define PIN_DEBUG_BUSY 15
 
 uint8_t TVRAM[ATTROFFSET*2+1];
-uint8_t framebuffer[FRAME_WIDTH * FRAME_HEIGHT] __attribute__ ((aligned (4)));
+// 画面先頭行のTVRAM内の位置（WIDTH_Xの倍数）
+// TVRAMは行単位のリングバッファとして扱い、スクロールはこの値の変更で行う
+volatile uint16_t tvram_origin=0;
+uint8_t framebuffer[GRAPHIC_PAGE_SIZE * GRAPHIC_PAGES] __attribute__ ((aligned (4)));
+
+// グラフィックのページ
+// gvram:描画ページ、dispvram:表示中のページ
+// dispvram_nextは垂直ブランキング開始時にdispvramに反映される
+uint8_t* gvram=framebuffer;
+static uint8_t* volatile dispvram=framebuffer;
+static uint8_t* volatile dispvram_next=framebuffer;
 
 volatile uint8_t drawing; //　映像区間処理中は-1、その他は0
 volatile uint16_t drawcount=0; //　1画面表示終了ごとに1足す。アプリ側で0にする。
@@ -47,12 +65,139 @@ uint16_t dma_buffer[2][(NUM_LINE_SAMPLES+3)&~3u] __attribute__ ((aligned (4)));
 // カラーパレット
 uint16_t color_tbl[4*256] __attribute__ ((aligned (4)));
 
+// 表示用フォント（RAM上にコピーしてフラッシュからの読み出しを避ける）
+uint8_t fontram[8*256] __attribute__ ((aligned (4)));
+// PCG（RAMフォント）、初期状態はfontramと同じ
+uint8_t pcgram[8*256] __attribute__ ((aligned (4)));
+// 使用中のフォント（fontram or pcgram）、フレームの先頭で表示に反映される
+uint8_t* volatile fontp=fontram;
+
+// スプライト
+// sprites_nextへの変更は垂直ブランキング開始時にspritesに反映される
+struct sprite {
+	int16_t x,y; // 表示位置
+	uint8_t w,h; // 横、縦ドット数（0の場合非表示）
+	uint8_t key; // 透明色
+	uint16_t pattern; // sprite_pattern[]内のパターン位置
+};
+uint8_t sprite_pattern[SPRITE_PATTERN_SIZE] __attribute__ ((aligned (4)));
+static struct sprite sprites[SPRITE_NUM];
+static struct sprite sprites_next[SPRITE_NUM];
+
+// タイル（背景面）
+// タイルモードではグラフィック面の代わりにタイルマップを表示する
+// tilemap[]の各バイトがtile_pattern[]内のタイル番号（1タイル64バイト）
+// 表示位置は(tile_scroll_x+line_scroll[y],tile_scroll_y)
+// *_nextへの変更は垂直ブランキング開始時に反映される
+uint8_t tile_pattern[TILE_PATTERN_SIZE] __attribute__ ((aligned (4)));
+uint8_t tilemap[TILEMAP_SIZE];
+int16_t line_scroll[FRAME_HEIGHT];
+static uint8_t tile_line[FRAME_WIDTH+8] __attribute__ ((aligned (4)));
+static uint8_t tile_mode,tile_mode_next;
+static int16_t tile_scroll_x,tile_scroll_y,tile_scroll_x_next,tile_scroll_y_next;
+
+#if GRAPHIC_BPP==4
+// 4ビットモードのパレットバンク（0-15）
+// palette_4bppは1バイト（2ドット）を2つのパレット番号に変換するテーブル
+// palette_bank_nextへの変更は垂直ブランキング開始時に反映される
+static uint16_t palette_4bpp[256];
+static uint8_t palette_bank,palette_bank_next;
+#endif
+
+// ブリッタ（DMAによる矩形の転送と塗りつぶし）
+// blit_ctrl_chanがblit_blocks[]から1行分の転送元と転送先をblit_data_chanに書き込んで起動する
+// 全行の転送が終わるまでCPUを使わずに動作し、転送元0,転送先0のブロックで停止する
+uint8_t blit_pattern[BLIT_PATTERN_SIZE] __attribute__ ((aligned (4)));
+static const void* blit_blocks[(FRAME_HEIGHT+1)*2] __attribute__ ((aligned (8)));
+static const void** volatile blit_end=blit_blocks;
+static uint32_t blit_color;
+static uint blit_data_chan,blit_ctrl_chan;
+
+// 1ラインあたりのmakeDmaBuffer()処理時間（CPUサイクル数）
+// max:最大値、avg:直前のフレームの平均値、overrun:1ライン時間を超えた回数
+volatile uint32_t line_cycles_max;
+volatile uint32_t line_cycles_avg;
+volatile uint32_t line_overrun;
+
 static uint pwm_dma_chan0,pwm_dma_chan1;
 
-static void makeDmaBuffer(uint16_t* buf, size_t line_num)
+// タイルマップからyライン目のグラフィックデータをtile_line[]に作成
+static uint32_t* __not_in_flash_func(make_tile_line)(int y)
+{
+	int ty=(y+tile_scroll_y)&(TILEMAP_HEIGHT*8-1);
+	int tx=(tile_scroll_x+line_scroll[y])&(TILEMAP_WIDTH*8-1);
+	uint8_t* mp=tilemap+(ty>>3)*TILEMAP_WIDTH;
+	uint8_t* pp=tile_pattern+(ty&7)*8;
+	uint8_t* d=tile_line;
+	uint8_t* s;
+	int mx=tx>>3;
+
+	// 最初のタイル（途中から）
+	s=pp+mp[mx]*64;
+	for(int j=tx&7;j<8;j++) *d++=s[j];
+	if ((tx&3)==0)
+	{
+		// 書き込み先が4バイト境界なので32ビット単位でコピー
+		uint32_t* d32=(uint32_t*)d;
+		while(d32<(uint32_t*)(tile_line+FRAME_WIDTH))
+		{
+			mx=(mx+1)&(TILEMAP_WIDTH-1);
+			uint32_t* s32=(uint32_t*)(pp+mp[mx]*64);
+			d32[0]=s32[0];
+			d32[1]=s32[1];
+			d32+=2;
+		}
+	}
+	else
+	{
+		while(d<tile_line+FRAME_WIDTH)
+		{
+			mx=(mx+1)&(TILEMAP_WIDTH-1);
+			s=pp+mp[mx]*64;
+			d[0]=s[0];
+			d[1]=s[1];
+			d[2]=s[2];
+			d[3]=s[3];
+			d[4]=s[4];
+			d[5]=s[5];
+			d[6]=s[6];
+			d[7]=s[7];
+			d+=8;
+		}
+	}
+	return (uint32_t*)tile_line;
+}
+
+#if GRAPHIC_BPP==4
+// パレットバンクにしたがってpalette_4bpp[]を作成
+static void __not_in_flash_func(make_palette_4bpp)(void)
+{
+	for(int i=0;i<256;i++)
+	{
+		palette_4bpp[i]=(palette_bank*16+(i&15)) | ((palette_bank*16+(i>>4))<<8);
+	}
+}
+
+// 4ビット/ドットのグラフィックデータ1ライン分を1ドット1バイトに展開してtile_line[]に作成
+// 16ビット（4ドット）単位で読み出して32ビット単位で書き込む
+static uint32_t* __not_in_flash_func(make_4bpp_line)(const uint8_t* src)
+{
+	const uint16_t* s16=(const uint16_t*)src;
+	uint32_t* d32=(uint32_t*)tile_line;
+	for(int i=0;i<FRAME_WIDTH/4;i++)
+	{
+		uint16_t s=s16[i];
+		d32[i]=palette_4bpp[s&0xff] | (palette_4bpp[s>>8]<<16);
+	}
+	return (uint32_t*)tile_line;
+}
+#endif
+
+static void __not_in_flash_func(makeDmaBuffer)(uint16_t* buf, size_t line_num)
 {
 	static uint8_t* fbp = framebuffer;
 	static uint8_t* tvp = TVRAM;
+	static uint8_t* font = fontram;
 	static uint8_t tline = 0;
 	uint16_t* b = buf;
 
@@ -76,52 +221,110 @@ static void makeDmaBuffer(uint16_t* buf, size_t line_num)
 	}
 	else if(line_num>=V_SYNC+V_PREEQ && line_num<V_SYNC+V_PREEQ+FRAME_HEIGHT)
 	{
-		b+=H_PICTURE;
+		// 1ドットあたり2サンプルを32ビット単位で書き込む
+		// 偶数ドットはパレットの0,1番目、奇数ドットは2,3番目のサンプルを使う
+		uint32_t* b32=(uint32_t*)(b+H_PICTURE);
+		uint32_t* line32=b32;
+		uint32_t* clt=(uint32_t*)color_tbl;
+		uint32_t* fbp32;
+		int y=line_num-(V_SYNC+V_PREEQ);
 		if (line_num == V_SYNC + V_PREEQ)
 		{
-			fbp = framebuffer;
-			tvp = TVRAM;
+			fbp = dispvram;
+			tvp = TVRAM + tvram_origin;
+			font = fontp;
 			tline = 0;
 			drawing = -1;
 		}
+		if(tile_mode) fbp32=make_tile_line(y);
+#if GRAPHIC_BPP==4
+		else fbp32=make_4bpp_line(fbp);
+#else
+		else fbp32=(uint32_t*)fbp;
+#endif
+		uint8_t* fline=font+tline;
 		for(int i=0;i<WIDTH_X;i++)
 		{
-			uint8_t d=FontData[*tvp *8 +tline];
-			uint16_t* clp=color_tbl+(*(tvp+ATTROFFSET))*4;
-			uint32_t c1=*((uint32_t*)clp);
-			uint32_t c2=*((uint32_t*)(clp+2));
-			for(int j=0;j<4;j++)
+			uint8_t d=fline[*tvp *8];
+			uint32_t g0=fbp32[0];
+			uint32_t g1=fbp32[1];
+			if(d==0)
 			{
-			uint16_t t=*(uint16_t*)fbp;
-			if(d & 0x80){
-				*((uint32_t*)b)=c1;
-			}
-			else{
-				*((uint32_t*)b)=*((uint32_t*)(color_tbl+(t & 0xff)*4));
-			}
-			b+=2;
-			if(d & 0x40){
-				*((uint32_t*)b)=c2;
+				// テキストのドットなし、グラフィックのみ
+				b32[0]=clt[(g0 & 0xff)*2];
+				b32[1]=clt[((g0>>8) & 0xff)*2+1];
+				b32[2]=clt[((g0>>16) & 0xff)*2];
+				b32[3]=clt[(g0>>24)*2+1];
+				b32[4]=clt[(g1 & 0xff)*2];
+				b32[5]=clt[((g1>>8) & 0xff)*2+1];
+				b32[6]=clt[((g1>>16) & 0xff)*2];
+				b32[7]=clt[(g1>>24)*2+1];
 			}
-			else{
-				*((uint32_t*)b)=*((uint32_t*)(color_tbl+(t >> 8)*4+2));
-			}
-			b+=2;
-			fbp+=2;
-			d<<=2;
+			else
+			{
+				uint32_t* clp=clt+(*(tvp+ATTROFFSET))*2;
+				uint32_t c1=clp[0];
+				uint32_t c2=clp[1];
+				b32[0]=(d & 0x80) ? c1 : clt[(g0 & 0xff)*2];
+				b32[1]=(d & 0x40) ? c2 : clt[((g0>>8) & 0xff)*2+1];
+				b32[2]=(d & 0x20) ? c1 : clt[((g0>>16) & 0xff)*2];
+				b32[3]=(d & 0x10) ? c2 : clt[(g0>>24)*2+1];
+				b32[4]=(d & 0x08) ? c1 : clt[(g1 & 0xff)*2];
+				b32[5]=(d & 0x04) ? c2 : clt[((g1>>8) & 0xff)*2+1];
+				b32[6]=(d & 0x02) ? c1 : clt[((g1>>16) & 0xff)*2];
+				b32[7]=(d & 0x01) ? c2 : clt[(g1>>24)*2+1];
 			}
+			b32+=8;
+			fbp32+=2;
 			tvp++;
 		}
+		fbp+=GRAPHIC_LINE_SIZE;
 		tline++;
 		if(tline<8) tvp-=WIDTH_X;
-		else tline=0;
+		else
+		{
+			tline=0;
+			if(tvp==TVRAM+ATTROFFSET) tvp=TVRAM; // リングバッファの先頭に戻る
+		}
+		// スプライトを重ねる（番号の小さいものが手前）
+		for(int i=SPRITE_NUM-1;0<=i;i--)
+		{
+			struct sprite* s=&sprites[i];
+			unsigned int sy=y-s->y;
+			if(s->h<=sy) continue;
+			uint8_t* pp=sprite_pattern+s->pattern+sy*s->w;
+			int x=s->x;
+			for(int j=0;j<s->w;j++,x++)
+			{
+				uint8_t p=pp[j];
+				if(p==s->key || FRAME_WIDTH<=(unsigned int)x) continue;
+				line32[x]=clt[p*2+(x&1)];
+			}
+		}
 	}
 	else if(line_num==V_SYNC+V_PREEQ+FRAME_HEIGHT || line_num==V_SYNC+V_PREEQ+FRAME_HEIGHT+1)
 	{
 		if(line_num==V_SYNC+V_PREEQ+FRAME_HEIGHT){
+			gpio_put(PIN_VSYNC, 0);
 			drawing=0;
 			drawcount++;
+			// ページの切り替えはここでのみ行う（表示途中で切り替わらないように）
+			dispvram=dispvram_next;
+			for(int i=0;i<SPRITE_NUM;i++) sprites[i]=sprites_next[i];
+			tile_mode=tile_mode_next;
+			tile_scroll_x=tile_scroll_x_next;
+			tile_scroll_y=tile_scroll_y_next;
+#if GRAPHIC_BPP==4
+			if(palette_bank!=palette_bank_next)
+			{
+				palette_bank=palette_bank_next;
+				make_palette_4bpp();
+			}
+#endif
+			// コア1で垂直ブランキングを待っている処理（flip_page()）を起こす
+			__sev();
 		}
+		else gpio_put(PIN_VSYNC, 1);
 		b+=H_PICTURE;
 		for(int i=0;i<FRAME_WIDTH*2;i++) *b++ = 2;
 	}
@@ -176,14 +379,17 @@ static void init_palette(void){
 	}
 }
 
-static void irq_handler(void) {
+static void __not_in_flash_func(irq_handler)(void) {
 	static bool flip = true;
 	static size_t scanline = 0;
+	static uint32_t cycles_sum = 0;
 	volatile uint32_t s0;
+	uint32_t t;
 
 #if defined ( PIN_DEBUG_BUSY )
 	gpio_put(PIN_DEBUG_BUSY, 1);
 #endif
+	t=systick_hw->cvr;
 	s0=dma_hw->ints0;
 	dma_hw->ints0 = s0;
 	if(s0 & (1u << pwm_dma_chan1)){
@@ -194,21 +400,322 @@ static void irq_handler(void) {
 		makeDmaBuffer(dma_buffer[0], scanline);
 		dma_channel_set_read_addr(pwm_dma_chan0, dma_buffer[0], false);
 	}
+	// 処理時間計測（SysTickはダウンカウンタ）
+	t=(t-systick_hw->cvr)&0xffffff;
+	if (line_cycles_max<t) line_cycles_max=t;
+	if (LINE_CYCLES<t) line_overrun++;
+	cycles_sum+=t;
 	if (++scanline >= NUM_LINES) {
 		scanline = 0;
+		line_cycles_avg=cycles_sum/NUM_LINES;
+		cycles_sum=0;
 	}
 #if defined ( PIN_DEBUG_BUSY )
 	gpio_put(PIN_DEBUG_BUSY, 0);
 #endif
 }
 
+// 処理時間計測値のリセット
+void reset_line_status(void)
+{
+	line_cycles_max=0;
+	line_overrun=0;
+}
+
+// 描画ページの設定（0 or 1）
+void set_drawpage(unsigned char p)
+{
+	if (GRAPHIC_PAGES<=p) return;
+	gvram=framebuffer+GRAPHIC_PAGE_SIZE*p;
+}
+
+// 表示ページの設定（0 or 1）
+// 実際の切り替えは次の垂直ブランキング開始時
+void set_displaypage(unsigned char p)
+{
+	if (GRAPHIC_PAGES<=p) return;
+	dispvram_next=framebuffer+GRAPHIC_PAGE_SIZE*p;
+}
+
+// 描画ページを表示ページにし、もう一方のページを描画ページにする
+// 切り替えが完了する（次の垂直ブランキング開始）まで待つ
+void flip_page(void)
+{
+	uint8_t* p=gvram;
+	dispvram_next=p;
+	if (p==framebuffer) gvram=framebuffer+GRAPHIC_PAGE_SIZE;
+	else gvram=framebuffer;
+	// コマンド処理はコア1で割り込みがないので、wfeでコア0からの__sev()を待つ
+	while(dispvram!=p) __wfe();
+}
+
+// 4ビットモードのパレットバンク設定（0-15）
+// グラフィックのドットの値nはパレット番号b*16+nで表示される
+// 表示への反映は次の垂直ブランキング開始時、8ビットモードでは何もしない
+void set_palette_bank(unsigned char b)
+{
+#if GRAPHIC_BPP==4
+	palette_bank_next=b&15;
+#endif
+}
+
+// PCG（RAMフォント）の使用開始（m=1）、停止（m=0）
+// 表示への反映は次のフレームの先頭
+void use_pcg(unsigned char m)
+{
+	fontp = m ? pcgram : fontram;
+}
+
+// PCGの文字コードnのフォントを設定（8バイト）
+void pcg_define(unsigned char n,const uint8_t* p)
+{
+	for(int i=0;i<8;i++) pcgram[n*8+i]=p[i];
+}
+
+// PCGをシステムフォントで初期化
+void pcg_reset(void)
+{
+	for(int i=0;i<8*256;i++) pcgram[i]=fontram[i];
+}
+
+// スプライトnの設定
+// w,h:横、縦ドット数（0で非表示）、key:透明色、pattern:sprite_pattern[]内のパターン位置
+// 表示への反映は次の垂直ブランキング開始時
+void sprite_define(unsigned char n,unsigned char w,unsigned char h,unsigned char key,unsigned short pattern)
+{
+	if (SPRITE_NUM<=n) return;
+	if (SPRITE_MAX_SIZE<w || SPRITE_MAX_SIZE<h || SPRITE_PATTERN_SIZE<pattern+w*h) w=h=0;
+	sprites_next[n].w=w;
+	sprites_next[n].h=h;
+	sprites_next[n].key=key;
+	sprites_next[n].pattern=pattern;
+}
+
+// スプライトnを座標(x,y)に移動
+// 表示への反映は次の垂直ブランキング開始時
+void sprite_move(unsigned char n,short x,short y)
+{
+	if (SPRITE_NUM<=n) return;
+	sprites_next[n].x=x;
+	sprites_next[n].y=y;
+}
+
+// 全スプライトを非表示にする
+void sprite_reset(void)
+{
+	for(int i=0;i<SPRITE_NUM;i++)
+	{
+		sprites_next[i].w=0;
+		sprites_next[i].h=0;
+	}
+}
+
+// タイルモードの設定
+// m=0:グラフィック面を表示（スクロール位置とline_scroll[]もクリア）、m=1:タイルマップを表示
+// 表示への反映は次の垂直ブランキング開始時
+void set_tilemode(unsigned char m)
+{
+	tile_mode_next=m ? 1:0;
+	if (m) return;
+	tile_scroll_x_next=tile_scroll_y_next=0;
+	for(int i=0;i<FRAME_HEIGHT;i++) line_scroll[i]=0;
+}
+
+// タイルマップのスクロール位置設定
+// 表示への反映は次の垂直ブランキング開始時
+void set_tilescroll(short x,short y)
+{
+	tile_scroll_x_next=x;
+	tile_scroll_y_next=y;
+}
+
+// ブリッタの転送終了を待つ
+// グラフィック画面またはblit_pattern[]を書き換える前に呼ぶ
+void blit_wait(void)
+{
+	while(dma_channel_hw_addr(blit_ctrl_chan)->read_addr!=(uint32_t)blit_end ||
+		dma_channel_is_busy(blit_ctrl_chan) || dma_channel_is_busy(blit_data_chan)) tight_loop_contents();
+}
+
+// 横wバイト、縦h行の転送をブリッタで開始（終了は待たない）
+// 転送元の行間隔src_strideが0の場合はblit_colorで塗りつぶす
+static void blit_start(uint8_t* dst,int dst_stride,const uint8_t* src,int src_stride,int w,int h)
+{
+	int i,r;
+	// 転送先が後ろにある場合は重なりを考慮して最後の行から転送する
+	bool rev=src_stride && src<dst;
+	bool w32;
+	if (!src_stride) src=(const uint8_t*)&blit_color;
+	w32=0==(((uint32_t)dst|dst_stride|(uint32_t)src|src_stride|w)&3);
+	for(i=0;i<h;i++)
+	{
+		r=rev ? h-1-i : i;
+		blit_blocks[i*2]=src+r*src_stride;
+		blit_blocks[i*2+1]=dst+r*dst_stride;
+	}
+	blit_blocks[h*2]=0;
+	blit_blocks[h*2+1]=0;
+	blit_end=&blit_blocks[h*2+2];
+	dma_channel_config c=dma_channel_get_default_config(blit_data_chan);
+	channel_config_set_transfer_data_size(&c, w32 ? DMA_SIZE_32 : DMA_SIZE_8);
+	channel_config_set_read_increment(&c, src_stride!=0);
+	channel_config_set_write_increment(&c, true);
+	channel_config_set_chain_to(&c, blit_ctrl_chan);
+	dma_channel_set_config(blit_data_chan, &c, false);
+	dma_channel_set_trans_count(blit_data_chan, w32 ? w/4 : w, false);
+	dma_channel_set_read_addr(blit_ctrl_chan, blit_blocks, true);
+}
+
+// 座標(x1,y1)から横w,縦hドットの範囲を座標(x2,y2)にコピー（範囲は重なってもよい）
+void g_copy(int x1,int y1,int w,int h,int x2,int y2)
+{
+	blit_wait();
+	if(x1<0){ w+=x1; x2-=x1; x1=0; }
+	if(y1<0){ h+=y1; y2-=y1; y1=0; }
+	if(x2<0){ w+=x2; x1-=x2; x2=0; }
+	if(y2<0){ h+=y2; y1-=y2; y2=0; }
+	if(X_RES<x1+w) w=X_RES-x1;
+	if(X_RES<x2+w) w=X_RES-x2;
+	if(Y_RES<y1+h) h=Y_RES-y1;
+	if(Y_RES<y2+h) h=Y_RES-y2;
+	if(w<=0 || h<=0) return;
+#if GRAPHIC_BPP==4
+	if((x1|x2|w)&1)
+	{
+		// 4ビットモードで半バイト単位の転送になる場合はCPUで1ドットずつコピー
+		bool rev=y1<y2 || (y1==y2 && x1<x2);
+		for(int i=0;i<h;i++)
+		{
+			int r=rev ? h-1-i : i;
+			for(int j=0;j<w;j++)
+			{
+				int k=rev ? w-1-j : j;
+				g_pset(x2+k,y2+r,g_color(x1+k,y1+r));
+			}
+		}
+		return;
+	}
+	// 以下はバイト単位
+	x1>>=1;
+	x2>>=1;
+	w>>=1;
+#endif
+	uint8_t* src=GVRAM+y1*GRAPHIC_LINE_SIZE+x1;
+	uint8_t* dst=GVRAM+y2*GRAPHIC_LINE_SIZE+x2;
+	if(y1==y2 && x1<x2 && x2<x1+w)
+	{
+		// 同じ行で右に重なる場合は前からの転送ができないのでCPUで行う
+		for(int i=0;i<h;i++) memmove(dst+i*GRAPHIC_LINE_SIZE,src+i*GRAPHIC_LINE_SIZE,w);
+		return;
+	}
+	blit_start(dst,GRAPHIC_LINE_SIZE,src,GRAPHIC_LINE_SIZE,w,h);
+}
+
+// (x1,y1),(x2,y2)を対角線とする長方形をカラーcでブリッタにより塗りつぶす
+void g_fill(int x1,int y1,int x2,int y2,unsigned int c)
+{
+	int temp;
+	blit_wait();
+	if(x1>x2){ temp=x1; x1=x2; x2=temp; }
+	if(y1>y2){ temp=y1; y1=y2; y2=temp; }
+	if(x2<0 || x1>=X_RES || y2<0 || y1>=Y_RES) return;
+	if(x1<0) x1=0;
+	if(y1<0) y1=0;
+	if(x2>=X_RES) x2=X_RES-1;
+	if(y2>=Y_RES) y2=Y_RES-1;
+#if GRAPHIC_BPP==4
+	// 半端な両端の列を書いてから、残りを1バイト2ドットで塗る
+	c&=15;
+	if(x1&1)
+	{
+		for(temp=y1;temp<=y2;temp++) g_pset(x1,temp,c);
+		x1++;
+	}
+	if(!(x2&1))
+	{
+		for(temp=y1;temp<=y2;temp++) g_pset(x2,temp,c);
+		x2--;
+	}
+	if(x2<x1) return;
+	x1>>=1;
+	x2>>=1;
+	c*=0x11;
+#else
+	c&=0xff;
+#endif
+	blit_color=c|(c<<8)|(c<<16)|(c<<24);
+	blit_start(GVRAM+y1*GRAPHIC_LINE_SIZE+x1,GRAPHIC_LINE_SIZE,0,0,x2-x1+1,y2-y1+1);
+}
+
+// blit_pattern[a]からの横w,縦hドットのパターンを座標(x,y)に描画
+// key:透明色（負数の場合は透明色なしでブリッタにより転送）
+void g_blit(int x,int y,int w,int h,unsigned short a,int key)
+{
+	int ox,oy,cw,ch;
+	blit_wait();
+	if(w<=0 || h<=0 || BLIT_PATTERN_SIZE<a+w*h) return;
+	ox=x<0 ? -x:0;
+	oy=y<0 ? -y:0;
+	cw=(X_RES<x+w ? X_RES-x:w)-ox;
+	ch=(Y_RES<y+h ? Y_RES-y:h)-oy;
+	if(cw<=0 || ch<=0) return;
+	const uint8_t* src=blit_pattern+a+oy*w+ox;
+#if GRAPHIC_BPP==4
+	// 4ビットモードではパターン（1ドット1バイト）の変換が必要なのでCPUで行う
+	for(int i=0;i<ch;i++,src+=w)
+	{
+		for(int j=0;j<cw;j++) if(key<0 || src[j]!=key) g_pset(x+ox+j,y+oy+i,src[j]);
+	}
+	return;
+#endif
+	uint8_t* dst=GVRAM+(y+oy)*X_RES+x+ox;
+	if(key<0)
+	{
+		blit_start(dst,X_RES,src,w,cw,ch);
+		return;
+	}
+	// DMAでは透明色の判定ができないのでCPUで行う
+	for(int i=0;i<ch;i++,src+=w,dst+=X_RES)
+	{
+		for(int j=0;j<cw;j++) if(src[j]!=key) dst[j]=src[j];
+	}
+}
+
+// 座標(x,y)から横w,縦hドットの範囲をblit_pattern[a]以降にブリッタで取り込む
+void g_get(int x,int y,int w,int h,unsigned short a)
+{
+	int ox,oy,cw,ch;
+	blit_wait();
+	if(w<=0 || h<=0 || BLIT_PATTERN_SIZE<a+w*h) return;
+	ox=x<0 ? -x:0;
+	oy=y<0 ? -y:0;
+	cw=(X_RES<x+w ? X_RES-x:w)-ox;
+	ch=(Y_RES<y+h ? Y_RES-y:h)-oy;
+	if(cw<=0 || ch<=0) return;
+#if GRAPHIC_BPP==4
+	// 4ビットモードではパターン（1ドット1バイト）への変換が必要なのでCPUで行う
+	for(int i=0;i<ch;i++)
+	{
+		for(int j=0;j<cw;j++) blit_pattern[a+(oy+i)*w+ox+j]=g_color(x+ox+j,y+oy+i);
+	}
+	return;
+#endif
+	blit_start(blit_pattern+a+oy*w+ox,w,GVRAM+(y+oy)*X_RES+x+ox,X_RES,cw,ch);
+}
+
 // グラフィック画面クリア
 void g_clearscreen(void)
 {
 	unsigned int *vp;
 	int i;
 	vp=(unsigned int *)GVRAM;
-	for(i=0;i<X_RES*Y_RES/4;i++) *vp++=0;
+	for(i=0;i<GRAPHIC_PAGE_SIZE/16;i++){
+		vp[0]=0;
+		vp[1]=0;
+		vp[2]=0;
+		vp[3]=0;
+		vp+=4;
+	}
 }
 //テキスト画面クリア
 void clearscreen(void)
@@ -217,6 +724,7 @@ void clearscreen(void)
 	int i;
 	vp=(unsigned int *)TVRAM;
 	for(i=0;i<WIDTH_X*WIDTH_Y*2/4;i++) *vp++=0;
+	tvram_origin=0;
 }
 
 void rp2040_pwm_ntsc_init(void)
@@ -225,9 +733,22 @@ void rp2040_pwm_ntsc_init(void)
 	gpio_init(PIN_DEBUG_BUSY);
 	gpio_set_dir(PIN_DEBUG_BUSY, GPIO_OUT);
 #endif
+	gpio_init(PIN_VSYNC);
+	gpio_put(PIN_VSYNC, 1);
+	gpio_set_dir(PIN_VSYNC, GPIO_OUT);
 	init_palette();
+#if GRAPHIC_BPP==4
+	make_palette_4bpp();
+#endif
 	g_clearscreen();
 	clearscreen();
+	for(int i=0;i<8*256;i++) fontram[i]=FontData[i];
+	pcg_reset();
+
+	// 処理時間計測用にSysTickをCPUクロックで動作させる
+	systick_hw->rvr=0xffffff;
+	systick_hw->cvr=0;
+	systick_hw->csr=0x5;
 
 	// CPUを157.5MHzで動作させる
 	uint32_t freq_khz = 157500;
@@ -255,6 +776,24 @@ void rp2040_pwm_ntsc_init(void)
 	pwm_dma_chan0 = dma_claim_unused_channel(true);
 	pwm_dma_chan1 = dma_claim_unused_channel(true);
 
+	// ブリッタ用DMA
+	// blit_ctrl_chanはblit_data_chanのREAD_ADDRとWRITE_ADDR_TRIGに書き込む（8バイトのリング）
+	blit_data_chan = dma_claim_unused_channel(true);
+	blit_ctrl_chan = dma_claim_unused_channel(true);
+	dma_channel_config bc = dma_channel_get_default_config(blit_ctrl_chan);
+	channel_config_set_transfer_data_size(&bc, DMA_SIZE_32);
+	channel_config_set_read_increment(&bc, true);
+	channel_config_set_write_increment(&bc, true);
+	channel_config_set_ring(&bc, true, 3);
+	dma_channel_configure(
+		blit_ctrl_chan,
+		&bc,
+		&dma_channel_hw_addr(blit_data_chan)->al2_read_addr,
+		blit_blocks,
+		2,
+		false
+	);
+
 	dma_channel_config c = dma_channel_get_default_config(pwm_dma_chan0);
 	channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
 	channel_config_set_read_increment(&c, true);
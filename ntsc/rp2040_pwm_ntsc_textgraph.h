@@ -7,7 +7,32 @@
 #define ATTROFFSET (WIDTH_X*WIDTH_Y)
 #define X_RES FRAME_WIDTH
 #define Y_RES FRAME_HEIGHT
-#define GVRAM framebuffer
+#define GVRAM gvram
+#define GRAPHIC_PAGES 2
+
+// グラフィックの1ドットあたりのビット数（8 or 4）
+// 4の場合はフレームバッファが半分になり、グラフィックは16色
+// （表示されるパレット番号はパレットバンク*16+ドットの値）
+#ifndef GRAPHIC_BPP
+#define GRAPHIC_BPP 8
+#endif
+#define GRAPHIC_LINE_SIZE (FRAME_WIDTH*GRAPHIC_BPP/8) // グラフィック1ラインのバイト数
+#define GRAPHIC_PAGE_SIZE (GRAPHIC_LINE_SIZE*FRAME_HEIGHT) // グラフィック1ページのバイト数
+
+// スプライト
+#define SPRITE_NUM 32 // スプライト数
+#define SPRITE_MAX_SIZE 16 // 最大サイズ（縦横ドット数）
+#define SPRITE_PATTERN_SIZE (SPRITE_NUM*SPRITE_MAX_SIZE*SPRITE_MAX_SIZE) // パターンRAMのサイズ
+
+// タイル（背景面）
+#define TILE_NUM 256 // タイル数（8x8ドット）
+#define TILE_PATTERN_SIZE (TILE_NUM*64) // タイルパターンRAMのサイズ
+#define TILEMAP_WIDTH 64 // タイルマップの横タイル数（2のべき乗）
+#define TILEMAP_HEIGHT 32 // タイルマップの縦タイル数（2のべき乗）
+#define TILEMAP_SIZE (TILEMAP_WIDTH*TILEMAP_HEIGHT)
+
+// ブリッタ
+#define BLIT_PATTERN_SIZE 16384 // ブリッタ用パターンRAMのサイズ
 
 // NTSC出力 1ラインあたりのサンプル数
 #define NUM_LINE_SAMPLES 908  // 227 * 4
@@ -18,13 +43,45 @@
 #define V_PREEQ		26	// ブランキング区間上側
 #define H_SYNC		68	// 水平同期幅、約4.7μsec
 #define H_PICTURE (H_SYNC+8+9*4+60) // 映像開始位置
+#define LINE_CYCLES (NUM_LINE_SAMPLES*11) // 1ラインのCPUサイクル数
 
 void g_clearscreen(void);
 void clearscreen(void);
 void rp2040_pwm_ntsc_init(void);
 void set_palette(unsigned char c,unsigned char b,unsigned char r,unsigned char g);
+void reset_line_status(void);
+void set_drawpage(unsigned char p);
+void set_displaypage(unsigned char p);
+void flip_page(void);
+void set_palette_bank(unsigned char b);
+void use_pcg(unsigned char m);
+void pcg_define(unsigned char n,const uint8_t* p);
+void pcg_reset(void);
+void sprite_define(unsigned char n,unsigned char w,unsigned char h,unsigned char key,unsigned short pattern);
+void sprite_move(unsigned char n,short x,short y);
+void sprite_reset(void);
+void set_tilemode(unsigned char m);
+void set_tilescroll(short x,short y);
+void blit_wait(void);
+void g_copy(int x1,int y1,int w,int h,int x2,int y2);
+void g_fill(int x1,int y1,int x2,int y2,unsigned int c);
+void g_blit(int x,int y,int w,int h,unsigned short a,int key);
+void g_get(int x,int y,int w,int h,unsigned short a);
 
 extern volatile uint16_t drawcount;
 extern uint8_t TVRAM[];
+extern volatile uint16_t tvram_origin;
 extern uint8_t framebuffer[];
+extern uint8_t* gvram;
+extern uint8_t fontram[];
+extern uint8_t pcgram[];
+extern uint8_t* volatile fontp;
+extern uint8_t sprite_pattern[];
+extern uint8_t tile_pattern[];
+extern uint8_t tilemap[];
+extern int16_t line_scroll[];
+extern uint8_t blit_pattern[];
+extern volatile uint32_t line_cycles_max;
+extern volatile uint32_t line_cycles_avg;
+extern volatile uint32_t line_overrun;
 extern const uint8_t FontData[];
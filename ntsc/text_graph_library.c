@@ -20,12 +20,74 @@ caused by using this program.
 
 #include "rp2040_pwm_ntsc_textgraph.h"
 
+// グラフィックページvramのx,yにカラー番号cのドットを書き込む（範囲チェックなし）
+// 4ビットモードでは偶数ドットが下位4ビット、奇数ドットが上位4ビット
+// ドットを書き込むとGVRAM（ポインタ変数）が再読み込みされるため、
+// ループ内ではvramにローカル変数を渡す
+static inline void gvram_put_p(unsigned char *vram,int x,int y,unsigned int c)
+{
+#if GRAPHIC_BPP==4
+	unsigned char *p=vram+y*GRAPHIC_LINE_SIZE+(x>>1);
+	if(x&1) *p=(*p&0x0f)|((c&15)<<4);
+	else *p=(*p&0xf0)|(c&15);
+#else
+	vram[y*FRAME_WIDTH+x]=c;
+#endif
+}
+
+// x,yにカラー番号cのドットを書き込む（範囲チェックなし）
+static inline void gvram_put(int x,int y,unsigned int c)
+{
+	gvram_put_p(GVRAM,x,y,c);
+}
+
 // x,yにカラー番号cのドットを描画
 void g_pset(int x, int y, int c)
 {
 	if((unsigned int)x>=FRAME_WIDTH) return;
 	if((unsigned int)y>=FRAME_HEIGHT) return;
-	GVRAM[y*FRAME_WIDTH+x]=c;
+	gvram_put(x,y,c);
+}
+
+// pからnバイトをd（4バイトとも同じカラー番号）で埋める
+// 先頭と末尾以外は4バイト単位で書き込む
+static inline void g_span(unsigned char *p,int n,unsigned int d)
+{
+	unsigned int *ad;
+	while(((unsigned int)p&3) && n>0){
+		*p++=d;
+		n--;
+	}
+	ad=(unsigned int *)p;
+	while(n>=16){
+		ad[0]=d;
+		ad[1]=d;
+		ad[2]=d;
+		ad[3]=d;
+		ad+=4;
+		n-=16;
+	}
+	while(n>=4){
+		*ad++=d;
+		n-=4;
+	}
+	p=(unsigned char *)ad;
+	while(n-->0) *p++=d;
+}
+
+// (x1,y)-(x2,y)をカラー番号cで塗る（x1<=x2、範囲チェックなし）
+static inline void g_hspan(int x1,int x2,int y,unsigned int c)
+{
+#if GRAPHIC_BPP==4
+	// 半端な両端のドットを書いてから、残りを1バイト2ドットで塗る
+	c&=15;
+	if(x1&1) gvram_put(x1++,y,c);
+	if(!(x2&1)) gvram_put(x2--,y,c);
+	if(x1<x2) g_span(GVRAM+y*GRAPHIC_LINE_SIZE+(x1>>1),(x2-x1+1)>>1,c*0x11111111);
+#else
+	c&=0xff;
+	g_span(GVRAM+y*FRAME_WIDTH+x1,x2-x1+1,c*0x01010101);
+#endif
 }
 
 // 横m*縦nドットのキャラクターを座標x,yに表示
@@ -34,7 +96,6 @@ void g_pset(int x, int y, int c)
 void g_putbmpmn(int x,int y,char m,char n,const unsigned char bmp[])
 {
 	int i,j,k;
-	unsigned char *vp;
 	const unsigned char *p;
 	unsigned short *vph;
 
@@ -52,11 +113,9 @@ void g_putbmpmn(int x,int y,char m,char n,const unsigned char bmp[])
 		if(x<0){ //画面左に切れる場合は残る部分のみ描画
 			j=0;
 			p+=-x;
-			vp=GVRAM+i*X_RES;
 		}
 		else{
 			j=x;
-			vp=GVRAM+i*X_RES+x;
 		}
 		for(;j<x+m;j++){
 			if(j>=X_RES){ //画面右に切れる場合
@@ -64,10 +123,9 @@ void g_putbmpmn(int x,int y,char m,char n,const unsigned char bmp[])
 				break;
 			}
 			if(*p!=0){ //カラー番号が0の場合、透明として処理
-				*vp=*p;
+				gvram_put(j,i,*p);
 			}
 			p++;
-			vp++;
 		}
 	}
 }
@@ -77,7 +135,6 @@ void g_putbmpmn(int x,int y,char m,char n,const unsigned char bmp[])
 void g_clrbmpmn(int x,int y,char m,char n)
 {
 	int i,j,k;
-	unsigned char *vp;
 	unsigned short mask,*vph;
 
 	if(x<=-m || x>=X_RES || y<=-n || y>=Y_RES) return; //画面外
@@ -91,26 +148,27 @@ void g_clrbmpmn(int x,int y,char m,char n)
 		if(i>=Y_RES) return; //画面下部に切れる場合
 		if(x<0){ //画面左に切れる場合は残る部分のみ描画
 			j=0;
-			vp=GVRAM+i*X_RES;
 		}
 		else{
 			j=x;
-			vp=GVRAM+i*X_RES+x;
 		}
 		for(;j<x+m;j++){
 			if(j>=X_RES){ //画面右に切れる場合
 				break;
 			}
-			*vp++=0;
+			gvram_put(j,i,0);
 		}
 	}
 }
 
 // (x1,y1)-(x2,y2)にカラーcで線分を描画
+// 両端が画面内の場合は範囲チェックなしで描画し、
+// ほぼ水平な線（dx>=dy*4）は同じyの連続部分を水平線としてまとめて描画する
 void g_gline(int x1,int y1,int x2,int y2,unsigned int c)
 {
-	int sx,sy,dx,dy,i;
+	int sx,sy,dx,dy,i,n,xs;
 	int e;
+	unsigned char *vram;
 
 	if(x2>x1){
 		dx=x2-x1;
@@ -128,10 +186,58 @@ void g_gline(int x1,int y1,int x2,int y2,unsigned int c)
 		dy=y1-y2;
 		sy=-1;
 	}
+	vram=GVRAM;
+	if((unsigned int)x1<X_RES && (unsigned int)x2<X_RES && (unsigned int)y1<Y_RES && (unsigned int)y2<Y_RES){
+		// 画面内に収まる線
+		if(dx>=dy*4){
+			// 同じyの部分の長さ（eが0以上になるまでのドット数）を
+			// 除算で求め、水平線として描画する
+			e=-dx;
+			i=dx+1; // 残りのドット数
+			while(i>0){
+				n=dy ? (dy*2-1-e)/(dy*2):i;
+				if(n>i) n=i;
+				xs=x1+sx*(n-1);
+				if(sx>0) g_hspan(x1,xs,y1,c);
+				else g_hspan(xs,x1,y1,c);
+				x1=xs+sx;
+				e+=dy*2*n;
+				i-=n;
+				y1+=sy;
+				e-=dx*2;
+			}
+		}
+		else if(dx>=dy){
+			// 短い水平線の連続は1ドットずつ描画した方が速い
+			e=-dx;
+			for(i=0;i<=dx;i++){
+				gvram_put_p(vram,x1,y1,c);
+				x1+=sx;
+				e+=dy*2;
+				if(e>=0){
+					y1+=sy;
+					e-=dx*2;
+				}
+			}
+		}
+		else{
+			e=-dy;
+			for(i=0;i<=dy;i++){
+				gvram_put_p(vram,x1,y1,c);
+				y1+=sy;
+				e+=dx*2;
+				if(e>=0){
+					x1+=sx;
+					e-=dy*2;
+				}
+			}
+		}
+		return;
+	}
 	if(dx>=dy){
 		e=-dx;
 		for(i=0;i<=dx;i++){
-			g_pset(x1,y1,c);
+			if((unsigned int)x1<X_RES && (unsigned int)y1<Y_RES) gvram_put_p(vram,x1,y1,c);
 			x1+=sx;
 			e+=dy*2;
 			if(e>=0){
@@ -143,7 +249,7 @@ void g_gline(int x1,int y1,int x2,int y2,unsigned int c)
 	else{
 		e=-dy;
 		for(i=0;i<=dy;i++){
-			g_pset(x1,y1,c);
+			if((unsigned int)x1<X_RES && (unsigned int)y1<Y_RES) gvram_put_p(vram,x1,y1,c);
 			y1+=sy;
 			e+=dx*2;
 			if(e>=0){
@@ -183,8 +289,6 @@ void g_circle(int x0,int y0,unsigned int r,unsigned int c)
 void g_hline(int x1,int x2,int y,unsigned int c)
 {
 	int temp;
-	unsigned int d,*ad;
-	unsigned short dh,*adh;
 
 	if(y<0 || y>=Y_RES) return;
 	if(x1>x2){
@@ -195,17 +299,7 @@ void g_hline(int x1,int x2,int y,unsigned int c)
 	if(x2<0 || x1>=X_RES) return;
 	if(x1<0) x1=0;
 	if(x2>=X_RES) x2=X_RES-1;
-	while(x1&3){
-		g_pset(x1++,y,c);
-		if(x1>x2) return;
-	}
-	d=c|(c<<8)|(c<<16)|(c<<24);
-	ad=(unsigned int *)(GVRAM+y*X_RES+x1);
-	while(x1+3<=x2){
-		*ad++=d;
-		x1+=4;
-	}
-	while(x1<=x2) g_pset(x1++,y,c);
+	g_hspan(x1,x2,y,c);
 }
 
 // (x1,y1),(x2,y2)を対角線とするカラーcで塗られた長方形を描画
@@ -227,29 +321,38 @@ void g_boxfill(int x1,int y1,int x2,int y2,unsigned int c)
 	if(y2<0 || y1>=Y_RES) return;
 	if(y1<0) y1=0;
 	if(y2>=Y_RES) y2=Y_RES-1;
+	if(x1<0) x1=0;
+	if(x2>=X_RES) x2=X_RES-1;
+	// 範囲チェックは最初の1回のみ
 	while(y1<=y2){
-		g_hline(x1,x2,y1++,c);
+		g_hspan(x1,x2,y1,c);
+		y1++;
 	}
 }
 
 // (x0,y0)を中心に、半径r、カラーcで塗られた円を描画
+// 同じ行を何度も描画しないよう、各行は最も長い水平線のみ描画する
 void g_circlefill(int x0,int y0,unsigned int r,unsigned int c)
 {
-	int x,y,f;
+	int x,y,f,xo;
 	x=r;
 	y=0;
 	f=-2*r+3;
 	while(x>=y){
-		g_hline(x0-x,x0+x,y0-y,c);
 		g_hline(x0-x,x0+x,y0+y,c);
-		g_hline(x0-y,x0+y,y0-x,c);
-		g_hline(x0-y,x0+y,y0+x,c);
+		if(y) g_hline(x0-x,x0+x,y0-y,c);
+		xo=x;
 		if(f>=0){
 			x--;
 			f-=x*4;
 		}
 		y++;
 		f+=y*4+2;
+		// 行y0±xoの幅が確定した（xが変わるか最後）場合に描画
+		if((x!=xo || x<y) && xo!=y-1){
+			g_hline(x0-(y-1),x0+(y-1),y0-xo,c);
+			g_hline(x0-(y-1),x0+(y-1),y0+xo,c);
+		}
 	}
 }
 
@@ -265,7 +368,7 @@ void g_putfont(int x,int y,unsigned int c,int bc,unsigned char n)
 	unsigned int d1,mask;
 	unsigned short *ad;
 
-	p=FontData+n*8;
+	p=fontp+n*8;
 	for(i=0;i<8;i++){
 		d=*p++;
 		for(j=0;j<8;j++){
@@ -325,26 +428,77 @@ unsigned int g_color(int x,int y){
 
 	if((unsigned int)x>=(unsigned int)X_RES) return 0;
 	if((unsigned int)y>=(unsigned int)Y_RES) return 0;
+#if GRAPHIC_BPP==4
+	return (GVRAM[y*GRAPHIC_LINE_SIZE+(x>>1)]>>((x&1)*4))&15;
+#else
 	return *(GVRAM+y*X_RES+x);
+#endif
 }
 
+// cursorは画面上の位置（TVRAM+y*WIDTH_X+x）を示す
+// TVRAMは行単位のリングバッファなので、実際の書き込み先はtvram_cell()で求める
 unsigned char *cursor=TVRAM;
 unsigned char cursorcolor=7;
 
-void vramscroll(void){
-	unsigned char *p1,*p2,*vramend;
+//画面上の位置a（0～ATTROFFSET*2-1、ATTROFFSET以降はカラー）のTVRAM内のアドレスを返す
+unsigned char* tvram_cell(unsigned int a){
+	unsigned int attr=0;
+	if(a>=ATTROFFSET){
+		a-=ATTROFFSET;
+		attr=ATTROFFSET;
+	}
+	a+=tvram_origin;
+	if(a>=ATTROFFSET) a-=ATTROFFSET;
+	return TVRAM+a+attr;
+}
 
-	vramend=TVRAM+WIDTH_X*WIDTH_Y;
-	p1=TVRAM;
-	p2=p1+WIDTH_X;
-	while(p2<vramend){
-		*(p1+ATTROFFSET)=*(p2+ATTROFFSET);
-		*p1++=*p2++;
+//画面上のy行目を0でクリア
+static void clearline(int y){
+	unsigned char *p;
+	int i;
+	p=tvram_cell(y*WIDTH_X);
+	for(i=0;i<WIDTH_X;i++){
+		*(p+ATTROFFSET)=0;
+		*p++=0;
 	}
-	while(p1<vramend){
-		*(p1+ATTROFFSET)=0;
-		*p1++=0;
+}
+
+//1行スクロール
+//先頭行をクリアしてから最終行とする（tvram_originを1行進める）
+void vramscroll(void){
+	clearline(0);
+	if(tvram_origin+WIDTH_X<ATTROFFSET) tvram_origin+=WIDTH_X;
+	else tvram_origin=0;
+}
+
+//1行逆スクロール
+//最終行を先頭行とし（tvram_originを1行戻す）、クリアする
+void vramscrolldown(void){
+	if(tvram_origin) tvram_origin-=WIDTH_X;
+	else tvram_origin=ATTROFFSET-WIDTH_X;
+	clearline(0);
+}
+
+//行y1からy2の間を1行スクロール
+void windowscroll(int y1,int y2){
+	unsigned char *p1,*p2;
+	int i;
+
+	if(y1<0 || y2>=WIDTH_Y || y1>y2) return;
+	if(y1==0 && y2==WIDTH_Y-1){
+		vramscroll();
+		return;
+	}
+	//各行はTVRAM内で連続しているので行単位でコピー
+	for(;y1<y2;y1++){
+		p1=tvram_cell(y1*WIDTH_X);
+		p2=tvram_cell((y1+1)*WIDTH_X);
+		for(i=0;i<WIDTH_X;i++){
+			*(p1+ATTROFFSET)=*(p2+ATTROFFSET);
+			*p1++=*p2++;
+		}
 	}
+	clearline(y2);
 }
 
 //カーソルを座標(x,y)にカラー番号cに設定
@@ -374,8 +528,9 @@ void printchar(unsigned char n){
 		//BS
 		if (TVRAM<cursor) cursor--;
 	} else{
-		*cursor=n;
-		*(cursor+ATTROFFSET)=cursorcolor;
+		unsigned char *p=tvram_cell(cursor-TVRAM);
+		*p=n;
+		*(p+ATTROFFSET)=cursorcolor;
 		cursor++;
 	}
 }
@@ -21,6 +21,10 @@ void printstr(unsigned char *s);
 void printnum(unsigned int n);
 void printnum2(unsigned int n,unsigned char e);
 void cls(void);
+void vramscroll(void);
+void vramscrolldown(void);
+void windowscroll(int y1,int y2);
+unsigned char* tvram_cell(unsigned int a);
 
 extern const unsigned char FontData[];
 extern uint8_t *cursor;